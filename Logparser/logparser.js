@@ -324,6 +324,10 @@ var match = [
 	{ re: "!TSF:RTE:N2N FAIL", d: "Direct node-to-node communication failed - handing over to parent" },
 	{ re: "TSF:RRT:ROUTE N=(\\d+),R=(\\d+)", d: "Routing table, messages to node (<b>$1</b>) are routed via node (<b>$2</b>)"},
 	{ re: "!TSF:SND:TNR", d: "Transport not ready, message cannot be sent" },
+	{ re: "TSF:TXQ:ADD,TO=(\\d+),N=(\\d+)", d: "Message to node <b>$1</b> queued, <b>$2</b> messages queued" },
+	{ re: "!TSF:TXQ:FULL,TO=(\\d+)", d: "TX queue full, message to node <b>$1</b> dropped" },
+	{ re: "!TSF:TXQ:RETRY,TO=(\\d+),A=(\\d+)", d: "Sending to node <b>$1</b> failed, attempt <b>$2</b> is retried later" },
+	{ re: "!TSF:TXQ:DROP,TO=(\\d+)", d: "Sending to node <b>$1</b> failed too often, message dropped" },
 	{ re: "TSF:TDI:TSL", d: "Set transport to sleep" },
 	{ re: "TSF:TDI:TPD", d: "Power down transport" },
 	{ re: "TSF:TRI:TRI", d: "Reinitialise transport" },
@@ -464,6 +468,68 @@ for (var i=0, len=match.length;i<len; i++) {
 }
 var stripPrefix = new RegExp("^" + rprefix + "(.*)");
 
+// Structured debug events (MY_DEBUG_EVENTS), ~ID:ARGUMENTS is turned back into the text line
+var payloadString = function(pt, bytes) {
+	var view = new DataView(new Uint8Array(bytes).buffer);
+	switch (pt) {
+		case 0: return String.fromCharCode.apply(null, bytes);
+		case 1: return bytes.length < 1 ? "" : "" + view.getUint8(0);
+		case 2: return bytes.length < 2 ? "" : "" + view.getInt16(0, true);
+		case 3: return bytes.length < 2 ? "" : "" + view.getUint16(0, true);
+		case 4: return bytes.length < 4 ? "" : "" + view.getInt32(0, true);
+		case 5: return bytes.length < 4 ? "" : "" + view.getUint32(0, true);
+		case 7: return bytes.length < 4 ? "" : view.getFloat32(0, true).toFixed(Math.min(bytes.length > 4 ? bytes[4] : 2, 8));
+		default: return _.map(bytes, function(b) { return ("0" + b.toString(16).toUpperCase()).slice(-2); }).join("");
+	}
+};
+var isNonce = function(command, type) {
+	return command == 3 && type == 17;
+};
+var events = {
+	0x01: function(a) {
+		return "TSF:MSG:READ," + a[0] + "-" + a[1] + "-" + a[2] + ",s=" + a[3] + ",c=" + a[4] + ",t=" + a[5] +
+			",pt=" + a[6] + ",l=" + a[7] + ",sg=" + a[8] + ":" + (isNonce(a[4], a[5]) ? "<NONCE>" : payloadString(a[6], a.slice(9)));
+	},
+	0x02: function(a) {
+		return (a[0] & 2 ? "?" : a[0] & 1 ? "!" : "") + "TSF:MSG:SEND," + a[1] + "-" + a[2] + "-" + a[3] + "-" + a[4] +
+			",s=" + a[5] + ",c=" + a[6] + ",t=" + a[7] + ",pt=" + a[8] + ",l=" + a[9] + ",sg=" + a[10] + ",ft=" + a[11] +
+			",st=" + (a[0] & 1 ? "NACK" : "OK") + ":" + (isNonce(a[6], a[7]) ? "<NONCE>" : payloadString(a[8], a.slice(12)));
+	},
+	0x03: function(a) { return "TSF:MSG:ECHO REQ"; },
+	0x04: function(a) { return "TSF:MSG:ECHO"; },
+	0x05: function(a) { return "TSF:MSG:BC"; },
+	0x06: function(a) { return "TSF:MSG:RCV CB"; },
+	0x07: function(a) { return "TSF:MSG:REL MSG"; },
+	0x40: function(a) {
+		return "GWT:RFC:" + (a[0] == 255 ? "" : "C=" + a[0] + ",") + "MSG=" + a[1] + ";" + a[2] + ";" + a[3] + ";" + a[4] +
+			";" + a[5] + ";" + payloadString(a[6], a.slice(8));
+	},
+	0x41: function(a) { return "GWT:TPS:TOPIC=" + payloadString(0, a) + ",MSG SENT"; },
+	0x42: function(a) { return "GWT:IMQ:TOPIC=" + payloadString(0, a) + ", MSG RECEIVED"; },
+	0x80: function(a) { return "SGN:SGN:NCE REQ,TO=" + a[0]; },
+	0x81: function(a) { return "SGN:SGN:SGN"; },
+	0x82: function(a) { return "SGN:SGN:NREQ=" + a[0]; },
+	0x83: function(a) { return "SGN:SGN:" + a[0] + "!=" + a[1] + " NUS"; },
+	0x84: function(a) { return "SGN:VER:OK"; },
+	0x85: function(a) { return "SGN:SKP:" + (a[0] ? "ECHO" : "MSG") + " CMD=" + a[1] + ",TYPE=" + a[2]; },
+	0x86: function(a) { return "SGN:NCE:LEFT=" + a[0]; },
+	0x87: function(a) { return "SGN:NCE:XMT,TO=" + a[0]; },
+	0x88: function(a) { return "SGN:NCE:FROM=" + a[0]; }
+};
+var eventRe = new RegExp("^(" + rprefix + ")~([0-9A-F]{2}):([0-9A-F]*)");
+var decodeEvent = function(line) {
+	var m = eventRe.exec(line);
+	var decode = m ? events[parseInt(m[2], 16)] : undefined;
+	if (!decode) {
+		return line;
+	}
+	var args = [];
+	for (var i = 0; i + 1 < m[3].length; i += 2) {
+		args.push(parseInt(m[3].substr(i, 2), 16));
+	}
+	return m[1] + decode(args);
+};
+
 function getQueryVariable(variable)
 {
 	var query = window.location.search.substring(1);
@@ -541,6 +607,7 @@ new Vue({
 		match: function(msg) {
 			var self = this;
 			var found = false;
+			msg = decodeEvent(msg);
 			for (var i=0, len=match.length;!found &&  i<len; i++) {
 				var r = match[i];
 				if (r.re.test(msg)) {
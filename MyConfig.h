@@ -133,6 +133,25 @@
  */
 //#define MY_SPECIAL_DEBUG
 
+/**
+ * @def MY_DEBUG_EVENTS
+ * @brief Define MY_DEBUG_EVENTS to print the per-message debug lines as compact events.
+ *
+ * Instead of a formatted text line, the node prints an event ID and the arguments in hex, which
+ * saves flash and UART time. The Logparser decodes the events, see @ref MyDebugEventsgrp.
+ */
+//#define MY_DEBUG_EVENTS
+
+/**
+ * @def MY_DEBUG_EVENTS_FILTER
+ * @brief Bitmask of the subsystems (see @ref debugSubsystem_t) that print events.
+ *
+ * Events of other subsystems are removed at compile time.
+ */
+#ifndef MY_DEBUG_EVENTS_FILTER
+#define MY_DEBUG_EVENTS_FILTER (0xFFu)
+#endif
+
 /**
  * @def MY_DISABLED_SERIAL
  * @brief Define MY_DISABLED_SERIAL if you want to use the UART TX/RX pins as normal I/O pins.
@@ -262,6 +281,76 @@
  * Example: @code #define MY_RS485_HWSERIAL Serial1 @endcode
  */
 //#define MY_RS485_HWSERIAL (Serial1)
+
+/**
+ * @def MY_RS485_ACK
+ * @brief Define this to acknowledge unicast frames with an ACK frame.
+ *
+ * The sender of a frame waits @ref MY_RS485_ACK_TIMEOUT_US for the ACK and sends the frame again
+ * up to @ref MY_RS485_ACK_RETRIES times, transportSend() reports whether the frame was
+ * acknowledged. All nodes and the gateway on the bus must have this enabled.
+ */
+//#define MY_RS485_ACK
+
+/**
+ * @def MY_RS485_ACK_RETRIES
+ * @brief Number of times an unacknowledged frame is sent again.
+ *
+ * On Linux the retries are accounted per destination: after a destination missed all ACKs, the
+ * next frames to it are only sent once until it acknowledges again, a powered down node then no
+ * longer takes bus time from the others.
+ */
+#ifndef MY_RS485_ACK_RETRIES
+#define MY_RS485_ACK_RETRIES (3u)
+#endif
+
+/**
+ * @def MY_RS485_ACK_TIMEOUT_US
+ * @brief Time to wait for an ACK after the end of a frame, in microseconds.
+ *
+ * The default is the transmission time of an ACK frame (10 bits per byte) plus 2 ms for the
+ * receiver to turn around.
+ */
+#ifndef MY_RS485_ACK_TIMEOUT_US
+#define MY_RS485_ACK_TIMEOUT_US ((MY_RS485_SOH_COUNT + 12ul) * 10000000ul / MY_RS485_BAUD_RATE + 2000ul)
+#endif
+
+/**
+ * @def MY_RS485_TDMA_SLOTS
+ * @brief Define this to schedule the bus in time slots instead of waiting for it to be idle.
+ *
+ * The gateway broadcasts a beacon frame every @ref MY_RS485_TDMA_SLOTS * @ref MY_RS485_TDMA_SLOT_US,
+ * each beacon starts a cycle of @ref MY_RS485_TDMA_SLOTS slots. The gateway gets
+ * @ref MY_RS485_TDMA_GATEWAY_SLOTS of them, spread evenly over the cycle starting with slot 0, and
+ * node N the ((N - 1) % (@ref MY_RS485_TDMA_SLOTS - @ref MY_RS485_TDMA_GATEWAY_SLOTS))th of the
+ * others. With node IDs up to the number of node slots there are no collisions, the share of each
+ * node and the delay of a frame are then bounded by the cycle time. A node that does not receive beacons, e.g. before it has an ID, falls back to
+ * waiting for an idle bus. All nodes and the gateway on the bus must use the same settings.
+ *
+ * Example: @code #define MY_RS485_TDMA_SLOTS (32) @endcode
+ */
+//#define MY_RS485_TDMA_SLOTS (32)
+
+/**
+ * @def MY_RS485_TDMA_SLOT_US
+ * @brief Length of a TDMA slot in microseconds.
+ *
+ * The default fits a frame with the largest message and its ACK.
+ */
+#ifndef MY_RS485_TDMA_SLOT_US
+#define MY_RS485_TDMA_SLOT_US ((MY_RS485_SOH_COUNT + 44ul) * 10000000ul / MY_RS485_BAUD_RATE + MY_RS485_ACK_TIMEOUT_US)
+#endif
+
+/**
+ * @def MY_RS485_TDMA_GATEWAY_SLOTS
+ * @brief Number of TDMA slots per cycle for the gateway.
+ *
+ * The gateway talks to all nodes, by default it gets a quarter of the slots. A message from the
+ * controller then waits at most a few slots instead of a whole cycle.
+ */
+#ifndef MY_RS485_TDMA_GATEWAY_SLOTS
+#define MY_RS485_TDMA_GATEWAY_SLOTS ((MY_RS485_TDMA_SLOTS) < 8 ? 1u : (MY_RS485_TDMA_SLOTS) / 4u)
+#endif
 /** @}*/ // End of RS485SettingGrpPub group
 
 /**
@@ -800,6 +889,22 @@
  */
 //#define MY_RFM69_MODEM_CONFIGURATION (RFM69_FSK_BR55_5_FD50)
 
+/**
+ * @def MY_RFM69_RX_BUFFER_SIZE
+ * @brief Number of received packets the new %RFM69 driver queues until the node reads them.
+ *
+ * Packets that arrive while the queue is full, e.g. while the node waits for an ACK of its own
+ * message, are dropped and counted. Each slot takes 66 bytes of RAM. On Linux the queue is
+ * filled by the interrupt thread.
+ * @see MY_RFM69_NEW_DRIVER
+ */
+#ifndef MY_RFM69_RX_BUFFER_SIZE
+#if defined(__linux__)
+#define MY_RFM69_RX_BUFFER_SIZE (16u)
+#else
+#define MY_RFM69_RX_BUFFER_SIZE (1u)
+#endif
+#endif
 
 /** @}*/ // End of RFM69SettingGrpPub group
 
@@ -963,6 +1068,22 @@
  * This allows for better stability using SF 9 to 12.
  */
 //#define MY_RFM95_TCXO
+
+/**
+ * @def MY_RFM95_RX_BUFFER_SIZE
+ * @brief Number of received packets the RFM95 driver queues until the node reads them.
+ *
+ * Packets that arrive while the queue is full, e.g. while the node waits for an ACK of its own
+ * message, are dropped and counted. Each slot takes 67 bytes of RAM. On Linux the queue is
+ * filled by the interrupt thread.
+ */
+#ifndef MY_RFM95_RX_BUFFER_SIZE
+#if defined(__linux__)
+#define MY_RFM95_RX_BUFFER_SIZE (16u)
+#else
+#define MY_RFM95_RX_BUFFER_SIZE (1u)
+#endif
+#endif
 /** @}*/ // End of RFM95SettingGrpPub group
 
 /**
@@ -1009,6 +1130,32 @@
 #endif
 /** @}*/ // End of SoftSpiSettingGrpPub group
 
+/**
+ * @defgroup LoopbackSettingGrpPub Loopback
+ * @ingroup TransportSettingGrpPub
+ * @brief These options are specific to the in-memory loopback transport (Linux only).
+ * @{
+ */
+
+/**
+ * @def MY_RADIO_LOOPBACK
+ * @brief Define this to use an in-memory transport instead of a radio.
+ *
+ * Frames are injected with transportLoopbackInject(), frames sent by the node are passed to the
+ * handler set with transportLoopbackSetSendHandler(). Used by the gateway benchmark,
+ * examples_linux/mysgwbench.cpp.
+ */
+//#define MY_RADIO_LOOPBACK
+
+/**
+ * @def MY_LOOPBACK_QUEUE_SIZE
+ * @brief Number of injected frames waiting for the node (max 255), further frames are dropped.
+ */
+#ifndef MY_LOOPBACK_QUEUE_SIZE
+#define MY_LOOPBACK_QUEUE_SIZE (128u)
+#endif
+/** @}*/ // End of LoopbackSettingGrpPub group
+
 /** @}*/ // End of TransportSettingGrpPub group
 
 /**
@@ -1127,6 +1274,64 @@
 #define MY_TRANSPORT_WAIT_READY_MS (0)
 #endif
 
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_FEATURE
+ * @brief Queue messages from the controller and send them from transportProcess().
+ *
+ * Each pass sends at most one queued message. Messages to the same node keep their order. The
+ * driver transmits a queued message only once, without its own retries, and a failed send is
+ * retried later by the queue with a growing back-off instead of blocking the loop, so a slow or
+ * dead node no longer holds up traffic to the other nodes. A pass still waits for the ACK of its
+ * one transmission, which takes up to the ACK timeout of the radio for a dead node. Enabled by
+ * default on Linux gateways, define @ref MY_TRANSPORT_TX_QUEUE_DISABLED to send synchronously
+ * instead.
+ */
+//#define MY_TRANSPORT_TX_QUEUE_FEATURE
+
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_DISABLED
+ * @brief Define to turn off the default @ref MY_TRANSPORT_TX_QUEUE_FEATURE on Linux gateways.
+ */
+//#define MY_TRANSPORT_TX_QUEUE_DISABLED
+#if defined(__linux__) && (defined(MY_GATEWAY_LINUX) || defined(MY_GATEWAY_SERIAL)) && !defined(MY_TRANSPORT_TX_QUEUE_DISABLED) && !defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+#define MY_TRANSPORT_TX_QUEUE_FEATURE
+#endif
+
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_SIZE
+ * @brief Number of messages the TX queue holds for all nodes together.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_SIZE
+#define MY_TRANSPORT_TX_QUEUE_SIZE (32u)
+#endif
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_PER_NODE
+ * @brief Maximum number of queued messages for a single destination.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_PER_NODE
+#define MY_TRANSPORT_TX_QUEUE_PER_NODE (8u)
+#endif
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_RETRIES
+ * @brief Number of times a queued message is retried before it is dropped.
+ *
+ * These retries replace the ones of the radio driver (the hardware retransmissions of RF24 and
+ * nRF5 ESB, the resends of RFM69, RFM95 and @ref MY_RS485_ACK), which are turned off for queued
+ * messages. Each retry is a single transmission in a later pass.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_RETRIES
+#define MY_TRANSPORT_TX_QUEUE_RETRIES (5u)
+#endif
+/**
+ * @def MY_TRANSPORT_TX_QUEUE_BACKOFF_MS
+ * @brief Delay (in ms) before the first retry of a queued message, doubled for every further retry.
+ */
+#ifndef MY_TRANSPORT_TX_QUEUE_BACKOFF_MS
+#define MY_TRANSPORT_TX_QUEUE_BACKOFF_MS (100ul)
+#endif
+#endif
+
 /**
 * @def MY_SIGNAL_REPORT_ENABLED
 * @brief Enables signal report functionality.
@@ -1551,6 +1756,141 @@
  */
 //#define MY_MQTT_CLIENT_KEY
 
+/**
+ * @def MY_MQTT_CLIENT_ASYNC_FEATURE
+ * @brief Connect to the MQTT broker without blocking the main loop.
+ *
+ * The broker connection is set up by a state machine driven from gatewayTransportAvailable(),
+ * failed attempts are retried with a growing back-off, and incoming packets are read as they
+ * arrive, so the sensor network is serviced while the broker is unreachable. Messages sent in
+ * the meantime wait in a queue of @ref MY_MQTT_CLIENT_QUEUE_SIZE messages, which is kept across
+ * reconnects and published once the broker is back. Linux only, enabled by default there;
+ * define @ref MY_MQTT_CLIENT_ASYNC_DISABLED to use the blocking client instead.
+ * @see MY_MQTT_SECONDARY_IP_ADDRESS
+ */
+//#define MY_MQTT_CLIENT_ASYNC_FEATURE
+
+/**
+ * @def MY_MQTT_CLIENT_ASYNC_DISABLED
+ * @brief Define to turn off the default @ref MY_MQTT_CLIENT_ASYNC_FEATURE on Linux.
+ */
+//#define MY_MQTT_CLIENT_ASYNC_DISABLED
+#if defined(MY_GATEWAY_LINUX) && defined(MY_GATEWAY_MQTT_CLIENT) && !defined(MY_MQTT_CLIENT_ASYNC_DISABLED) && !defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+#define MY_MQTT_CLIENT_ASYNC_FEATURE
+#endif
+
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+/**
+ * @def MY_MQTT_CLIENT_QUEUE_SIZE
+ * @brief Number of messages held while the broker is unreachable, the oldest is dropped when full.
+ *
+ * 1 to 255 messages.
+ */
+#ifndef MY_MQTT_CLIENT_QUEUE_SIZE
+#define MY_MQTT_CLIENT_QUEUE_SIZE (64u)
+#endif
+/**
+ * @def MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS
+ * @brief Time (in ms) a connection attempt may take, including the broker's CONNACK.
+ */
+#ifndef MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS
+#define MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS (5000ul)
+#endif
+/**
+ * @def MY_MQTT_CLIENT_RECONNECT_MS
+ * @brief Delay (in ms) after a failed connection attempt, doubled for every further failure.
+ */
+#ifndef MY_MQTT_CLIENT_RECONNECT_MS
+#define MY_MQTT_CLIENT_RECONNECT_MS (1000ul)
+#endif
+/**
+ * @def MY_MQTT_CLIENT_RECONNECT_MAX_MS
+ * @brief Upper limit (in ms) of the reconnect back-off.
+ */
+#ifndef MY_MQTT_CLIENT_RECONNECT_MAX_MS
+#define MY_MQTT_CLIENT_RECONNECT_MAX_MS (60000ul)
+#endif
+/**
+ * @def MY_MQTT_CLIENT_INFLIGHT_WINDOW
+ * @brief Number of QoS 1 messages published without waiting for their PUBACK.
+ *
+ * At least 1, at most @ref MY_MQTT_CLIENT_QUEUE_SIZE.
+ */
+#ifndef MY_MQTT_CLIENT_INFLIGHT_WINDOW
+#define MY_MQTT_CLIENT_INFLIGHT_WINDOW (16u)
+#endif
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_PUBLISH_QOS
+ * @brief QoS level (0 or 1) of published messages.
+ *
+ * With QoS 1 a message stays in the queue until the broker acknowledges it and is published
+ * again after a reconnect, up to @ref MY_MQTT_CLIENT_INFLIGHT_WINDOW messages are in flight.
+ * Defaults to 1 with @ref MY_MQTT_CLIENT_ASYNC_FEATURE, which QoS 1 requires, 0 otherwise.
+ */
+#ifndef MY_MQTT_CLIENT_PUBLISH_QOS
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+#define MY_MQTT_CLIENT_PUBLISH_QOS (1u)
+#else
+#define MY_MQTT_CLIENT_PUBLISH_QOS (0u)
+#endif
+#endif
+
+/**
+ * @def MY_MQTT_CLIENT_TOPIC_CACHE_SIZE
+ * @brief Number of cached publish topics (power of two), 0 formats every topic.
+ *
+ * The topic levels of a node/sensor/command/type combination are formatted once and then
+ * copied from a direct-mapped cache of 24 byte entries.
+ */
+#ifndef MY_MQTT_CLIENT_TOPIC_CACHE_SIZE
+#if defined(MY_GATEWAY_LINUX)
+#define MY_MQTT_CLIENT_TOPIC_CACHE_SIZE (256u)
+#else
+#define MY_MQTT_CLIENT_TOPIC_CACHE_SIZE (0u)
+#endif
+#endif
+
+/**
+ * @def MY_MQTT_MAX_PACKET_SIZE
+ * @brief Size (in bytes) of the MQTT packet buffers, limits topic and payload length.
+ */
+#ifndef MY_MQTT_MAX_PACKET_SIZE
+#if defined(MY_GATEWAY_LINUX)
+#define MY_MQTT_MAX_PACKET_SIZE (512u)
+#else
+#define MY_MQTT_MAX_PACKET_SIZE (128u)
+#endif
+#endif
+
+/**
+ * @def MY_MQTT_SECONDARY_IP_ADDRESS
+ * @brief IP address of a secondary MQTT broker, used while the primary one is unreachable.
+ *
+ * Connection attempts alternate between both brokers, the gateway stays with the one it is
+ * connected to. Requires @ref MY_MQTT_CLIENT_ASYNC_FEATURE.
+ * Example: @code #define MY_MQTT_SECONDARY_IP_ADDRESS 192,168,178,254 @endcode
+ * @see MY_MQTT_SECONDARY_URL_ADDRESS
+ */
+//#define MY_MQTT_SECONDARY_IP_ADDRESS 192,168,178,254
+
+/**
+ * @def MY_MQTT_SECONDARY_URL_ADDRESS
+ * @brief URL of a secondary MQTT broker, see @ref MY_MQTT_SECONDARY_IP_ADDRESS.
+ *
+ * Example: @code #define MY_MQTT_SECONDARY_URL_ADDRESS "backup.broker.local" @endcode
+ */
+//#define MY_MQTT_SECONDARY_URL_ADDRESS "backup.broker.local"
+
+/**
+ * @def MY_MQTT_SECONDARY_PORT
+ * @brief Port of the secondary MQTT broker, defaults to @ref MY_PORT.
+ */
+#if !defined(MY_MQTT_SECONDARY_PORT)
+#define MY_MQTT_SECONDARY_PORT MY_PORT
+#endif
+
 /**
  * @def MY_IP_ADDRESS
  * @brief Static ip address of gateway. If not defined, DHCP will be used.
@@ -1889,6 +2229,10 @@
  *
  * It is legal to only have one node with a whitelist for this reason but it is not required.
  *
+ * On Linux the list can be extended at runtime: the gateway reads the file given by the
+ * soft_whitelist_file option of the configuration file, one "<node id> <soft_serial_key>" per
+ * line, and reloads it on SIGHUP.
+ *
  * Example: @code #define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}} @endcode
  */
 //#define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}}
@@ -2151,6 +2495,44 @@
 #ifndef MY_LINUX_CONFIG_FILE
 #define MY_LINUX_CONFIG_FILE "/etc/mysensors.conf"
 #endif
+
+/**
+ * @def MY_LINUX_EVENT_LOOP_TIMEOUT_MS
+ * @brief Maximum time (in ms) the main loop sleeps when there is nothing to do.
+ *
+ * The gateway wakes up immediately on controller, serial or radio interrupt activity.
+ * This timeout only bounds the latency of work that is polled, e.g. an RF24 radio
+ * without @ref MY_RF24_IRQ_PIN.
+ */
+#ifndef MY_LINUX_EVENT_LOOP_TIMEOUT_MS
+#if defined(MY_RADIO_RF24) && !defined(MY_RF24_IRQ_PIN)
+#define MY_LINUX_EVENT_LOOP_TIMEOUT_MS (10ul)
+#else
+#define MY_LINUX_EVENT_LOOP_TIMEOUT_MS (100ul)
+#endif
+#endif
+
+/**
+ * @def MY_LINUX_GATEWAY_FLUSH_DEADLINE_MS
+ * @brief Maximum time (in ms) the ethernet gateway holds back output to controllers.
+ *
+ * Messages sent to the controllers are collected and written with a single system call
+ * per client. With the default of 0 the batch is sent at the end of the current loop
+ * pass, a larger value also coalesces bursts spread over several passes.
+ */
+#ifndef MY_LINUX_GATEWAY_FLUSH_DEADLINE_MS
+#define MY_LINUX_GATEWAY_FLUSH_DEADLINE_MS (0ul)
+#endif
+
+/**
+ * @def MY_LINUX_CRYPTO_ARMV8
+ * @brief Use the ARMv8 cryptography extensions for SHA-256 and AES-128, if the CPU has them.
+ *
+ * x86 gateways use SHA-NI and AES-NI automatically. The ARMv8 code is opt-in until it has
+ * been verified on more boards: build with it and run @verbatim make check @endverbatim on
+ * the gateway, the known answer tests print which implementation was tested.
+ */
+//#define MY_LINUX_CRYPTO_ARMV8
 /** @}*/ // End of LinuxSettingGrpPub group
 /** @}*/ // End of PlatformSettingGrpPub group
 
@@ -2222,7 +2604,7 @@
 #endif
 
 // Enable sensor network "feature" if one of the transport types was enabled
-#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_RADIO_LOOPBACK)
 #define MY_SENSOR_NETWORK
 #endif
 
@@ -2300,6 +2682,7 @@
 #define MY_LINUX_SERIAL_GROUPNAME
 #define MY_LINUX_SERIAL_PTY
 #define MY_LINUX_IS_SERIAL_PTY
+#define MY_LINUX_CRYPTO_ARMV8
 // inclusion mode
 #define MY_INCLUSION_MODE_FEATURE
 #define MY_INCLUSION_BUTTON_FEATURE
@@ -2311,6 +2694,9 @@
 #define MY_REGISTRATION_CONTROLLER
 #define MY_TRANSPORT_UPLINK_CHECK_DISABLED
 #define MY_TRANSPORT_SANITY_CHECK
+#define MY_DEBUG_EVENTS
+#define MY_TRANSPORT_TX_QUEUE_FEATURE
+#define MY_TRANSPORT_TX_QUEUE_DISABLED
 #define MY_NODE_LOCK_FEATURE
 #define MY_REPEATER_FEATURE
 #define MY_PASSIVE_NODE
@@ -2323,6 +2709,10 @@
 #define MY_MQTT_CA_CERT
 #define MY_MQTT_CLIENT_CERT
 #define MY_MQTT_CLIENT_KEY
+#define MY_MQTT_CLIENT_ASYNC_FEATURE
+#define MY_MQTT_CLIENT_ASYNC_DISABLED
+#define MY_MQTT_SECONDARY_IP_ADDRESS
+#define MY_MQTT_SECONDARY_URL_ADDRESS
 #define MY_SIGNAL_REPORT_ENABLED
 // general
 #define MY_WITH_LEDS_BLINKING_INVERSE
@@ -2382,11 +2772,15 @@
 // FOTA update
 #define MY_DEBUG_VERBOSE_OTA_UPDATE
 #define MY_OTA_USE_I2C_EEPROM
+// Loopback
+#define MY_RADIO_LOOPBACK
 // RS485
 #define MY_RS485
 #define MY_RS485_DE_PIN
 #define MY_RS485_DE_INVERSE
 #define MY_RS485_HWSERIAL
+#define MY_RS485_ACK
+#define MY_RS485_TDMA_SLOTS
 // RF24
 #define MY_RADIO_RF24
 #define MY_RADIO_NRF24 //deprecated
@@ -2412,6 +2806,7 @@
 #define MY_RFM69_ATC_MODE_DISABLED
 #define MY_RFM69_MAX_POWER_LEVEL_DBM
 #define MY_RFM69_RST_PIN
+#define MY_RFM69_RX_BUFFER_SIZE
 #define MY_DEBUG_VERBOSE_RFM69
 #define MY_DEBUG_VERBOSE_RFM69_REGISTERS
 // RFM95
@@ -2423,6 +2818,7 @@
 #define MY_RFM95_MODEM_CONFIGRUATION
 #define MY_RFM95_POWER_PIN
 #define MY_RFM95_TCXO
+#define MY_RFM95_RX_BUFFER_SIZE
 #define MY_RFM95_MAX_POWER_LEVEL_DBM
 // SOFT-SPI
 #define MY_SOFTSPI
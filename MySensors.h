@@ -54,6 +54,9 @@
 // HARDWARE
 #include "hal/architecture/MyHwHAL.h"
 #include "hal/crypto/MyCryptoHAL.h"
+#if defined(MY_DEBUG_EVENTS) && defined(DEBUG_OUTPUT_ENABLED)
+#include "core/MyDebugEvents.h"
+#endif
 #if defined(ARDUINO_ARCH_ESP8266)
 #include "hal/architecture/ESP8266/MyHwESP8266.cpp"
 #include "hal/crypto/generic/MyCryptoGeneric.cpp"
@@ -217,6 +220,12 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #include "hal/architecture/Linux/drivers/core/EthernetServer.h"
 #include "hal/architecture/Linux/drivers/core/IPAddress.h"
 #endif
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+#define MQTT_NONBLOCKING
+#endif
+#if !defined(MQTT_MAX_PACKET_SIZE)
+#define MQTT_MAX_PACKET_SIZE (MY_MQTT_MAX_PACKET_SIZE)
+#endif
 #include "drivers/PubSubClient/PubSubClient.cpp"
 #include "core/MyGatewayTransportMQTTClient.cpp"
 #elif defined(MY_GATEWAY_FEATURE)
@@ -285,8 +294,13 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #else
 #define __RS485CNT 0	//!< __RS485CNT
 #endif
+#if defined(MY_RADIO_LOOPBACK)
+#define __LOOPBACKCNT 1	//!< __LOOPBACKCNT
+#else
+#define __LOOPBACKCNT 0	//!< __LOOPBACKCNT
+#endif
 
-#if (__RF24CNT + __NRF5ESBCNT + __RFM69CNT + __RFM95CNT + __RS485CNT > 1)
+#if (__RF24CNT + __NRF5ESBCNT + __RFM69CNT + __RFM95CNT + __RS485CNT + __LOOPBACKCNT > 1) && !defined(__linux__)
 #error Only one forward link driver can be activated
 #endif
 #endif //DOXYGEN
@@ -297,7 +311,7 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 
 // TRANSPORT INCLUDES
-#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_RADIO_LOOPBACK)
 #include "hal/transport/MyTransportHAL.h"
 #include "core/MyTransport.h"
 
@@ -352,41 +366,65 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #endif
 
-// Transport drivers
-#if defined(MY_RADIO_RF24)
-#include "hal/transport/RF24/driver/RF24.cpp"
-#include "hal/transport/RF24/MyTransportRF24.cpp"
-#elif defined(MY_RADIO_NRF5_ESB)
+// Transport drivers, with several radios each one is compiled as backend MY_TRANSPORT_BACKEND
+#if defined(MY_RADIO_NRF5_ESB)
 #if !defined(ARDUINO_ARCH_NRF5)
 #error No support for nRF5 radio on this platform
 #endif
 #include "hal/transport/NRF5_ESB/driver/Radio.cpp"
 #include "hal/transport/NRF5_ESB/driver/Radio_ESB.cpp"
 #include "hal/transport/NRF5_ESB/MyTransportNRF5_ESB.cpp"
-#elif defined(MY_RS485)
+#endif
+#if defined(MY_RADIO_RF24)
+#define MY_TRANSPORT_BACKEND RF24
+#include "hal/transport/RF24/driver/RF24.cpp"
+#include "hal/transport/RF24/MyTransportRF24.cpp"
+#undef MY_TRANSPORT_BACKEND
+#endif
+#if defined(MY_RS485)
 #if !defined(MY_RS485_HWSERIAL)
 #if defined(__linux__)
 #error You must specify MY_RS485_HWSERIAL for RS485 transport
 #endif
 #include "drivers/AltSoftSerial/AltSoftSerial.cpp"
 #endif
+#define MY_TRANSPORT_BACKEND RS485
 #include "hal/transport/RS485/MyTransportRS485.cpp"
-#elif defined(MY_RADIO_RFM69)
+#undef MY_TRANSPORT_BACKEND
+#endif
+#if defined(MY_RADIO_RFM69)
 #if defined(MY_RFM69_NEW_DRIVER)
 #include "hal/transport/RFM69/driver/new/RFM69_new.cpp"
 #else
 #include "hal/transport/RFM69/driver/old/RFM69_old.cpp"
 #endif
+#define MY_TRANSPORT_BACKEND RFM69
 #include "hal/transport/RFM69/MyTransportRFM69.cpp"
-#elif defined(MY_RADIO_RFM95)
+#undef MY_TRANSPORT_BACKEND
+#endif
+#if defined(MY_RADIO_RFM95)
 #include "hal/transport/RFM95/driver/RFM95.cpp"
+#define MY_TRANSPORT_BACKEND RFM95
 #include "hal/transport/RFM95/MyTransportRFM95.cpp"
+#undef MY_TRANSPORT_BACKEND
+#endif
+#if defined(MY_RADIO_LOOPBACK)
+#if !defined(__linux__)
+#error The loopback transport is only supported on Linux
+#endif
+#define MY_TRANSPORT_BACKEND Loopback
+#include "hal/transport/Loopback/MyTransportLoopback.cpp"
+#undef MY_TRANSPORT_BACKEND
 #endif
 
 #if (defined(MY_RF24_ENABLE_ENCRYPTION) && defined(MY_RADIO_RF24)) || (defined(MY_NRF5_ESB_ENABLE_ENCRYPTION) && defined(MY_RADIO_NRF5_ESB)) || (defined(MY_RFM69_ENABLE_ENCRYPTION) && defined(MY_RADIO_RFM69)) || (defined(MY_RFM95_ENABLE_ENCRYPTION) && defined(MY_RADIO_RFM95))
 #define MY_TRANSPORT_ENCRYPTION //!< ïnternal flag
 #endif
 
+#if defined(MY_TRANSPORT_ENCRYPTION) && defined(MY_TRANSPORT_MULTI_RADIO)
+#error Transport encryption is not supported with several radios
+#endif
+
 #include "hal/transport/MyTransportHAL.cpp"
 
 // PASSIVE MODE
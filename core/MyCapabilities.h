@@ -83,7 +83,8 @@
  * @def MY_CAP_RADIO
  * @brief Indicate the type of transport selected.
  *
- * @see MY_RADIO_RF24, MY_RADIO_NRF5_ESB, MY_RADIO_RFM69, MY_RFM69_NEW_DRIVER, MY_RADIO_RFM95, MY_RS485
+ * @see MY_RADIO_RF24, MY_RADIO_NRF5_ESB, MY_RADIO_RFM69, MY_RFM69_NEW_DRIVER, MY_RADIO_RFM95, MY_RS485,
+ * MY_RADIO_LOOPBACK
  *
  * | Radio        | Indicator
  * |--------------|----------
@@ -92,6 +93,7 @@
  * | %RFM69 (new) | P
  * | RFM95        | L
  * | RS485        | S
+ * | Loopback     | X
  * | None         | -
  */
 #if defined(MY_RADIO_RF24) || defined(MY_RADIO_NRF5_ESB)
@@ -108,6 +110,8 @@
 #define MY_CAP_RADIO "L"
 #elif defined(MY_RS485)
 #define MY_CAP_RADIO "S"
+#elif defined(MY_RADIO_LOOPBACK)
+#define MY_CAP_RADIO "X"
 #else
 #define MY_CAP_RADIO "-"
 #endif
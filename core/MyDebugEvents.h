@@ -0,0 +1,194 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * @file MyDebugEvents.h
+ *
+ * @defgroup MyDebugEventsgrp MyDebugEvents
+ * @ingroup internals
+ * @{
+ *
+ * Structured debug events, enabled with @ref MY_DEBUG_EVENTS.
+ *
+ * The per-message debug lines are printed as an event ID and the raw arguments in hex instead of
+ * a formatted text, format: ~ID:ARGUMENTS, e.g. <tt>~01:010000010317000000</tt>. The Logparser turns
+ * them back into the usual text line, e.g. <tt>TSF:MSG:READ,1-0-0,s=1,c=3,t=23,pt=0,l=0,sg=0:</tt>.
+ *
+ * Multi-byte arguments are little endian. A payload (@ref debugEventBytes_t) is always last.
+ *
+ * |ID  | Text line                   | Arguments
+ * |----|-----------------------------|------------------------------------------------------------
+ * |0x01| TSF:MSG:READ                | sender, last, destination, sensor, command, type, payload type, length, signed, payload
+ * |0x02| [?!]TSF:MSG:SEND            | status (bit 0: NACK, bit 1: no ACK requested), sender, last, to, destination, sensor, command, type, payload type, length, signed, failed uplink transmissions, payload
+ * |0x03| TSF:MSG:ECHO REQ            | -
+ * |0x04| TSF:MSG:ECHO                | -
+ * |0x05| TSF:MSG:BC                  | -
+ * |0x06| TSF:MSG:RCV CB              | -
+ * |0x07| TSF:MSG:REL MSG             | -
+ * |0x40| GWT:RFC:[C=%%d,]MSG         | client (255 = single client), destination, sensor, command, echo, type, payload type, length, payload
+ * |0x41| GWT:TPS:TOPIC=%%s,MSG SENT   | topic
+ * |0x42| GWT:IMQ:TOPIC=%%s, MSG RECEIVED | topic
+ * |0x80| SGN:SGN:NCE REQ,TO=%%d       | destination
+ * |0x81| SGN:SGN:SGN                 | -
+ * |0x82| SGN:SGN:NREQ=%%d             | destination
+ * |0x83| SGN:SGN:%%d!=%%d NUS          | sender, node ID
+ * |0x84| SGN:VER:OK                  | -
+ * |0x85| SGN:SKP:%%s CMD=%%d,TYPE=%%d  | echo, command, type
+ * |0x86| SGN:NCE:LEFT=%%d             | nonce requests left
+ * |0x87| SGN:NCE:XMT,TO=%%d           | destination
+ * |0x88| SGN:NCE:FROM=%%d             | sender
+ *
+ * The payload of nonce responses is not printed. Topics are truncated to @ref DEBUG_EVENT_MAX_SIZE.
+ */
+
+#ifndef MyDebugEvents_h
+#define MyDebugEvents_h
+
+/**
+ * @brief Subsystems, events are filtered per subsystem with @ref MY_DEBUG_EVENTS_FILTER
+ */
+typedef enum {
+	DEBUG_SUBSYSTEM_TRANSPORT = 0,		//!< MyTransport
+	DEBUG_SUBSYSTEM_GATEWAY = 1,		//!< MyGatewayTransport
+	DEBUG_SUBSYSTEM_SIGNING = 2			//!< MySigning
+} debugSubsystem_t;
+
+/**
+ * @brief Event IDs
+ */
+typedef enum {
+	DEBUG_EVENT_TSF_MSG_READ = 0x01,		//!< TSF:MSG:READ
+	DEBUG_EVENT_TSF_MSG_SEND = 0x02,		//!< TSF:MSG:SEND
+	DEBUG_EVENT_TSF_MSG_ECHO_REQ = 0x03,	//!< TSF:MSG:ECHO REQ
+	DEBUG_EVENT_TSF_MSG_ECHO = 0x04,		//!< TSF:MSG:ECHO
+	DEBUG_EVENT_TSF_MSG_BC = 0x05,			//!< TSF:MSG:BC
+	DEBUG_EVENT_TSF_MSG_RCV_CB = 0x06,		//!< TSF:MSG:RCV CB
+	DEBUG_EVENT_TSF_MSG_REL_MSG = 0x07,		//!< TSF:MSG:REL MSG
+	DEBUG_EVENT_GWT_RFC_MSG = 0x40,			//!< GWT:RFC:MSG
+	DEBUG_EVENT_GWT_TPS_MSG_SENT = 0x41,	//!< GWT:TPS:TOPIC,MSG SENT
+	DEBUG_EVENT_GWT_IMQ_MSG_RECEIVED = 0x42,	//!< GWT:IMQ:TOPIC,MSG RECEIVED
+	DEBUG_EVENT_SGN_SGN_NCE_REQ = 0x80,		//!< SGN:SGN:NCE REQ
+	DEBUG_EVENT_SGN_SGN_SGN = 0x81,			//!< SGN:SGN:SGN
+	DEBUG_EVENT_SGN_SGN_NREQ = 0x82,		//!< SGN:SGN:NREQ
+	DEBUG_EVENT_SGN_SGN_NUS = 0x83,			//!< SGN:SGN:NUS
+	DEBUG_EVENT_SGN_VER_OK = 0x84,			//!< SGN:VER:OK
+	DEBUG_EVENT_SGN_SKP = 0x85,				//!< SGN:SKP
+	DEBUG_EVENT_SGN_NCE_LEFT = 0x86,		//!< SGN:NCE:LEFT
+	DEBUG_EVENT_SGN_NCE_XMT = 0x87,			//!< SGN:NCE:XMT
+	DEBUG_EVENT_SGN_NCE_FROM = 0x88			//!< SGN:NCE:FROM
+} debugEvent_t;
+
+#define DEBUG_EVENT_SEND_NACK (1u)			//!< TSF:MSG:SEND status flag: sending failed
+#define DEBUG_EVENT_SEND_NOACK (2u)			//!< TSF:MSG:SEND status flag: no ACK requested
+#define DEBUG_EVENT_SINGLE_CLIENT (255u)	//!< GWT:RFC:MSG client: gateway serves a single client
+
+#if defined(MY_GATEWAY_MQTT_CLIENT)
+#define DEBUG_EVENT_MAX_SIZE (120u)	//!< Maximum size of the event arguments, room for a topic
+#else
+#define DEBUG_EVENT_MAX_SIZE (HEADER_SIZE + MAX_PAYLOAD_SIZE + 8u)	//!< Maximum size of the event arguments
+#endif
+
+/**
+ * @brief Raw bytes as last event argument, e.g. a message payload
+ */
+typedef struct {
+	const void *data;		//!< Bytes
+	uint8_t length;			//!< Number of bytes
+} debugEventBytes_t;
+
+/**
+ * @brief Compile-time filter, events of disabled subsystems are optimized out
+ */
+template <uint8_t subsystem> struct debugEventFilter {
+	static const bool enabled = ((MY_DEBUG_EVENTS_FILTER) >> subsystem) & 1u;	//!< Subsystem enabled
+};
+
+/**
+ * @brief End of the argument list
+ * @param buffer Argument buffer
+ * @param pos Bytes used
+ * @return Bytes used
+ */
+static inline uint8_t debugEventPack(uint8_t *buffer, const uint8_t pos)
+{
+	(void)buffer;
+	return pos;
+}
+
+/**
+ * @brief Append raw bytes, truncated to the buffer size
+ * @param buffer Argument buffer
+ * @param pos Bytes used
+ * @param bytes Bytes to append
+ * @return Bytes used
+ */
+static inline uint8_t debugEventPack(uint8_t *buffer, const uint8_t pos,
+                                     const debugEventBytes_t bytes)
+{
+	const uint8_t length = (pos + bytes.length > DEBUG_EVENT_MAX_SIZE) ? DEBUG_EVENT_MAX_SIZE - pos :
+	                       bytes.length;
+	(void)memcpy((void *)&buffer[pos], bytes.data, length);
+	return pos + length;
+}
+
+/**
+ * @brief Append an argument
+ * @param buffer Argument buffer
+ * @param pos Bytes used
+ * @param value Argument
+ * @param args Further arguments
+ * @return Bytes used
+ */
+template <typename T, typename... Args> inline uint8_t debugEventPack(uint8_t *buffer,
+        const uint8_t pos, const T value, const Args... args)
+{
+	if (pos + sizeof(T) > DEBUG_EVENT_MAX_SIZE) {
+		return pos;
+	}
+	(void)memcpy((void *)&buffer[pos], (const void *)&value, sizeof(T));
+	return debugEventPack(buffer, pos + sizeof(T), args...);
+}
+
+/**
+ * @brief Print a debug event without arguments
+ * @param id Event ID, see @ref debugEvent_t
+ */
+template <uint8_t subsystem> inline void debugEvent(const uint8_t id)
+{
+	if (debugEventFilter<subsystem>::enabled) {
+		hwDebugEvent(id, NULL, 0);
+	}
+}
+
+/**
+ * @brief Print a debug event
+ * @param id Event ID, see @ref debugEvent_t
+ * @param args Event arguments
+ */
+template <uint8_t subsystem, typename... Args> inline void debugEvent(const uint8_t id,
+        const Args... args)
+{
+	if (debugEventFilter<subsystem>::enabled) {
+		uint8_t buffer[DEBUG_EVENT_MAX_SIZE];
+		hwDebugEvent(id, buffer, debugEventPack(buffer, 0, args...));
+	}
+}
+
+#endif // MyDebugEvents_h
+/** @}*/
@@ -20,6 +20,9 @@
 #include "MyGatewayTransport.h"
 
 extern bool transportSendRoute(MyMessage &message);
+#if defined(MY_SENSOR_NETWORK) && defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+extern bool transportQueueSend(MyMessage &message);
+#endif
 
 // global variables
 extern MyMessage _msg;
@@ -62,7 +65,18 @@ inline void gatewayTransportProcess(void)
 			}
 		} else {
 #if defined(MY_SENSOR_NETWORK)
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+			if (!transportQueueSend(_msg)) {
+				// tell the controller, it would otherwise wait for an echo that never comes
+				GATEWAY_DEBUG(PSTR("!GWT:TPC:TXQ FULL,TO=%" PRIu8 "\n"), _msg.getDestination());
+				setIndication(INDICATION_ERR_TX);
+				char text[16];
+				(void)snprintf_P(text, sizeof(text), PSTR("TXQ FULL,TO=%" PRIu8), _msg.getDestination());
+				gatewayTransportSend(buildGw(_msgTmp, I_LOG_MESSAGE).set(text));
+			}
+#else
 			transportSendRoute(_msg);
+#endif
 #endif
 		}
 	}
@@ -48,12 +48,18 @@
 * | | GWT | TIN   | ETH OK                    | Connected to network
 * |!| GWT | TIN   | ETH FAIL                  | Connection failed
 * | | GWT | TPS   | TOPIC=%%s,MSG SENT        | MQTT message sent on topic [%%s]
+* |!| GWT | TPS   | QUEUE FULL                | MQTT broker unreachable and queue full, oldest message dropped
+* |!| GWT | TPS   | MSG DROPPED               | Queued MQTT message rejected by the client, e.g. too long
 * | | GWT | TPS   | ETH OK                    | Connected to network
 * |!| GWT | TPS   | ETH FAIL                  | Connection failed
 * | | GWT | IMQ   | TOPIC=%%s,MSG RECEIVE     | MQTT message received on topic [%%s]
 * | | GWT | RMQ   | CONNECTING...             | Connecting to MQTT broker
 * | | GWT | RMQ   | OK                        | Connected to MQTT broker
 * |!| GWT | RMQ   | FAIL                      | Connection to MQTT broker failed
+* | | GWT | RMQ   | OK,B=%%d                  | Connected to MQTT broker [%%d] (0: primary, 1: secondary)
+* |!| GWT | RMQ   | FAIL,B=%%d,ST=%%d         | Connection to MQTT broker [%%d] failed, client state [%%d]
+* | | GWT | RMQ   | RETRY IN=%%d              | Next connection attempt in [%%d] ms
+* |!| GWT | RMQ   | LOST,ST=%%d               | Connection to MQTT broker lost, client state [%%d]
 * | | GWT | TPC   | CONNECTING...             | Obtaining IP address
 * | | GWT | TPC   | IP=%%s                    | IP address [%%s] obtained
 * |!| GWT | TPC   | DHCP FAIL                 | DHCP request failed
@@ -84,6 +90,11 @@
 #else
 #define GATEWAY_DEBUG(x,...)									//!< debug NULL
 #endif
+#if defined(MY_DEBUG_VERBOSE_GATEWAY) && defined(MY_DEBUG_EVENTS)
+#define GATEWAY_EVENT_OR_DEBUG(event,x,...)	debugEvent<DEBUG_SUBSYSTEM_GATEWAY> event	//!< debug event (ID, arguments)
+#else
+#define GATEWAY_EVENT_OR_DEBUG(event,x,...)	GATEWAY_DEBUG(x, ##__VA_ARGS__)	//!< debug text instead of event
+#endif
 
 /**
  * @brief Process gateway-related messages
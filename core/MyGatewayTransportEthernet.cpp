@@ -100,25 +100,28 @@ typedef struct {
 EthernetUDP _ethernetServer;
 #endif /* End of MY_USE_UDP */
 #elif defined(MY_GATEWAY_LINUX) /* Elif part of MY_GATEWAY_CLIENT_MODE */
-EthernetServer _ethernetServer(_ethernetGatewayPort, MY_GATEWAY_MAX_CLIENTS);
+EthernetServer _ethernetServer(_ethernetGatewayPort, MY_GATEWAY_MAX_CLIENTS,
+                               MY_LINUX_GATEWAY_FLUSH_DEADLINE_MS);
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 EthernetServer _ethernetServer(_ethernetGatewayPort);
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 
 #if defined(MY_GATEWAY_CLIENT_MODE)
-static inputBuffer inputString;
 #if defined(MY_USE_UDP)
-// Nothing to do here
+static inputBuffer inputString;
 #else
 static EthernetClient client = EthernetClient();
+static protocolSerialParser_t inputParser;
 #endif /* End of MY_USE_UDP */
 #elif defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)
 static EthernetClient clients[MY_GATEWAY_MAX_CLIENTS];
 static bool clientsConnected[MY_GATEWAY_MAX_CLIENTS];
-static inputBuffer inputString[MY_GATEWAY_MAX_CLIENTS];
+static protocolSerialParser_t inputParser[MY_GATEWAY_MAX_CLIENTS];
+// Messages being decoded, lines of different clients may arrive interleaved
+static MyMessage inputMsg[MY_GATEWAY_MAX_CLIENTS];
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 static EthernetClient client = EthernetClient();
-static inputBuffer inputString;
+static protocolSerialParser_t inputParser;
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 
 // On W5100 boards with SPI_EN exposed we can use the real SPI bus together with radio
@@ -239,7 +242,10 @@ bool gatewayTransportInit(void)
 bool gatewayTransportSend(MyMessage &message)
 {
 	int nbytes = 0;
-	char *_ethernetMessage = protocolMyMessage2Serial(message);
+	// Local buffer, the reconnect below sends I_GATEWAY_READY recursively
+	char _ethernetMessage[MY_GATEWAY_MAX_SEND_LENGTH];
+	const uint8_t _ethernetLength = protocolFormatSerial(_ethernetMessage,
+	                                (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH, message);
 
 	setIndication(INDICATION_GW_TX);
 
@@ -251,7 +257,7 @@ bool gatewayTransportSend(MyMessage &message)
 #else
 	_ethernetServer.beginPacket(_ethernetControllerIP, MY_PORT);
 #endif /* End of MY_CONTROLLER_URL_ADDRESS */
-	_ethernetServer.write((uint8_t *)_ethernetMessage, strlen(_ethernetMessage));
+	_ethernetServer.write((uint8_t *)_ethernetMessage, _ethernetLength);
 	// returns 1 if the packet was sent successfully
 	nbytes = _ethernetServer.endPacket();
 #else /* Else part of MY_USE_UDP */
@@ -274,18 +280,18 @@ bool gatewayTransportSend(MyMessage &message)
 			return false;
 		}
 	}
-	nbytes = client.write((const uint8_t *)_ethernetMessage, strlen(_ethernetMessage));
+	nbytes = client.write((const uint8_t *)_ethernetMessage, _ethernetLength);
 #endif /* End of MY_USE_UDP */
 #else /* Else part of MY_GATEWAY_CLIENT_MODE */
 	// Send message to connected clients
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
 		if (clients[i] && clients[i].connected()) {
-			nbytes += clients[i].write((uint8_t *)_ethernetMessage, strlen(_ethernetMessage));
+			nbytes += clients[i].write((uint8_t *)_ethernetMessage, _ethernetLength);
 		}
 	}
 #else /* Else part of MY_GATEWAY_ESPxx*/
-	nbytes = _ethernetServer.write(_ethernetMessage);
+	nbytes = _ethernetServer.write((const uint8_t *)_ethernetMessage, _ethernetLength);
 #endif /* End of MY_GATEWAY_ESPxx */
 #endif /* End of MY_GATEWAY_CLIENT_MODE */
 	_w5100_spi_en(false);
@@ -298,28 +304,27 @@ bool gatewayTransportSend(MyMessage &message)
 #if (defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32) || defined(MY_GATEWAY_LINUX)) && !defined(MY_GATEWAY_CLIENT_MODE)
 bool _readFromClient(uint8_t i)
 {
-	while (clients[i].connected() && clients[i].available()) {
-		const char inChar = clients[i].read();
-		if (inputString[i].idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			// if newline then command is complete
-			if (inChar == '\n' || inChar == '\r') {
-				// Add string terminator and prepare for the next message
-				inputString[i].string[inputString[i].idx] = 0;
-				GATEWAY_DEBUG(PSTR("GWT:RFC:C=%" PRIu8 ",MSG=%s\n"), i, inputString[i].string);
-				inputString[i].idx = 0;
-				if (protocolSerial2MyMessage(_ethernetMsg, inputString[i].string)) {
-					return true;
-				}
-			} else {
-				// add it to the inputString:
-				inputString[i].string[inputString[i].idx++] = inChar;
-			}
-		} else {
-			// Incoming message too long. Throw away
+	if (!clients[i].connected()) {
+		return false;
+	}
+	while (clients[i].available()) {
+		const bool overflow = inputParser[i].overflow;
+		if (protocolSerialParse(inputParser[i], inputMsg[i], clients[i].read())) {
+			_ethernetMsg = inputMsg[i];
+			GATEWAY_EVENT_OR_DEBUG((DEBUG_EVENT_GWT_RFC_MSG, i, _ethernetMsg.getDestination(),
+			                        _ethernetMsg.getSensor(), (uint8_t)_ethernetMsg.getCommand(),
+			                        (uint8_t)_ethernetMsg.getRequestEcho(), _ethernetMsg.getType(),
+			                        (uint8_t)_ethernetMsg.getPayloadType(), _ethernetMsg.getLength(),
+			                        debugEventBytes_t { _ethernetMsg.data, _ethernetMsg.getLength() }),
+			                       PSTR("GWT:RFC:C=%" PRIu8 ",MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%"
+			                            PRIu8 ";%s\n"), i, _ethernetMsg.getDestination(), _ethernetMsg.getSensor(),
+			                       _ethernetMsg.getCommand(), _ethernetMsg.getRequestEcho(), _ethernetMsg.getType(),
+			                       _ethernetMsg.getString(_convBuffer));
+			return true;
+		}
+		if (!overflow && inputParser[i].overflow) {
+			// Incoming message too long. Rest of the line is thrown away
 			GATEWAY_DEBUG(PSTR("!GWT:RFC:C=%" PRIu8 ",MSG TOO LONG\n"), i);
-			inputString[i].idx = 0;
-			// Finished with this client's message. Next loop() we'll see if there's more to read.
-			break;
 		}
 	}
 	return false;
@@ -327,29 +332,25 @@ bool _readFromClient(uint8_t i)
 #else /* Else part of MY_GATEWAY_ESP8266 || MY_GATEWAY_LINUX || !MY_GATEWAY_CLIENT_MODE */
 bool _readFromClient(void)
 {
-	while (client.connected() && client.available()) {
-		const char inChar = client.read();
-		if (inputString.idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			// if newline then command is complete
-			if (inChar == '\n' || inChar == '\r') {
-				// Add string terminator and prepare for the next message
-				inputString.string[inputString.idx] = 0;
-				GATEWAY_DEBUG(PSTR("GWT:RFC:MSG=%s\n"), inputString.string);
-				inputString.idx = 0;
-				if (protocolSerial2MyMessage(_ethernetMsg, inputString.string)) {
-					return true;
-				}
-
-			} else {
-				// add it to the inputString:
-				inputString.string[inputString.idx++] = inChar;
-			}
-		} else {
-			// Incoming message too long. Throw away
+	if (!client.connected()) {
+		return false;
+	}
+	while (client.available()) {
+		const bool overflow = inputParser.overflow;
+		if (protocolSerialParse(inputParser, _ethernetMsg, client.read())) {
+			GATEWAY_EVENT_OR_DEBUG((DEBUG_EVENT_GWT_RFC_MSG, (uint8_t)DEBUG_EVENT_SINGLE_CLIENT,
+			                        _ethernetMsg.getDestination(), _ethernetMsg.getSensor(),
+			                        (uint8_t)_ethernetMsg.getCommand(), (uint8_t)_ethernetMsg.getRequestEcho(),
+			                        _ethernetMsg.getType(), (uint8_t)_ethernetMsg.getPayloadType(),
+			                        _ethernetMsg.getLength(), debugEventBytes_t { _ethernetMsg.data, _ethernetMsg.getLength() }),
+			                       PSTR("GWT:RFC:MSG=%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n"),
+			                       _ethernetMsg.getDestination(), _ethernetMsg.getSensor(), _ethernetMsg.getCommand(),
+			                       _ethernetMsg.getRequestEcho(), _ethernetMsg.getType(), _ethernetMsg.getString(_convBuffer));
+			return true;
+		}
+		if (!overflow && inputParser.overflow) {
+			// Incoming message too long. Rest of the line is thrown away
 			GATEWAY_DEBUG(PSTR("!GWT:RFC:MSG TOO LONG\n"));
-			inputString.idx = 0;
-			// Finished with this client's message. Next loop() we'll see if there's more to read.
-			break;
 		}
 	}
 	return false;
@@ -389,6 +390,7 @@ bool gatewayTransportAvailable(void)
 		if (client.connect(_ethernetControllerIP, MY_PORT)) {
 #endif /* End of MY_CONTROLLER_URL_ADDRESS */
 			GATEWAY_DEBUG(PSTR("GWT:TSA:ETH OK\n"));
+			protocolSerialParserReset(inputParser);
 			_w5100_spi_en(false);
 			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(F(MSG_GW_STARTUP_COMPLETE)));
 			_w5100_spi_en(true);
@@ -419,7 +421,7 @@ bool gatewayTransportAvailable(void)
 			//check if there are any new clients
 			if (_ethernetServer.hasClient()) {
 				clients[i] = _ethernetServer.available();
-				inputString[i].idx = 0;
+				protocolSerialParserReset(inputParser[i]);
 				GATEWAY_DEBUG(PSTR("GWT:TSA:C=%" PRIu8 ",CONNECTED\n"), i);
 				gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
 				// Send presentation of locally attached sensors (and node if applicable)
@@ -452,6 +454,7 @@ bool gatewayTransportAvailable(void)
 		if (client != newclient) {
 			client.stop();
 			client = newclient;
+			protocolSerialParserReset(inputParser);
 			GATEWAY_DEBUG(PSTR("GWT:TSA:ETH OK\n"));
 			_w5100_spi_en(false);
 			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
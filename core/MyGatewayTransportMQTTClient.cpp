@@ -65,6 +65,25 @@
 #define _brokerIp IPAddress(MY_CONTROLLER_IP_ADDRESS)
 #endif
 
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE) && !defined(MY_GATEWAY_LINUX)
+#error MY_MQTT_CLIENT_ASYNC_FEATURE is only supported on Linux
+#endif
+
+#if (MY_MQTT_CLIENT_PUBLISH_QOS) > 1
+#error MY_MQTT_CLIENT_PUBLISH_QOS must be 0 or 1
+#elif (MY_MQTT_CLIENT_PUBLISH_QOS) == 1 && !defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+#error MY_MQTT_CLIENT_PUBLISH_QOS 1 requires MY_MQTT_CLIENT_ASYNC_FEATURE
+#endif
+
+#if defined(MY_MQTT_SECONDARY_IP_ADDRESS) || defined(MY_MQTT_SECONDARY_URL_ADDRESS)
+#if !defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+#error MY_MQTT_SECONDARY_IP_ADDRESS/MY_MQTT_SECONDARY_URL_ADDRESS require MY_MQTT_CLIENT_ASYNC_FEATURE
+#endif
+#define _MQTT_BROKERS (2u)
+#else
+#define _MQTT_BROKERS (1u)
+#endif
+
 #if defined(MY_IP_ADDRESS)
 #define _MQTT_clientIp IPAddress(MY_IP_ADDRESS)
 #if defined(MY_IP_GATEWAY_ADDRESS)
@@ -117,31 +136,328 @@ static bool _MQTT_connecting = true;
 static bool _MQTT_available = false;
 static MyMessage _MQTT_msg;
 
-// cppcheck-suppress constParameter
-bool gatewayTransportSend(MyMessage &message)
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+/**
+ * @brief Broker connection states, advanced by _MQTT_linkProcess()
+ */
+typedef enum {
+	MQTT_LINK_WAIT,			//!< Waiting for the next connection attempt
+	MQTT_LINK_TCP,			//!< TCP connection in progress
+	MQTT_LINK_SESSION,		//!< CONNECT sent, waiting for CONNACK
+	MQTT_LINK_UP			//!< Connected and subscribed
+} mqttLinkState_t;
+
+#if (MY_MQTT_CLIENT_QUEUE_SIZE) < 1 || (MY_MQTT_CLIENT_QUEUE_SIZE) > 255
+#error MY_MQTT_CLIENT_QUEUE_SIZE must be 1 to 255, the queue indices are 8 bit
+#endif
+#if (MY_MQTT_CLIENT_INFLIGHT_WINDOW) < 1 || (MY_MQTT_CLIENT_INFLIGHT_WINDOW) > (MY_MQTT_CLIENT_QUEUE_SIZE)
+#error MY_MQTT_CLIENT_INFLIGHT_WINDOW must be 1 to MY_MQTT_CLIENT_QUEUE_SIZE
+#endif
+
+#define _MQTT_LINK_POLL_MS (20u)	//!< Poll interval while a TCP connection is pending
+
+static mqttLinkState_t _MQTT_linkState = MQTT_LINK_WAIT;
+static uint32_t _MQTT_linkTimestamp = 0;	// Start of the current attempt or wait
+static uint32_t _MQTT_linkDelay = 0;		// Wait before the next attempt
+static uint32_t _MQTT_backoff = MY_MQTT_CLIENT_RECONNECT_MS;	// Wait after the next failure
+static uint8_t _MQTT_broker = 0;			// Broker of the current attempt, 0 is the primary
+
+/**
+ * @brief Queued message. The entries [head, head + sent) are published and wait for their PUBACK,
+ * the remaining ones have not been published in the current session.
+ */
+typedef struct {
+	MyMessage message;		//!< Message
+	uint16_t msgId;			//!< Packet identifier of the last publication
+	bool acked;				//!< Delivered (or dropped), removed once it reaches the head
+} mqttQueueEntry_t;
+
+static mqttQueueEntry_t _MQTT_queue[MY_MQTT_CLIENT_QUEUE_SIZE];	// Messages waiting for the broker
+static uint8_t _MQTT_queueHead = 0;
+static uint8_t _MQTT_queueCount = 0;
+static uint8_t _MQTT_queueSent = 0;		// In flight, at most MY_MQTT_CLIENT_INFLIGHT_WINDOW
+#endif
+
+#if (MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) > 0
+#if ((MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) & ((MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) - 1u)) || (MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) > 65536u
+#error MY_MQTT_CLIENT_TOPIC_CACHE_SIZE must be a power of two, at most 65536
+#endif
+/**
+ * @brief Cached topic levels of one node/sensor/command/type, i.e. the topic without prefix
+ */
+typedef struct {
+	uint32_t key;		//!< Node, sensor, command, echo flag and type
+	uint8_t length;		//!< Length of levels, 0 if unused
+	char levels[19];	//!< "/NODE/SENSOR/CMD/ECHO/TYPE", terminated
+} mqttTopicCacheEntry_t;
+
+static mqttTopicCacheEntry_t _MQTT_topicCache[MY_MQTT_CLIENT_TOPIC_CACHE_SIZE];
+#endif
+
+// Publish topic of message, from the topic cache if enabled
+static void _MQTT_topic(char *topic, const MyMessage &message)
 {
-	if (!_MQTT_client.connected()) {
-		return false;
+#if (MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) > 0
+	const uint8_t prefixLength = strlen(MY_MQTT_PUBLISH_TOPIC_PREFIX);
+	if (prefixLength + sizeof(_MQTT_topicCache[0].levels) <= MY_GATEWAY_MAX_SEND_LENGTH) {
+		const uint32_t key = (uint32_t)message.getSender() << 24 | (uint32_t)message.getSensor() << 16 |
+		                     (uint32_t)message.getCommand() << 9 | (uint32_t)message.isEcho() << 8 | message.getType();
+		// fold the node into the lower half, then spread all bits over the index
+		mqttTopicCacheEntry_t &entry = _MQTT_topicCache[(((key ^ (key >> 15)) * 2654435761ul) >> 16) &
+		                                                 ((MY_MQTT_CLIENT_TOPIC_CACHE_SIZE) - 1u)];
+		if (!entry.length || entry.key != key) {
+			entry.key = key;
+			entry.length = protocolFormatMQTT(entry.levels, (uint8_t)sizeof(entry.levels), "", message);
+		}
+		(void)memcpy((void *)topic, (const void *)MY_MQTT_PUBLISH_TOPIC_PREFIX, prefixLength);
+		// fixed size copy, cheaper than the exact length
+		(void)memcpy((void *)&topic[prefixLength], (const void *)entry.levels, sizeof(entry.levels));
+		return;
 	}
+#endif
+	(void)protocolFormatMQTT(topic, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH, MY_MQTT_PUBLISH_TOPIC_PREFIX,
+	                         message);
+}
+
+static bool _MQTT_publish(const MyMessage &message, uint16_t *msgId)
+{
 	setIndication(INDICATION_GW_TX);
-	char *topic = protocolMyMessage2MQTT(MY_MQTT_PUBLISH_TOPIC_PREFIX, message);
-	GATEWAY_DEBUG(PSTR("GWT:TPS:TOPIC=%s,MSG SENT\n"), topic);
+	char topic[MY_GATEWAY_MAX_SEND_LENGTH];
+	char payload[MAX_PAYLOAD_SIZE * 2 + 1];
+	_MQTT_topic(topic, message);
+	(void)protocolFormatPayload(payload, (uint8_t)sizeof(payload), message);
+	GATEWAY_EVENT_OR_DEBUG((DEBUG_EVENT_GWT_TPS_MSG_SENT, debugEventBytes_t { topic, (uint8_t)strlen(topic) }),
+	                       PSTR("GWT:TPS:TOPIC=%s,MSG SENT\n"), topic);
 #if defined(MY_MQTT_CLIENT_PUBLISH_RETAIN)
 	const bool retain = message.getCommand() == C_SET ||
 	                    (message.getCommand() == C_INTERNAL && message.getType() == I_BATTERY_LEVEL);
 #else
 	const bool retain = false;
 #endif /* End of MY_MQTT_CLIENT_PUBLISH_RETAIN */
-	return _MQTT_client.publish(topic, message.getString(_convBuffer), retain);
+	return _MQTT_client.publish(topic, (const uint8_t *)payload, strlen(payload), retain,
+	                            MY_MQTT_CLIENT_PUBLISH_QOS, msgId);
+}
+
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+static void _MQTT_queueDropHead(void)
+{
+	_MQTT_queueHead = (_MQTT_queueHead + 1) % MY_MQTT_CLIENT_QUEUE_SIZE;
+	_MQTT_queueCount--;
+	if (_MQTT_queueSent) {
+		_MQTT_queueSent--;
+	}
+}
+
+static void _MQTT_queuePush(const MyMessage &message)
+{
+	if (_MQTT_queueCount == MY_MQTT_CLIENT_QUEUE_SIZE) {
+		// keep the most recent data
+		GATEWAY_DEBUG(PSTR("!GWT:TPS:QUEUE FULL\n"));
+		_MQTT_queueDropHead();
+	}
+	mqttQueueEntry_t &entry = _MQTT_queue[(_MQTT_queueHead + _MQTT_queueCount) %
+	                                      MY_MQTT_CLIENT_QUEUE_SIZE];
+	entry.message = message;
+	entry.acked = false;
+	_MQTT_queueCount++;
+}
+
+// Remove delivered messages, in order
+static void _MQTT_queueRelease(void)
+{
+	while (_MQTT_queueSent && _MQTT_queue[_MQTT_queueHead].acked) {
+		_MQTT_queueDropHead();
+	}
+}
+
+static void _MQTT_queueFlush(void)
+{
+	while (_MQTT_queueSent < _MQTT_queueCount && _MQTT_queueSent < MY_MQTT_CLIENT_INFLIGHT_WINDOW) {
+		mqttQueueEntry_t &entry = _MQTT_queue[(_MQTT_queueHead + _MQTT_queueSent) %
+		                                      MY_MQTT_CLIENT_QUEUE_SIZE];
+		// acknowledged in a previous session, but held back by an older message
+		if (!entry.acked) {
+			if (_MQTT_publish(entry.message, &entry.msgId)) {
+				entry.acked = (MY_MQTT_CLIENT_PUBLISH_QOS) == 0;
+			} else if (!_MQTT_client.connected()) {
+				// keep it for the next connection
+				return;
+			} else {
+				// rejected by the client, e.g. too long
+				GATEWAY_DEBUG(PSTR("!GWT:TPS:MSG DROPPED\n"));
+				entry.acked = true;
+			}
+		}
+		_MQTT_queueSent++;
+		_MQTT_queueRelease();
+	}
+}
+
+static void _MQTT_puback(uint16_t msgId)
+{
+	for (uint8_t i = 0; i < _MQTT_queueSent; i++) {
+		mqttQueueEntry_t &entry = _MQTT_queue[(_MQTT_queueHead + i) % MY_MQTT_CLIENT_QUEUE_SIZE];
+		if (!entry.acked && entry.msgId == msgId) {
+			entry.acked = true;
+			_MQTT_queueRelease();
+			return;
+		}
+	}
+}
+#endif
+
+// cppcheck-suppress constParameter
+bool gatewayTransportSend(MyMessage &message)
+{
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+	// the queue keeps the order and holds QoS 1 messages until the broker acknowledges them
+	_MQTT_queuePush(message);
+	if (_MQTT_linkState == MQTT_LINK_UP) {
+		_MQTT_queueFlush();
+	}
+	return true;
+#else
+	if (!_MQTT_client.connected()) {
+		return false;
+	}
+	return _MQTT_publish(message, NULL);
+#endif
 }
 
 void incomingMQTT(char *topic, uint8_t *payload, unsigned int length)
 {
-	GATEWAY_DEBUG(PSTR("GWT:IMQ:TOPIC=%s, MSG RECEIVED\n"), topic);
+	GATEWAY_EVENT_OR_DEBUG((DEBUG_EVENT_GWT_IMQ_MSG_RECEIVED, debugEventBytes_t { topic, (uint8_t)strlen(topic) }),
+	                       PSTR("GWT:IMQ:TOPIC=%s, MSG RECEIVED\n"), topic);
 	_MQTT_available = protocolMQTT2MyMessage(_MQTT_msg, topic, payload, length);
 	setIndication(INDICATION_GW_RX);
 }
 
+static void _MQTT_subscribe(void)
+{
+	char inTopic[strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + strlen("/+/+/+/+/+") + 1];
+	(void)strncpy(inTopic, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX, strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1);
+	(void)strcat(inTopic, "/+/+/+/+/+");
+	_MQTT_client.subscribe(inTopic);
+}
+
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+static bool _MQTT_linkConnect(void)
+{
+#if defined(MY_MQTT_SECONDARY_IP_ADDRESS)
+	if (_MQTT_broker) {
+		return _MQTT_ethClient.connectAsync(IPAddress(MY_MQTT_SECONDARY_IP_ADDRESS),
+		                                    MY_MQTT_SECONDARY_PORT) == 1;
+	}
+#elif defined(MY_MQTT_SECONDARY_URL_ADDRESS)
+	if (_MQTT_broker) {
+		return _MQTT_ethClient.connectAsync(MY_MQTT_SECONDARY_URL_ADDRESS, MY_MQTT_SECONDARY_PORT) == 1;
+	}
+#endif
+#if defined(MY_CONTROLLER_IP_ADDRESS)
+	return _MQTT_ethClient.connectAsync(_brokerIp, MY_PORT) == 1;
+#else
+	return _MQTT_ethClient.connectAsync(MY_CONTROLLER_URL_ADDRESS, MY_PORT) == 1;
+#endif
+}
+
+static void _MQTT_linkWait(const uint32_t delayMs)
+{
+	_MQTT_linkState = MQTT_LINK_WAIT;
+	_MQTT_linkTimestamp = hwMillis();
+	_MQTT_linkDelay = delayMs;
+	eventLoopWakeupIn(delayMs);
+}
+
+static void _MQTT_linkFail(void)
+{
+	GATEWAY_DEBUG(PSTR("!GWT:RMQ:FAIL,B=%" PRIu8 ",ST=%d\n"), _MQTT_broker, _MQTT_client.state());
+	_MQTT_ethClient.stop();
+	_MQTT_broker = (_MQTT_broker + 1) % _MQTT_BROKERS;
+	if (_MQTT_broker) {
+		// try the secondary broker right away
+		_MQTT_linkWait(0);
+		return;
+	}
+	GATEWAY_DEBUG(PSTR("GWT:RMQ:RETRY IN=%" PRIu32 "\n"), _MQTT_backoff);
+	_MQTT_linkWait(_MQTT_backoff);
+	_MQTT_backoff = min(_MQTT_backoff * 2u, (uint32_t)MY_MQTT_CLIENT_RECONNECT_MAX_MS);
+}
+
+// Advance the broker connection, returns true while connected
+static bool _MQTT_linkProcess(void)
+{
+	switch (_MQTT_linkState) {
+	case MQTT_LINK_WAIT:
+		if (hwMillis() - _MQTT_linkTimestamp < _MQTT_linkDelay) {
+			return false;
+		}
+		GATEWAY_DEBUG(PSTR("GWT:RMQ:CONNECTING...\n"));
+		_MQTT_linkTimestamp = hwMillis();
+		if (!_MQTT_linkConnect()) {
+			_MQTT_linkFail();
+			return false;
+		}
+		_MQTT_linkState = MQTT_LINK_TCP;
+	// Fall through
+	case MQTT_LINK_TCP: {
+		const uint8_t status = _MQTT_ethClient.status();
+		if (status == ETHERNETCLIENT_W5100_SYNSENT) {
+			// the socket becomes writable, not readable, when connected: poll
+			if (hwMillis() - _MQTT_linkTimestamp >= MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS) {
+				_MQTT_linkFail();
+			} else {
+				eventLoopWakeupIn(_MQTT_LINK_POLL_MS);
+			}
+			return false;
+		}
+		if (status != ETHERNETCLIENT_W5100_ESTABLISHED ||
+		        !_MQTT_client.beginSession(MY_MQTT_CLIENT_ID, MY_MQTT_USER, MY_MQTT_PASSWORD, NULL, 0, false,
+		                                   NULL, true)) {
+			_MQTT_linkFail();
+			return false;
+		}
+		_MQTT_linkState = MQTT_LINK_SESSION;
+	}
+	// Fall through
+	case MQTT_LINK_SESSION:
+		(void)_MQTT_client.loop();
+		if (_MQTT_client.state() == MQTT_CONNECTING) {
+			const uint32_t elapsed = hwMillis() - _MQTT_linkTimestamp;
+			if (elapsed >= MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS) {
+				_MQTT_linkFail();
+			} else {
+				eventLoopWakeupIn(MY_MQTT_CLIENT_CONNECT_TIMEOUT_MS - elapsed);
+			}
+			return false;
+		}
+		if (_MQTT_client.state() != MQTT_CONNECTED) {
+			_MQTT_linkFail();
+			return false;
+		}
+		GATEWAY_DEBUG(PSTR("GWT:RMQ:OK,B=%" PRIu8 "\n"), _MQTT_broker);
+		_MQTT_linkState = MQTT_LINK_UP;
+		_MQTT_backoff = MY_MQTT_CLIENT_RECONNECT_MS;
+		// clean session: publish everything not acknowledged again, with new packet identifiers
+		_MQTT_queueSent = 0;
+		_MQTT_queueFlush();
+		// Send presentation of locally attached sensors (and node if applicable)
+		presentNode();
+		_MQTT_subscribe();
+		return true;
+	case MQTT_LINK_UP:
+		if (_MQTT_client.connected() && _MQTT_client.state() == MQTT_CONNECTED) {
+			return true;
+		}
+		GATEWAY_DEBUG(PSTR("!GWT:RMQ:LOST,ST=%d\n"), _MQTT_client.state());
+		_MQTT_ethClient.stop();
+		// reconnect to the same broker right away
+		_MQTT_linkWait(0);
+		return false;
+	}
+	return false;
+}
+#endif
+
 bool reconnectMQTT(void)
 {
 	GATEWAY_DEBUG(PSTR("GWT:RMQ:CONNECTING...\n"));
@@ -152,10 +468,7 @@ bool reconnectMQTT(void)
 		// Send presentation of locally attached sensors (and node if applicable)
 		presentNode();
 		// Once connected, publish subscribe
-		char inTopic[strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + strlen("/+/+/+/+/+")];
-		(void)strncpy(inTopic, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX, strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1);
-		(void)strcat(inTopic, "/+/+/+/+/+");
-		_MQTT_client.subscribe(inTopic);
+		_MQTT_subscribe();
 
 		return true;
 	}
@@ -249,6 +562,9 @@ bool gatewayTransportInit(void)
 #endif /* End of MY_CONTROLLER_IP_ADDRESS */
 
 	_MQTT_client.setCallback(incomingMQTT);
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+	_MQTT_client.setPubackCallback(_MQTT_puback);
+#endif
 
 #if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_ESP32)
 	// Turn off access point
@@ -271,6 +587,10 @@ bool gatewayTransportInit(void)
 
 	gatewayTransportConnect();
 
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+	// first attempt right away
+	_MQTT_linkWait(0);
+#endif
 	_MQTT_connecting = false;
 	return true;
 }
@@ -288,6 +608,12 @@ bool gatewayTransportAvailable(void)
 		return false;
 	}
 #endif
+#if defined(MY_MQTT_CLIENT_ASYNC_FEATURE)
+	if (!_MQTT_linkProcess()) {
+		return false;
+	}
+	_MQTT_queueFlush();
+#else
 	if (!_MQTT_client.connected()) {
 		//reinitialise client
 		if (gatewayTransportConnect()) {
@@ -295,6 +621,7 @@ bool gatewayTransportAvailable(void)
 		}
 		return false;
 	}
+#endif
 	_MQTT_client.loop();
 	return _MQTT_available;
 }
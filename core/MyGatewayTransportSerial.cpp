@@ -26,21 +26,23 @@
 // global variables
 extern MyMessage _msgTmp;
 
-char _serialInputString[MY_GATEWAY_MAX_RECEIVE_LENGTH];    // A buffer for incoming commands from serial interface
-uint8_t _serialInputPos;
+protocolSerialParser_t _serialParser;    // Parser state for incoming commands from serial interface
 MyMessage _serialMsg;
 
 // cppcheck-suppress constParameter
 bool gatewayTransportSend(MyMessage &message)
 {
+	char line[MY_GATEWAY_MAX_SEND_LENGTH];
+	(void)protocolFormatSerial(line, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH, message);
 	setIndication(INDICATION_GW_TX);
-	MY_SERIALDEVICE.print(protocolMyMessage2Serial(message));
+	MY_SERIALDEVICE.print(line);
 	// Serial print is always successful
 	return true;
 }
 
 bool gatewayTransportInit(void)
 {
+	protocolSerialParserReset(_serialParser);
 	(void)gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set(MSG_GW_STARTUP_COMPLETE));
 	// Send presentation of locally attached sensors (and node if applicable)
 	presentNode();
@@ -50,27 +52,10 @@ bool gatewayTransportInit(void)
 bool gatewayTransportAvailable(void)
 {
 	while (MY_SERIALDEVICE.available()) {
-		// get the new byte:
-		const char inChar = (char)MY_SERIALDEVICE.read();
-		// if the incoming character is a newline, set a flag
-		// so the main loop can do something about it:
-		if (_serialInputPos < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
-			if (inChar == '\n') {
-				_serialInputString[_serialInputPos] = 0;
-				const bool ok = protocolSerial2MyMessage(_serialMsg, _serialInputString);
-				if (ok) {
-					setIndication(INDICATION_GW_RX);
-				}
-				_serialInputPos = 0;
-				return ok;
-			} else {
-				// add it to the inputString:
-				_serialInputString[_serialInputPos] = inChar;
-				_serialInputPos++;
-			}
-		} else {
-			// Incoming message too long. Throw away
-			_serialInputPos = 0;
+		// decode the new byte, a complete line yields a message
+		if (protocolSerialParse(_serialParser, _serialMsg, (char)MY_SERIALDEVICE.read())) {
+			setIndication(INDICATION_GW_RX);
+			return true;
 		}
 	}
 	return false;
@@ -22,146 +22,414 @@
 #include "MyProtocol.h"
 #include "MyHelperFunctions.h"
 #include <string.h>
+#include <math.h>
 
 char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
 char _convBuffer[MAX_PAYLOAD_SIZE * 2 + 1];
 
-bool protocolSerial2MyMessage(MyMessage &message, char *inputString)
+void protocolSerialParserReset(protocolSerialParser_t &parser)
+{
+	parser.field = 0;
+	parser.value = 0;
+	parser.length = 0;
+	parser.payloadLength = 0;
+	parser.token = false;
+	parser.text = false;
+	parser.skip = false;
+	parser.overflow = false;
+}
+
+static void _protocolSerialParserStore(const protocolSerialParser_t &parser, MyMessage &message)
 {
-	char *str, *p;
-	uint8_t index = 0;
-	mysensors_command_t command = C_INVALID_7;
+	switch (parser.field) {
+	case 0: // Radio id (destination)
+		message.setDestination(parser.value);
+		break;
+	case 1: // Child id
+		message.setSensor(parser.value);
+		break;
+	case 2: // Message type
+		message.setCommand(static_cast<mysensors_command_t>(parser.value));
+		break;
+	case 3: // Should we request echo from destination?
+		message.setRequestEcho(parser.value);
+		break;
+	case 4: // Data type
+		message.setType(parser.value);
+		break;
+	}
+}
+
+static bool _protocolSerialParserFinish(const protocolSerialParser_t &parser, MyMessage &message)
+{
+	if (parser.field < 5) {
+		return false;
+	}
 	message.setSender(GATEWAY_ADDRESS);
 	message.setLast(GATEWAY_ADDRESS);
 	message.setEcho(false);
+	if (!parser.token) {
+		// no payload, set default value
+		message.set((uint8_t)0);
+	} else if (message.getCommand() == C_STREAM) {
+		// stream payload was decoded in place, a trailing half byte is dropped
+		message.setLength(parser.payloadLength / 2);
+		message.setPayloadType(P_CUSTOM);
+	} else {
+		// regular payload was copied in place
+		message.setLength(parser.payloadLength);
+		message.setPayloadType(P_STRING);
+		message.data[parser.payloadLength] = 0;
+	}
+	return true;
+}
 
-	// Extract command data coming on serial line
-	for (str = strtok_r(inputString, ";", &p); // split using semicolon
-	        str && index < 5; // loop while str is not null an max 4 times
-	        str = strtok_r(NULL, ";", &p), index++ // get subsequent tokens
-	    ) {
-		switch (index) {
-		case 0: // Radio id (destination)
-			message.setDestination(atoi(str));
-			break;
-		case 1: // Child id
-			message.setSensor(atoi(str));
-			break;
-		case 2: // Message type
-			command = static_cast<mysensors_command_t>(atoi(str));
-			message.setCommand(command);
-			break;
-		case 3: // Should we request echo from destination?
-			message.setRequestEcho(atoi(str) ? 1 : 0);
-			break;
-		case 4: // Data type
-			message.setType(atoi(str));
-			break;
+bool protocolSerialParse(protocolSerialParser_t &parser, MyMessage &message, const char inChar)
+{
+	if (inChar == '\n' || inChar == '\r') {
+		bool ok = false;
+		// Empty lines (e.g. the second half of CR/LF) and overlong lines are ignored
+		if (parser.length && !parser.overflow) {
+			if (parser.token && parser.field < 5) {
+				_protocolSerialParserStore(parser, message);
+				parser.field++;
+				parser.token = false;
+			}
+			ok = _protocolSerialParserFinish(parser, message);
 		}
+		protocolSerialParserReset(parser);
+		return ok;
 	}
-	// payload
-	if (str == NULL) {
-		// no payload, set default value
-		message.set((uint8_t)0);
-	} else if (command == C_STREAM) {
-		// stream payload
-		uint8_t bvalue[MAX_PAYLOAD_SIZE];
-		uint8_t blen = 0;
-		while (*str) {
-			uint8_t val;
-			val = convertH2I(*str++) << 4;
-			val += convertH2I(*str++);
-			bvalue[blen] = val;
-			blen++;
+	if (parser.length >= MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
+		// Incoming message too long. Throw away until end of line
+		parser.overflow = true;
+		return false;
+	}
+	parser.length++;
+	if (parser.skip) {
+		return false;
+	}
+	if (inChar == ';') {
+		// Empty fields are skipped
+		if (parser.token) {
+			if (parser.field < 5) {
+				_protocolSerialParserStore(parser, message);
+				parser.field++;
+				parser.value = 0;
+				parser.token = false;
+				parser.text = false;
+			} else {
+				// payload ends at the next separator
+				parser.skip = true;
+			}
 		}
-		message.set(bvalue, blen);
+	} else if (parser.field < 5) {
+		// numeric header field, anything after the leading digits is ignored
+		parser.token = true;
+		if (!parser.text && inChar >= '0' && inChar <= '9') {
+			if (parser.field == 3) {
+				// echo request is a flag, any non-zero number sets it
+				parser.value |= (inChar != '0');
+			} else {
+				parser.value = (uint8_t)(parser.value * 10u + (uint8_t)(inChar - '0'));
+			}
+		} else {
+			parser.text = true;
+		}
+	} else {
+		parser.token = true;
+		if (message.getCommand() == C_STREAM) {
+			// stream payload, decode hex digits straight into the message
+			if (parser.payloadLength < MAX_PAYLOAD_SIZE * 2) {
+				const uint8_t val = convertH2I(inChar);
+				if (parser.payloadLength & 1) {
+					message.data[parser.payloadLength / 2] += val;
+				} else {
+					message.data[parser.payloadLength / 2] = val << 4;
+				}
+				parser.payloadLength++;
+			}
+		} else if (parser.payloadLength < MAX_PAYLOAD_SIZE) {
+			message.data[parser.payloadLength++] = inChar;
+		}
+	}
+	return false;
+}
+
+bool protocolSerial2MyMessage(MyMessage &message, char *inputString)
+{
+	protocolSerialParser_t parser;
+	protocolSerialParserReset(parser);
+	while (*inputString) {
+		if (protocolSerialParse(parser, message, *inputString++)) {
+			return true;
+		}
+	}
+	return protocolSerialParse(parser, message, '\n');
+}
+
+// Digit pairs 00..99, two digits are converted per division
+static const char _protocolDigits[] PROGMEM =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Powers of ten for the float precision
+static const uint32_t _protocolPow10[] = {
+	1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul, 100000000ul
+};
+
+static char *_protocolPutChar(char *out, const char *end, const char c)
+{
+	if (out < end) {
+		*out++ = c;
+	}
+	return out;
+}
+
+static char *_protocolPutBytes(char *out, const char *end, const char *str, uint8_t length)
+{
+	if (length > end - out) {
+		length = end - out;
+	}
+	(void)memcpy((void *)out, (const void *)str, length);
+	return out + length;
+}
+
+static char *_protocolPutUInt(char *out, const char *end, uint32_t value)
+{
+	char digits[10];
+	char *pos = &digits[sizeof(digits)];
+	while (value >= 100u) {
+		const uint8_t pair = (uint8_t)(value % 100u) * 2u;
+		value /= 100u;
+		*--pos = pgm_read_byte(&_protocolDigits[pair + 1]);
+		*--pos = pgm_read_byte(&_protocolDigits[pair]);
+	}
+	if (value >= 10u) {
+		*--pos = pgm_read_byte(&_protocolDigits[value * 2u + 1]);
+		*--pos = pgm_read_byte(&_protocolDigits[value * 2u]);
 	} else {
-		// regular payload
-		char *value = str;
-		// Remove trailing carriage return and newline character (if it exists)
-		const uint8_t lastCharacter = strlen(value) - 1;
-		if (value[lastCharacter] == '\r' || value[lastCharacter] == '\n') {
-			value[lastCharacter] = '\0';
+		*--pos = '0' + (char)value;
+	}
+	return _protocolPutBytes(out, end, pos, &digits[sizeof(digits)] - pos);
+}
+
+static char *_protocolPutInt(char *out, const char *end, const int32_t value)
+{
+	if (value < 0) {
+		out = _protocolPutChar(out, end, '-');
+		return _protocolPutUInt(out, end, 0ul - (uint32_t)value);
+	}
+	return _protocolPutUInt(out, end, (uint32_t)value);
+}
+
+static char *_protocolPutHex(char *out, const char *end, const uint8_t *data, const uint8_t length)
+{
+	for (uint8_t i = 0; i < length && out < end; i++) {
+		*out++ = convertI2H(data[i] >> 4);
+		out = _protocolPutChar(out, end, convertI2H(data[i]));
+	}
+	return out;
+}
+
+// Same output as dtostrf(value, 2, precision), i.e. "%2.*f"
+static char *_protocolPutFloat(char *out, const char *end, const float value, const uint8_t precision)
+{
+#if !defined(ARDUINO_ARCH_AVR)
+	// value = mantissa * 2^exponent, scaled = value * 10^precision = mantissa * 5^precision * 2^(exponent + precision).
+	// With a 24 bit mantissa and precision <= 8 this is exact in 64 bits, including the rounding
+	// isfinite() is folded to true with -ffinite-math-only (-Ofast), test the exponent bits
+	uint32_t bits;
+	(void)memcpy((void *)&bits, (const void *)&value, sizeof(bits));
+	int exponent;
+	const float fraction = frexpf(fabsf(value), &exponent);
+	if ((bits & 0x7F800000ul) != 0x7F800000ul && exponent <= 24) {
+		uint64_t scaled = (uint64_t)ldexpf(fraction, 24);
+		for (uint8_t i = 0; i < precision; i++) {
+			scaled *= 5u;
+		}
+		const int16_t shift = exponent - 24 + precision;
+		if (shift >= 0) {
+			scaled <<= shift;
+		} else if (shift < -63) {
+			scaled = 0;
+		} else {
+			// round half to even, like printf
+			const uint64_t half = 1ull << (-shift - 1);
+			const uint64_t remainder = scaled & ((half << 1) - 1u);
+			scaled >>= -shift;
+			if (remainder > half || (remainder == half && (scaled & 1u))) {
+				scaled++;
+			}
+		}
+		const uint32_t integer = (uint32_t)(scaled / _protocolPow10[precision]);
+		uint32_t decimals = (uint32_t)(scaled % _protocolPow10[precision]);
+		if (signbit(value)) {
+			out = _protocolPutChar(out, end, '-');
+		} else if (!precision && integer < 10u) {
+			// minimum width of 2
+			out = _protocolPutChar(out, end, ' ');
 		}
-		message.set(value);
+		out = _protocolPutUInt(out, end, integer);
+		if (precision) {
+			char digits[8];
+			for (uint8_t i = precision; i > 0; i--) {
+				digits[i - 1] = '0' + (char)(decimals % 10u);
+				decimals /= 10u;
+			}
+			out = _protocolPutChar(out, end, '.');
+			out = _protocolPutBytes(out, end, digits, precision);
+		}
+		return out;
 	}
-	return (index == 5);
+#endif
+	// out of range for the fast path
+	char str[MAX_PAYLOAD_SIZE * 2 + 1];
+	(void)dtostrf(value, 2, precision, str);
+	return _protocolPutBytes(out, end, str, strlen(str));
+}
+
+static char *_protocolPutPayload(char *out, const char *end, const MyMessage &message)
+{
+	switch (message.getPayloadType()) {
+	case P_STRING: {
+		// the payload ends at the first zero byte
+		const char *str = message.data;
+		const char *zero = (const char *)memchr((const void *)str, 0, message.getLength());
+		return _protocolPutBytes(out, end, str, zero ? zero - str : message.getLength());
+	}
+	case P_BYTE:
+		return _protocolPutUInt(out, end, message.bValue);
+	case P_INT16:
+		return _protocolPutInt(out, end, message.iValue);
+	case P_UINT16:
+		return _protocolPutUInt(out, end, message.uiValue);
+	case P_LONG32:
+		return _protocolPutInt(out, end, message.lValue);
+	case P_ULONG32:
+		return _protocolPutUInt(out, end, message.ulValue);
+	case P_FLOAT32:
+		return _protocolPutFloat(out, end, message.fValue, min(message.fPrecision, (uint8_t)8u));
+	default:
+		return _protocolPutHex(out, end, (const uint8_t *)message.data, message.getLength());
+	}
+}
+
+uint8_t protocolFormatSerial(char *buffer, const uint8_t size, const MyMessage &message)
+{
+	const char *end = buffer + size - 1;
+	char *out = _protocolPutUInt(buffer, end, message.getSender());
+	out = _protocolPutChar(out, end, ';');
+	out = _protocolPutUInt(out, end, message.getSensor());
+	out = _protocolPutChar(out, end, ';');
+	out = _protocolPutUInt(out, end, message.getCommand());
+	out = _protocolPutChar(out, end, ';');
+	out = _protocolPutChar(out, end, message.isEcho() ? '1' : '0');
+	out = _protocolPutChar(out, end, ';');
+	out = _protocolPutUInt(out, end, message.getType());
+	out = _protocolPutChar(out, end, ';');
+	out = _protocolPutPayload(out, end, message);
+	out = _protocolPutChar(out, end, '\n');
+	*out = 0;
+	return out - buffer;
+}
+
+uint8_t protocolFormatMQTT(char *buffer, const uint8_t size, const char *prefix,
+                           const MyMessage &message)
+{
+	const char *end = buffer + size - 1;
+	char *out = _protocolPutBytes(buffer, end, prefix, strlen(prefix));
+	out = _protocolPutChar(out, end, '/');
+	out = _protocolPutUInt(out, end, message.getSender());
+	out = _protocolPutChar(out, end, '/');
+	out = _protocolPutUInt(out, end, message.getSensor());
+	out = _protocolPutChar(out, end, '/');
+	out = _protocolPutUInt(out, end, message.getCommand());
+	out = _protocolPutChar(out, end, '/');
+	out = _protocolPutChar(out, end, message.isEcho() ? '1' : '0');
+	out = _protocolPutChar(out, end, '/');
+	out = _protocolPutUInt(out, end, message.getType());
+	*out = 0;
+	return out - buffer;
+}
+
+uint8_t protocolFormatPayload(char *buffer, const uint8_t size, const MyMessage &message)
+{
+	char *out = _protocolPutPayload(buffer, buffer + size - 1, message);
+	*out = 0;
+	return out - buffer;
 }
 
 char *protocolMyMessage2Serial(const MyMessage &message)
 {
-	(void)snprintf_P(_fmtBuffer, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH,
-	                 PSTR("%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n"), message.getSender(),
-	                 message.getSensor(), message.getCommand(), message.isEcho(), message.getType(),
-	                 message.getString(_convBuffer));
+	(void)protocolFormatSerial(_fmtBuffer, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH, message);
 	return _fmtBuffer;
 }
 
 char *protocolMyMessage2MQTT(const char *prefix, const MyMessage &message)
 {
-	(void)snprintf_P(_fmtBuffer, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH,
-	                 PSTR("%s/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 ""), prefix,
-	                 message.getSender(), message.getSensor(), message.getCommand(), message.isEcho(),
-	                 message.getType());
+	(void)protocolFormatMQTT(_fmtBuffer, (uint8_t)MY_GATEWAY_MAX_SEND_LENGTH, prefix, message);
 	return _fmtBuffer;
 }
 
+// Decimal topic level of up to three digits, ended by terminator. Returns the next level, or
+// NULL if the level is malformed
+static const char *_protocolTopicLevel(const char *str, const char terminator, uint8_t &value)
+{
+	const char *start = str;
+	uint16_t result = 0;
+	while (*str >= '0' && *str <= '9' && str - start < 3) {
+		result = result * 10u + (uint8_t)(*str++ - '0');
+	}
+	if (str == start || *str != terminator || result > 0xFFu) {
+		return NULL;
+	}
+	value = (uint8_t)result;
+	return str + 1;
+}
 
 bool protocolMQTT2MyMessage(MyMessage &message, char *topic, uint8_t *payload,
                             const unsigned int length)
 {
-	char *str, *p;
-	uint8_t index = 0;
+	// the levels follow the subscribed prefix at a fixed offset
+	const uint8_t prefixLength = strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX);
+	if (memcmp(topic, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX, prefixLength) || topic[prefixLength] != '/') {
+		return false;
+	}
+	const char *str = topic + prefixLength + 1;
+	uint8_t destination, sensor, command, echo, type;
+	str = _protocolTopicLevel(str, '/', destination);
+	str = str ? _protocolTopicLevel(str, '/', sensor) : NULL;
+	str = str ? _protocolTopicLevel(str, '/', command) : NULL;
+	str = str ? _protocolTopicLevel(str, '/', echo) : NULL;
+	str = str ? _protocolTopicLevel(str, '\0', type) : NULL;
+	if (!str) {
+		return false;
+	}
 	message.setSender(GATEWAY_ADDRESS);
 	message.setLast(GATEWAY_ADDRESS);
 	message.setEcho(false);
-	for (str = strtok_r(topic + strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1, "/", &p);
-	        str && index < 5;
-	        str = strtok_r(NULL, "/", &p), index++
-	    ) {
-		switch (index) {
-		case 0:
-			// Node id
-			message.setDestination(atoi(str));
-			break;
-		case 1:
-			// Sensor id
-			message.setSensor(atoi(str));
-			break;
-		case 2: {
-			// Command type
-			const mysensors_command_t command = static_cast<mysensors_command_t>(atoi(str));
-			message.setCommand(command);
-			// Add payload
-			if (command == C_STREAM) {
-				uint8_t bvalue[MAX_PAYLOAD_SIZE];
-				uint8_t blen = 0;
-				while (*payload) {
-					uint8_t val;
-					val = convertH2I(*payload++) << 4;
-					val += convertH2I(*payload++);
-					bvalue[blen] = val;
-					blen++;
-				}
-				message.set(bvalue, blen);
-			} else {
-				// terminate string
-				char *value = (char *)payload;
-				value[length] = '\0';
-				message.set((const char*)payload);
-			}
-			break;
-		}
-		case 3:
-			// Echo flag
-			message.setRequestEcho(atoi(str) ? 1 : 0);
-			break;
-		case 4:
-			// Sub type
-			message.setType(atoi(str));
-			break;
+	message.setDestination(destination);
+	message.setSensor(sensor);
+	message.setCommand(static_cast<mysensors_command_t>(command));
+	message.setRequestEcho(echo ? 1 : 0);
+	message.setType(type);
+	// Add payload
+	if (command == C_STREAM) {
+		uint8_t bvalue[MAX_PAYLOAD_SIZE];
+		uint8_t blen = 0;
+		for (unsigned int i = 0; i + 1 < length && blen < MAX_PAYLOAD_SIZE; i += 2) {
+			bvalue[blen++] = (convertH2I(payload[i]) << 4) + convertH2I(payload[i + 1]);
 		}
+		message.set(bvalue, blen);
+	} else {
+		// terminate string
+		char *value = (char *)payload;
+		value[length] = '\0';
+		message.set((const char*)payload);
 	}
-	// Return true if input valid
-	return (index == 5);
+	return true;
 }
@@ -22,16 +22,61 @@
 
 #include "MySensorsCore.h"
 
+/**
+ * @brief State of the streaming serial protocol parser, one per input stream
+ *
+ * A zero-initialised parser is in the reset state.
+ */
+typedef struct {
+	uint8_t field;         //!< Index of the field being decoded, 5 is the payload
+	uint8_t value;         //!< Value of the numeric field being decoded
+	uint16_t length;       //!< Number of characters consumed on the current line
+	uint8_t payloadLength; //!< Number of payload characters (hex digits for C_STREAM) stored
+	bool token;            //!< Current field has at least one character
+	bool text;             //!< Current numeric field has seen a non-digit character
+	bool skip;             //!< Ignore the remaining characters of the current line
+	bool overflow;         //!< Current line exceeds MY_GATEWAY_MAX_RECEIVE_LENGTH
+} protocolSerialParser_t;
+
+// reset(parser)
+// discard any partially received line
+void protocolSerialParserReset(protocolSerialParser_t &parser);
+
+// parse(parser, message, inChar)
+// feed one character of the serial protocol into the parser, decoding fields
+// straight into message. A line ends with '\n' or '\r'
+// returns true if a complete message was decoded into message
+bool protocolSerialParse(protocolSerialParser_t &parser, MyMessage &message, const char inChar);
+
 // parse(message, inputString)
 // parse a string into a message element
 // returns true if successfully parsed the input string
 bool protocolSerial2MyMessage(MyMessage &message, char *inputString);
 
-// Format MyMessage to the protocol representation
+// formatSerial(buffer, size, message)
+// format message to the serial protocol representation, including the line feed.
+// The output is truncated to size - 1 characters and zero terminated
+// returns the number of characters written
+uint8_t protocolFormatSerial(char *buffer, const uint8_t size, const MyMessage &message);
+
+// formatMQTT(buffer, size, prefix, message)
+// format the MQTT topic of message, see protocolFormatSerial()
+uint8_t protocolFormatMQTT(char *buffer, const uint8_t size, const char *prefix,
+                           const MyMessage &message);
+
+// formatPayload(buffer, size, message)
+// format the payload of message, see protocolFormatSerial()
+uint8_t protocolFormatPayload(char *buffer, const uint8_t size, const MyMessage &message);
+
+// Format MyMessage to the protocol representation, in a shared buffer
 char *protocolMyMessage2Serial(const MyMessage &message);
 
 char *protocolMyMessage2MQTT(const char *prefix, const MyMessage &message);
 
+// MQTT2MyMessage(message, topic, payload, length)
+// decode a message received on MY_MQTT_SUBSCRIBE_TOPIC_PREFIX/NODE/SENSOR/CMD/ECHO/TYPE, the
+// levels are decimal numbers 0..255. payload[length] is overwritten with a terminator
+// returns false if the topic does not match
 bool protocolMQTT2MyMessage(MyMessage &message, char *topic, uint8_t *payload,
                             const unsigned int length);
 
@@ -77,8 +77,13 @@ void _process(void)
 #endif
 
 #if defined(__linux__)
-	// To avoid high cpu usage
-	usleep(10000); // 10ms
+	// Sleep until the controller, the radio or a pending timer needs attention
+#if defined(MY_SENSOR_NETWORK)
+	if (!transportHALDataAvailable())
+#endif
+	{
+		(void)eventLoopWait(MY_LINUX_EVENT_LOOP_TIMEOUT_MS);
+	}
 #endif
 #if defined(MY_DEBUG_VERBOSE_CORE)
 	processLock--;
@@ -563,6 +568,9 @@ void wait(const uint32_t waitingMS)
 #endif
 	const uint32_t enteringMS = hwMillis();
 	while (hwMillis() - enteringMS < waitingMS) {
+#if defined(__linux__)
+		eventLoopWakeupIn(waitingMS - (hwMillis() - enteringMS));
+#endif
 		_process();
 	}
 #if defined(MY_DEBUG_VERBOSE_CORE)
@@ -584,6 +592,9 @@ bool wait(const uint32_t waitingMS, const mysensors_command_t cmd)
 	_msg.setCommand(C_INVALID_7);
 	bool expectedResponse = false;
 	while ((hwMillis() - enteringMS < waitingMS) && !expectedResponse) {
+#if defined(__linux__)
+		eventLoopWakeupIn(waitingMS - (hwMillis() - enteringMS));
+#endif
 		_process();
 		expectedResponse = (_msg.getCommand() == cmd);
 	}
@@ -607,6 +618,9 @@ bool wait(const uint32_t waitingMS, const mysensors_command_t cmd, const uint8_t
 	_msg.setCommand(C_INVALID_7);
 	bool expectedResponse = false;
 	while ( (hwMillis() - enteringMS < waitingMS) && !expectedResponse ) {
+#if defined(__linux__)
+		eventLoopWakeupIn(waitingMS - (hwMillis() - enteringMS));
+#endif
 		_process();
 		expectedResponse = (_msg.getCommand() == cmd && _msg.getType() == msgType);
 	}
@@ -804,7 +818,7 @@ void _nodeLock(const char *str)
 		doYield();
 		(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID,C_INTERNAL, I_LOCKED).set(str));
 #if defined(MY_SENSOR_NETWORK)
-		transportSleep();
+		transportHALSleep();
 		CORE_DEBUG(PSTR("MCO:NLK:TSL\n"));	// sleep transport
 #endif
 		setIndication(INDICATION_SLEEP);
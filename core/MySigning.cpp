@@ -28,6 +28,11 @@
 #else
 #define SIGN_DEBUG(x,...)
 #endif
+#if defined(MY_DEBUG_VERBOSE_SIGNING) && defined(MY_DEBUG_EVENTS)
+#define SIGN_EVENT_OR_DEBUG(event,x,...) debugEvent<DEBUG_SUBSYSTEM_SIGNING> event
+#else
+#define SIGN_EVENT_OR_DEBUG(event,x,...) SIGN_DEBUG(x, ##__VA_ARGS__)
+#endif
 
 #if defined(MY_SIGNING_REQUEST_SIGNATURES) &&\
     (!defined(MY_SIGNING_ATSHA204) && !defined(MY_SIGNING_SOFT))
@@ -217,7 +222,8 @@ bool signerSignMsg(MyMessage &msg)
 					           msg.getDestination()); // Failed to transmit nonce request!
 					ret = false;
 				} else {
-					SIGN_DEBUG(PSTR("SGN:SGN:NCE REQ,TO=%" PRIu8 "\n"), msg.getDestination()); // Nonce requested
+					SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_SGN_NCE_REQ, msg.getDestination()),
+					                    PSTR("SGN:SGN:NCE REQ,TO=%" PRIu8 "\n"), msg.getDestination()); // Nonce requested
 					// We have to wait for the nonce to arrive before we can sign our original message
 					// Other messages could come in-between. We trust _process() takes care of them
 					unsigned long enter = hwMillis();
@@ -233,7 +239,7 @@ bool signerSignMsg(MyMessage &msg)
 						if (_signingNonceStatus == SIGN_OK) {
 							// process() received a nonce and signerProcessInternal successfully signed the message
 							msg = _msgSign; // Write the signed message back
-							SIGN_DEBUG(PSTR("SGN:SGN:SGN\n")); // Message to send has been signed
+							SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_SGN_SGN), PSTR("SGN:SGN:SGN\n")); // Message to send has been signed
 							ret = true;
 							// After this point, only the 'last' member of the message structure is allowed to be
 							// altered if the message has been signed, or signature will become invalid and the
@@ -248,12 +254,13 @@ bool signerSignMsg(MyMessage &msg)
 		}
 	} else if (getNodeId() == msg.getSender()) {
 		msg.setSigned(false); // Message is not supposed to be signed, make sure it is marked unsigned
-		SIGN_DEBUG(PSTR("SGN:SGN:NREQ=%" PRIu8 "\n"),
-		           msg.getDestination()); // Do not sign message as it is not req
+		SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_SGN_NREQ, msg.getDestination()), PSTR("SGN:SGN:NREQ=%" PRIu8 "\n"),
+		                    msg.getDestination()); // Do not sign message as it is not req
 		ret = true;
 	} else {
-		SIGN_DEBUG(PSTR("SGN:SGN:%" PRIu8 "!=%" PRIu8 " NUS\n"), msg.getSender(),
-		           getNodeId()); // Will not sign message since it was from someone else
+		SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_SGN_NUS, msg.getSender(), getNodeId()),
+		                    PSTR("SGN:SGN:%" PRIu8 "!=%" PRIu8 " NUS\n"), msg.getSender(),
+		                    getNodeId()); // Will not sign message since it was from someone else
 		ret = true;
 	}
 	return ret;
@@ -296,7 +303,7 @@ bool signerVerifyMsg(MyMessage &msg)
 					SIGN_DEBUG(PSTR("!SGN:VER:FAIL\n")); // Signature verification failed!
 					verificationResult = false;
 				} else {
-					SIGN_DEBUG(PSTR("SGN:VER:OK\n"));
+					SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_VER_OK), PSTR("SGN:VER:OK\n"));
 				}
 			}
 #if defined(MY_NODE_LOCK_FEATURE)
@@ -377,9 +384,10 @@ static bool skipSign(MyMessage &msg)
 		ret = true;
 	}
 	if (ret) {
-		SIGN_DEBUG(PSTR("SGN:SKP:%s CMD=%" PRIu8 ",TYPE=%" PRIu8 "\n"), msg.isEcho() ? "ECHO" : "MSG",
-		           msg.getCommand(),
-		           msg.getType()); //Skip signing/verification of this message
+		SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_SKP, (uint8_t)msg.isEcho(), (uint8_t)msg.getCommand(), msg.getType()),
+		                    PSTR("SGN:SKP:%s CMD=%" PRIu8 ",TYPE=%" PRIu8 "\n"), msg.isEcho() ? "ECHO" : "MSG",
+		                    msg.getCommand(),
+		                    msg.getType()); //Skip signing/verification of this message
 	}
 	return ret;
 }
@@ -518,8 +526,9 @@ static bool signerInternalProcessNonceRequest(MyMessage &msg)
 #if defined(MY_SIGNING_FEATURE)
 #if defined(MY_NODE_LOCK_FEATURE)
 	nof_nonce_requests++;
-	SIGN_DEBUG(PSTR("SGN:NCE:LEFT=%" PRIu8 "\n"),
-	           MY_NODE_LOCK_COUNTER_MAX-nof_nonce_requests); // Nonce requests left until lockdown
+	SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_NCE_LEFT, (uint8_t)(MY_NODE_LOCK_COUNTER_MAX-nof_nonce_requests)),
+	                    PSTR("SGN:NCE:LEFT=%" PRIu8 "\n"),
+	                    MY_NODE_LOCK_COUNTER_MAX-nof_nonce_requests); // Nonce requests left until lockdown
 	if (nof_nonce_requests >= MY_NODE_LOCK_COUNTER_MAX) {
 		_nodeLock("TMNR"); // Too many nonces requested
 	}
@@ -528,7 +537,8 @@ static bool signerInternalProcessNonceRequest(MyMessage &msg)
 		if (!_sendRoute(build(msg, msg.getSender(), NODE_SENSOR_ID, C_INTERNAL, I_NONCE_RESPONSE))) {
 			SIGN_DEBUG(PSTR("!SGN:NCE:XMT,TO=%" PRIu8 " FAIL\n"), msg.getSender()); // Failed to transmit nonce!
 		} else {
-			SIGN_DEBUG(PSTR("SGN:NCE:XMT,TO=%" PRIu8 "\n"), msg.getSender());
+			SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_NCE_XMT, msg.getSender()), PSTR("SGN:NCE:XMT,TO=%" PRIu8 "\n"),
+			                    msg.getSender());
 		}
 	} else {
 		SIGN_DEBUG(PSTR("!SGN:NCE:GEN\n")); // Failed to generate nonce!
@@ -547,7 +557,8 @@ static bool signerInternalProcessNonceResponse(MyMessage &msg)
 {
 #if defined(MY_SIGNING_FEATURE)
 	// Proceed with signing if nonce has been received
-	SIGN_DEBUG(PSTR("SGN:NCE:FROM=%" PRIu8 "\n"), msg.getSender());
+	SIGN_EVENT_OR_DEBUG((DEBUG_EVENT_SGN_NCE_FROM, msg.getSender()), PSTR("SGN:NCE:FROM=%" PRIu8 "\n"),
+	                    msg.getSender());
 	if (msg.getSender() != _msgSign.getDestination()) {
 		SIGN_DEBUG(PSTR("SGN:NCE:%" PRIu8 "!=%" PRIu8 " (DROPPED)\n"), _msgSign.getDestination(),
 		           msg.getSender());
@@ -725,6 +725,24 @@ bool signerVerifyMsg(MyMessage &msg);
  */
 int signerMemcmp(const void* a, const void* b, size_t sz);
 
+#if defined(MY_SIGNING_NODE_WHITELISTING) && defined(__linux__)
+/**
+ * @brief Restore the whitelist to the entries of @ref MY_SIGNING_NODE_WHITELISTING.
+ *
+ * On Linux the whitelist of the soft signing backend is a table indexed by node id, so the
+ * lookup cost does not depend on the number of entries and entries can be changed at runtime.
+ */
+void signerWhitelistReset(void);
+
+/**
+ * @brief Add a node to the whitelist or replace its serial.
+ *
+ * @param nodeId The ID of the node.
+ * @param serial Node specific serial number (SHA204_SERIAL_SZ bytes).
+ */
+void signerWhitelistSet(const uint8_t nodeId, const uint8_t *serial);
+#endif
+
 #endif
 /** @}*/
 
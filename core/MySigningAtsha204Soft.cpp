@@ -40,8 +40,10 @@
 #define SIGN_DEBUG(x,...)
 #endif
 
+#if !defined(__linux__)
 static unsigned long _signing_timestamp;
 static bool _signing_verification_ongoing = false;
+#endif
 static bool _signing_init_ok = false;
 static uint8_t _signing_verifying_nonce[32+9+1];
 static uint8_t _signing_nonce[32+9+1];
@@ -49,13 +51,66 @@ static uint8_t _signing_hmac_key[SIZE_SIGNING_SOFT_HMAC_KEY];
 static uint8_t _signing_hmac[32];
 static uint8_t _signing_node_serial_info[SIZE_SIGNING_SOFT_SERIAL];
 
+#if defined(__linux__)
+// Outstanding nonces indexed by the node id they were handed out to, so that any number of
+// nodes can have a verification ongoing at the same time. The bitfield tells which are active.
+typedef struct {
+	uint8_t nonce[32];
+	unsigned long timestamp;
+} signing_session_t;
+static signing_session_t _signing_session[256];
+static uint8_t _signing_session_active[256 / 8];
+static uint16_t _signing_session_count = 0;
+#endif
+
 #ifdef MY_SIGNING_NODE_WHITELISTING
 static const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
+#if defined(__linux__)
+// Whitelist indexed by node id, the bitfield tells which entries are set
+static uint8_t _signing_whitelist_serial[256][SIZE_SIGNING_SOFT_SERIAL];
+static uint8_t _signing_whitelist_set[256 / 8];
+#endif
 #endif
 
 static void signerCalculateSignature(MyMessage &msg, const bool signing);
 static void signerAtsha204AHmac(uint8_t *dest, const uint8_t *nonce, const uint8_t *data);
 
+#ifdef MY_SIGNING_NODE_WHITELISTING
+#if defined(__linux__)
+void signerWhitelistReset(void)
+{
+	(void)memset((void *)_signing_whitelist_set, 0, sizeof(_signing_whitelist_set));
+	for (size_t j = 0; j < NUM_OF(_signing_whitelist); j++) {
+		signerWhitelistSet(_signing_whitelist[j].nodeId, _signing_whitelist[j].serial);
+	}
+}
+
+void signerWhitelistSet(const uint8_t nodeId, const uint8_t *serial)
+{
+	(void)memcpy((void *)_signing_whitelist_serial[nodeId], (const void *)serial,
+	             SIZE_SIGNING_SOFT_SERIAL);
+	_signing_whitelist_set[nodeId >> 3] |= (1 << (nodeId & 0x07));
+}
+#endif
+
+// Returns the serial whitelisted for nodeId or NULL if the node is not whitelisted
+static const uint8_t *signerWhitelistLookup(const uint8_t nodeId)
+{
+#if defined(__linux__)
+	if (_signing_whitelist_set[nodeId >> 3] & (1 << (nodeId & 0x07))) {
+		return _signing_whitelist_serial[nodeId];
+	}
+#else
+	for (size_t j = 0; j < NUM_OF(_signing_whitelist); j++) {
+		if (_signing_whitelist[j].nodeId == nodeId) {
+			return _signing_whitelist[j].serial;
+		}
+	}
+#endif
+	return NULL;
+}
+#endif
+
 bool signerAtsha204SoftInit(void)
 {
 	_signing_init_ok = true;
@@ -95,14 +150,48 @@ bool signerAtsha204SoftInit(void)
 			(void)memcpy((void *)_signing_node_serial_info, (const void *)uniqueID, SIZE_SIGNING_SOFT_SERIAL);
 		}
 	}
+#if defined(MY_SIGNING_NODE_WHITELISTING) && defined(__linux__)
+	signerWhitelistReset();
+#endif
 	return _signing_init_ok;
 }
 
+#if defined(__linux__)
+static void signerSessionPurge(const uint8_t nodeId)
+{
+	(void)memset((void *)_signing_session[nodeId].nonce, 0xAA, sizeof(_signing_session[nodeId].nonce));
+	_signing_session_active[nodeId >> 3] &= ~(1 << (nodeId & 0x07));
+	_signing_session_count--;
+}
+
+static bool signerSessionExpired(const uint8_t nodeId)
+{
+	return hwMillis() - _signing_session[nodeId].timestamp > MY_VERIFICATION_TIMEOUT_MS;
+}
+#endif
+
 bool signerAtsha204SoftCheckTimer(void)
 {
 	if (!_signing_init_ok) {
 		return false;
 	}
+#if defined(__linux__)
+	bool ret = true;
+	for (uint16_t i = 0; _signing_session_count && i < sizeof(_signing_session_active); i++) {
+		if (!_signing_session_active[i]) {
+			continue;
+		}
+		for (uint8_t j = 0; j < 8; j++) {
+			const uint8_t nodeId = (uint8_t)(i * 8 + j);
+			if ((_signing_session_active[i] & (1 << j)) && signerSessionExpired(nodeId)) {
+				SIGN_DEBUG(PSTR("!SGN:BND:TMR,ID=%" PRIu8 "\n"), nodeId); //Verification timeout
+				signerSessionPurge(nodeId);
+				ret = false;
+			}
+		}
+	}
+	return ret;
+#else
 	if (_signing_verification_ongoing) {
 		unsigned long time_now = hwMillis();
 		// If timestamp is taken so late a rollover can take place during the timeout,
@@ -122,6 +211,7 @@ bool signerAtsha204SoftCheckTimer(void)
 		}
 	}
 	return true;
+#endif
 }
 
 bool signerAtsha204SoftGetNonce(MyMessage &msg)
@@ -150,6 +240,19 @@ bool signerAtsha204SoftGetNonce(MyMessage &msg)
 
 	// Transfer the first part of the nonce to the message
 	msg.set(_signing_verifying_nonce, MIN((uint8_t)MAX_PAYLOAD_SIZE, (uint8_t)32));
+#if defined(__linux__)
+	// msg still holds the nonce request, so the sender is the node the nonce is meant for.
+	// A new request from the same node replaces its previous nonce.
+	const uint8_t nodeId = msg.getSender();
+	(void)memcpy((void *)_signing_session[nodeId].nonce, (const void *)_signing_verifying_nonce, 32);
+	(void)memset((void *)_signing_verifying_nonce, 0xAA, sizeof(_signing_verifying_nonce));
+	_signing_session[nodeId].timestamp = hwMillis();
+	if (!(_signing_session_active[nodeId >> 3] & (1 << (nodeId & 0x07)))) {
+		_signing_session_active[nodeId >> 3] |= (1 << (nodeId & 0x07));
+		_signing_session_count++;
+	}
+	return true;
+#else
 	_signing_verification_ongoing = true;
 	_signing_timestamp = hwMillis(); // Set timestamp to determine when to purge nonce
 	// Be a little fancy to handle turnover (prolong the time allowed to timeout after turnover)
@@ -159,6 +262,7 @@ bool signerAtsha204SoftGetNonce(MyMessage &msg)
 		_signing_timestamp = 0;
 	}
 	return true;
+#endif
 }
 
 // cppcheck-suppress constParameter
@@ -215,6 +319,23 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg)
 
 bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 {
+#if defined(__linux__)
+	const uint8_t sender = msg.getSender();
+	if (!(_signing_session_active[sender >> 3] & (1 << (sender & 0x07)))) {
+		SIGN_DEBUG(PSTR("!SGN:BND:VER ONGOING,ID=%" PRIu8 "\n"), sender);
+		return false;
+	} else {
+		// Make sure we have not expired
+		if (signerSessionExpired(sender)) {
+			SIGN_DEBUG(PSTR("!SGN:BND:TMR,ID=%" PRIu8 "\n"), sender); //Verification timeout
+			signerSessionPurge(sender);
+			return false;
+		}
+
+		// Each nonce is only good for one message
+		(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_session[sender].nonce, 32);
+		signerSessionPurge(sender);
+#else
 	if (!_signing_verification_ongoing) {
 		SIGN_DEBUG(PSTR("!SGN:BND:VER ONGOING\n"));
 		return false;
@@ -225,6 +346,7 @@ bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 		}
 
 		_signing_verification_ongoing = false;
+#endif
 
 		if (msg.data[msg.getLength()] != SIGNING_IDENTIFIER) {
 			SIGN_DEBUG(PSTR("!SGN:BND:VER,IDENT=%" PRIu8 "\n"), msg.data[msg.getLength()]);
@@ -235,26 +357,21 @@ bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 
 #ifdef MY_SIGNING_NODE_WHITELISTING
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j = 0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.getSender()) {
-				// We can reuse the nonce buffer now since it is no longer needed
-				(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, 32);
-				_signing_verifying_nonce[32] = msg.getSender();
-				(void)memcpy((void *)&_signing_verifying_nonce[33], (const void *)_signing_whitelist[j].serial, 9);
-				SHA256(_signing_hmac, _signing_verifying_nonce, 32+1+9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.getSender());
-#ifdef MY_DEBUG_VERBOSE_SIGNING
-				hwDebugBuf2Str(_signing_whitelist[j].serial, 9);
-				SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
-#endif
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		const uint8_t *serial = signerWhitelistLookup(msg.getSender());
+		if (serial == NULL) {
 			SIGN_DEBUG(PSTR("!SGN:BND:VER WHI,ID=%" PRIu8 " MISSING\n"), msg.getSender());
 			return false;
 		}
+		// We can reuse the nonce buffer now since it is no longer needed
+		(void)memcpy((void *)_signing_verifying_nonce, (const void *)_signing_hmac, 32);
+		_signing_verifying_nonce[32] = msg.getSender();
+		(void)memcpy((void *)&_signing_verifying_nonce[33], (const void *)serial, 9);
+		SHA256(_signing_hmac, _signing_verifying_nonce, 32+1+9);
+		SIGN_DEBUG(PSTR("SGN:BND:VER WHI,ID=%" PRIu8 "\n"), msg.getSender());
+#ifdef MY_DEBUG_VERBOSE_SIGNING
+		hwDebugBuf2Str(serial, 9);
+		SIGN_DEBUG(PSTR("SGN:BND:VER WHI,SERIAL=%s\n"), hwDebugPrintStr);
+#endif
 #endif
 
 		// Overwrite the first byte in the signature with the signing identifier
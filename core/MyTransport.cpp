@@ -26,6 +26,11 @@ extern char _convBuf[MAX_PAYLOAD_SIZE * 2 + 1];
 #else
 #define TRANSPORT_DEBUG(x,...)	//!< debug NULL
 #endif
+#if defined(MY_DEBUG_VERBOSE_TRANSPORT) && defined(MY_DEBUG_EVENTS)
+#define TRANSPORT_EVENT_OR_DEBUG(event,x,...) debugEvent<DEBUG_SUBSYSTEM_TRANSPORT> event	//!< debug event (ID, arguments)
+#else
+#define TRANSPORT_EVENT_OR_DEBUG(event,x,...) TRANSPORT_DEBUG(x, ##__VA_ARGS__)	//!< debug text instead of event
+#endif
 
 
 // SM: transitions and update states
@@ -59,6 +64,10 @@ static routingTable_t _transportRoutingTable;		//!< routing table
 static uint32_t _lastRoutingTableSave;			//!< last routing table dump
 #endif
 
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+static uint8_t _transportRadio[SIZE_ROUTES];	//!< radio of each neighbour + 1, 0 if not known
+#endif
+
 // regular sanity check, activated by default on GW and repeater nodes
 #if defined(MY_TRANSPORT_SANITY_CHECK)
 static uint32_t _lastSanityCheck;		//!< last sanity check
@@ -70,6 +79,16 @@ static uint32_t _lastSanityCheck;		//!< last sanity check
 static uint32_t _lastNetworkDiscovery;	//!< last network discovery
 #endif
 
+// outgoing messages, sent one at a time from transportProcess()
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+static transportTxQueueEntry_t _transportTxQueue[MY_TRANSPORT_TX_QUEUE_SIZE];	//!< TX queue
+static transportTxCallback_t _transportTx_cb = NULL;	//!< sent/dropped callback
+static uint16_t _transportTxQueueSeq = 0;			//!< sequence of next queued message
+static uint8_t _transportTxQueueNext = 0;			//!< round-robin start index
+static bool _transportTxQueueActive = false;	//!< reentrancy guard, signing processes messages
+static bool _transportTxQueueSending = false;	//!< sending a queued message, one transmission per attempt
+#endif
+
 // stInit: initialise transport HW
 void stInitTransition(void)
 {
@@ -464,6 +483,10 @@ void transportProcess(void)
 	transportUpdateSM();
 	// process transport FIFO
 	transportProcessFIFO();
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+	// send queued messages
+	transportProcessTxQueue();
+#endif
 }
 
 bool transportCheckUplink(const bool force)
@@ -663,11 +686,15 @@ void transportProcessMessage(void)
 	const uint8_t last = _msg.getLast();
 	const uint8_t destination = _msg.getDestination();
 
-	TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%" PRIu8 ",t=%"
-	                     PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ":%s\n"),
-	                sender, last, destination, _msg.getSensor(), command, type, _msg.getPayloadType(), msgLength,
-	                _msg.getSigned(), ((command == C_INTERNAL &&
-	                                    type == I_NONCE_RESPONSE) ? "<NONCE>" : _msg.getString(_convBuf)));
+	TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_READ, sender, last, destination, _msg.getSensor(), command,
+	                          type, (uint8_t)_msg.getPayloadType(), msgLength, (uint8_t)_msg.getSigned(),
+	                          debugEventBytes_t { _msg.data, (uint8_t)((command == C_INTERNAL &&
+	                                              type == I_NONCE_RESPONSE) ? 0u : msgLength) }),
+	                         PSTR("TSF:MSG:READ,%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%" PRIu8 ",t=%"
+	                              PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ":%s\n"),
+	                         sender, last, destination, _msg.getSensor(), command, type, _msg.getPayloadType(),
+	                         msgLength, _msg.getSigned(), ((command == C_INTERNAL &&
+	                                 type == I_NONCE_RESPONSE) ? "<NONCE>" : _msg.getString(_convBuf)));
 
 	// Reject messages that do not pass verification
 	if (!signerVerifyMsg(_msg)) {
@@ -692,6 +719,11 @@ void transportProcessMessage(void)
 	}
 #endif // MY_REPEATER_FEATURE
 
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	// the neighbour is reached on the radio it sent from
+	transportSetRadio(last, transportHALGetReceivingRadio());
+#endif
+
 	// set message received flag
 	_transportSM.msgReceived = true;
 
@@ -701,7 +733,7 @@ void transportProcessMessage(void)
 		_msg.data[msgLength] = 0u;
 		// Check if sender requests an echo.
 		if (_msg.getRequestEcho()) {
-			TRANSPORT_DEBUG(PSTR("TSF:MSG:ECHO REQ\n"));	// ECHO requested
+			TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_ECHO_REQ), PSTR("TSF:MSG:ECHO REQ\n"));	// ECHO requested
 			_msgTmp = _msg;	// Copy message
 			// Reply without echo flag (otherwise we would end up in an eternal loop)
 			_msgTmp.setRequestEcho(false);
@@ -814,8 +846,8 @@ void transportProcessMessage(void)
 #endif
 			}
 		} else {
-			TRANSPORT_DEBUG(
-			    PSTR("TSF:MSG:ECHO\n")); // received message is ECHO, no internal processing, handover to msg callback
+			TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_ECHO),
+			                         PSTR("TSF:MSG:ECHO\n")); // received message is ECHO, no internal processing, handover to msg callback
 		}
 #if defined(MY_OTA_LOG_RECEIVER_FEATURE)
 		if ((type == I_LOG_MESSAGE) && (command == C_INTERNAL)) {
@@ -832,7 +864,7 @@ void transportProcessMessage(void)
 			receive(_msg);
 		}
 	} else if (destination == BROADCAST_ADDRESS) {
-		TRANSPORT_DEBUG(PSTR("TSF:MSG:BC\n"));	// broadcast msg
+		TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_BC), PSTR("TSF:MSG:BC\n"));	// broadcast msg
 		if (command == C_INTERNAL) {
 			if (isTransportReady()) {
 				// only reply if node is fully operational
@@ -895,7 +927,7 @@ void transportProcessMessage(void)
 			(void)gatewayTransportSend(_msg);
 #endif
 			if (receive) {
-				TRANSPORT_DEBUG(PSTR("TSF:MSG:RCV CB\n")); // hand over message to receive callback function
+				TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_RCV_CB), PSTR("TSF:MSG:RCV CB\n")); // hand over message to receive callback function
 				receive(_msg);
 			}
 		}
@@ -915,7 +947,7 @@ void transportProcessMessage(void)
 				}
 			}
 			// Relay this message to another node
-			TRANSPORT_DEBUG(PSTR("TSF:MSG:REL MSG\n"));	// relay msg
+			TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_REL_MSG), PSTR("TSF:MSG:REL MSG\n"));	// relay msg
 			(void)transportRouteMessage(_msg);
 		}
 #else
@@ -981,21 +1013,35 @@ bool transportSendWrite(const uint8_t to, MyMessage &message)
 	const bool noACK = _transportConfig.passiveMode || (to == BROADCAST_ADDRESS);
 	// send
 	setIndication(INDICATION_TX);
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+	// the TX queue retries by itself, the driver must not block the loop with its own retries
+	const bool result = _transportTxQueueSending ? transportHALSendOnce(to, &message, totalMsgLength,
+	                    noACK) : transportHALSend(to, &message, totalMsgLength, noACK);
+#else
 	const bool result = transportHALSend(to, &message, totalMsgLength,
 	                                     noACK);
+#endif
 
-	TRANSPORT_DEBUG(PSTR("%sTSF:MSG:SEND,%" PRIu8 "-%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%"
-	                     PRIu8 ",t=%" PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ",ft=%" PRIu8 ",st=%s:%s\n"),
-	                (noACK ? "?" : result ? "" : "!"), message.getSender(), message.getLast(),
-	                to,
-	                message.getDestination(),
-	                message.getSensor(),
-	                message.getCommand(), message.getType(),
-	                message.getPayloadType(), message.getLength(), message.getSigned(),
-	                _transportSM.failedUplinkTransmissions,
-	                (result ? "OK" : "NACK"),
-	                ((message.getCommand() == C_INTERNAL &&
-	                  message.getType() == I_NONCE_RESPONSE) ? "<NONCE>" : message.getString(_convBuf)));
+	TRANSPORT_EVENT_OR_DEBUG((DEBUG_EVENT_TSF_MSG_SEND,
+	                          (uint8_t)((noACK ? DEBUG_EVENT_SEND_NOACK : 0u) | (result ? 0u : DEBUG_EVENT_SEND_NACK)),
+	                          message.getSender(), message.getLast(), to, message.getDestination(), message.getSensor(),
+	                          (uint8_t)message.getCommand(), message.getType(), (uint8_t)message.getPayloadType(),
+	                          message.getLength(), (uint8_t)message.getSigned(),
+	                          (uint8_t)_transportSM.failedUplinkTransmissions,
+	                          debugEventBytes_t { message.data, (uint8_t)((message.getCommand() == C_INTERNAL &&
+	                                              message.getType() == I_NONCE_RESPONSE) ? 0u : message.getLength()) }),
+	                         PSTR("%sTSF:MSG:SEND,%" PRIu8 "-%" PRIu8 "-%" PRIu8 "-%" PRIu8 ",s=%" PRIu8 ",c=%"
+	                              PRIu8 ",t=%" PRIu8 ",pt=%" PRIu8 ",l=%" PRIu8 ",sg=%" PRIu8 ",ft=%" PRIu8 ",st=%s:%s\n"),
+	                         (noACK ? "?" : result ? "" : "!"), message.getSender(), message.getLast(),
+	                         to,
+	                         message.getDestination(),
+	                         message.getSensor(),
+	                         message.getCommand(), message.getType(),
+	                         message.getPayloadType(), message.getLength(), message.getSigned(),
+	                         _transportSM.failedUplinkTransmissions,
+	                         (result ? "OK" : "NACK"),
+	                         ((message.getCommand() == C_INTERNAL &&
+	                           message.getType() == I_NONCE_RESPONSE) ? "<NONCE>" : message.getString(_convBuf)));
 
 	return result;
 }
@@ -1005,6 +1051,114 @@ void transportRegisterReadyCallback(transportCallback_t cb)
 	_transportReady_cb = cb;
 }
 
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+bool transportQueueSend(MyMessage &message)
+{
+	const uint8_t destination = message.getDestination();
+	uint8_t freeSlot = MY_TRANSPORT_TX_QUEUE_SIZE;
+	uint8_t queued = 0;
+	uint8_t queuedToDestination = 0;
+	for (uint8_t i = 0; i < MY_TRANSPORT_TX_QUEUE_SIZE; i++) {
+		if (_transportTxQueue[i].used) {
+			queued++;
+			if (_transportTxQueue[i].message.getDestination() == destination) {
+				queuedToDestination++;
+			}
+		} else if (freeSlot == MY_TRANSPORT_TX_QUEUE_SIZE) {
+			freeSlot = i;
+		}
+	}
+	if (freeSlot == MY_TRANSPORT_TX_QUEUE_SIZE || queuedToDestination >= MY_TRANSPORT_TX_QUEUE_PER_NODE) {
+		TRANSPORT_DEBUG(PSTR("!TSF:TXQ:FULL,TO=%" PRIu8 "\n"), destination);
+		return false;
+	}
+	transportTxQueueEntry_t *entry = &_transportTxQueue[freeSlot];
+	(void)memcpy((void *)&entry->message, (const void *)&message, sizeof(MyMessage));
+	entry->due = hwMillis();
+	entry->seq = _transportTxQueueSeq++;
+	entry->attempts = 0;
+	entry->used = true;
+	TRANSPORT_DEBUG(PSTR("TSF:TXQ:ADD,TO=%" PRIu8 ",N=%" PRIu8 "\n"), destination, queued + 1);
+	return true;
+}
+
+// true if no older message to the same destination is queued
+static bool transportTxQueueIsHead(const uint8_t index)
+{
+	const transportTxQueueEntry_t *entry = &_transportTxQueue[index];
+	for (uint8_t i = 0; i < MY_TRANSPORT_TX_QUEUE_SIZE; i++) {
+		if (_transportTxQueue[i].used &&
+		        _transportTxQueue[i].message.getDestination() == entry->message.getDestination() &&
+		        (int16_t)(_transportTxQueue[i].seq - entry->seq) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void transportProcessTxQueue(void)
+{
+	if (_transportTxQueueActive || !isTransportReady()) {
+		return;
+	}
+	_transportTxQueueActive = true;
+	const uint32_t now = hwMillis();
+	// pick the next due message round-robin, only the oldest per destination is eligible
+	for (uint8_t n = 0; n < MY_TRANSPORT_TX_QUEUE_SIZE; n++) {
+		const uint8_t i = (_transportTxQueueNext + n) % MY_TRANSPORT_TX_QUEUE_SIZE;
+		transportTxQueueEntry_t *entry = &_transportTxQueue[i];
+		if (!entry->used || (int32_t)(now - entry->due) < 0 || !transportTxQueueIsHead(i)) {
+			continue;
+		}
+		_transportTxQueueNext = (i + 1) % MY_TRANSPORT_TX_QUEUE_SIZE;
+		// sending updates and signs the message, keep the queued one untouched for retries
+		MyMessage message;
+		(void)memcpy((void *)&message, (const void *)&entry->message, sizeof(MyMessage));
+		_transportTxQueueSending = true;
+		const bool success = transportSendRoute(message);
+		_transportTxQueueSending = false;
+		if (!success && ++entry->attempts <= MY_TRANSPORT_TX_QUEUE_RETRIES) {
+			TRANSPORT_DEBUG(PSTR("!TSF:TXQ:RETRY,TO=%" PRIu8 ",A=%" PRIu8 "\n"),
+			                entry->message.getDestination(), entry->attempts);
+			entry->due = hwMillis() + (MY_TRANSPORT_TX_QUEUE_BACKOFF_MS << (entry->attempts - 1));
+		} else {
+			if (!success) {
+				TRANSPORT_DEBUG(PSTR("!TSF:TXQ:DROP,TO=%" PRIu8 "\n"), entry->message.getDestination());
+			}
+			if (_transportTx_cb) {
+				_transportTx_cb(entry->message, success);
+			}
+			entry->used = false;
+		}
+		break;
+	}
+#if defined(__linux__)
+	// make sure the event loop wakes up for the next due message
+	bool pending = false;
+	uint32_t nextDue = 0;
+	for (uint8_t i = 0; i < MY_TRANSPORT_TX_QUEUE_SIZE; i++) {
+		if (_transportTxQueue[i].used) {
+			const uint32_t due = _transportTxQueue[i].due;
+			if (!pending || (int32_t)(due - nextDue) < 0) {
+				nextDue = due;
+			}
+			pending = true;
+		}
+	}
+	if (pending) {
+		const int32_t delta = (int32_t)(nextDue - hwMillis());
+		eventLoopWakeupIn(delta > 0 ? (uint32_t)delta : 0);
+	}
+#endif
+	_transportTxQueueActive = false;
+}
+
+void transportRegisterTxCallback(transportTxCallback_t cb)
+{
+	_transportTx_cb = cb;
+}
+#endif
+
 uint8_t transportGetNodeId(void)
 {
 	return _transportConfig.nodeId;
@@ -1024,6 +1178,9 @@ void transportClearRoutingTable(void)
 	for (uint16_t i = 0; i < SIZE_ROUTES; i++) {
 		transportSetRoute((uint8_t)i, BROADCAST_ADDRESS);
 	}
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	(void)memset((void *)_transportRadio, 0, sizeof(_transportRadio));
+#endif
 	transportSaveRoutingTable();	// save cleared routing table to EEPROM (if feature enabled)
 	TRANSPORT_DEBUG(PSTR("TSF:CRT:OK\n"));	// clear routing table
 }
@@ -1064,6 +1221,19 @@ uint8_t transportGetRoute(const uint8_t node)
 	return result;
 }
 
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+void transportSetRadio(const uint8_t node, const uint8_t radio)
+{
+	_transportRadio[node] = radio + 1;
+}
+
+uint8_t transportGetRadio(const uint8_t node)
+{
+	// TRANSPORT_HAL_ALL_BACKENDS if not known
+	return (uint8_t)(_transportRadio[node] - 1u);
+}
+#endif
+
 void transportReportRoutingTable(void)
 {
 #if defined(MY_REPEATER_FEATURE)
@@ -49,6 +49,7 @@
 *   - TSF:<b>SAN</b>		from @ref transportInvokeSanityCheck(), calls transport-specific sanity check
 *   - TSF:<b>RTE</b>		from @ref transportRouteMessage(), sends message
 *   - TSF:<b>SND</b>		from @ref transportSendRoute(), sends message if transport is ready (exposed)
+*   - TSF:<b>TXQ</b>		from @ref transportQueueSend() and @ref transportProcessTxQueue(), queued sending
 *   - TSF:<b>TDI</b>		from @ref transportDisable()
 *   - TSF:<b>TRI</b>		from @ref transportReInitialise()
 *   - TSF:<b>SIR</b>		from @ref transportSignalReport()
@@ -122,6 +123,10 @@
 * |!| TSF | RTE   | N2N FAIL									| Node-to-node communication failed, handing over to parent for re-routing
 * | | TSF | RRT   | ROUTE N=%%d,R=%%d					| Routing table, messages to node (N) are routed via node (R)
 * |!| TSF | SND   | TNR												| Transport not ready, message cannot be sent
+* | | TSF | TXQ   | ADD,TO=%%d,N=%%d					| Message to node (TO) queued, (N) messages queued
+* |!| TSF | TXQ   | FULL,TO=%%d								| TX queue or queue for node (TO) full, message dropped
+* |!| TSF | TXQ   | RETRY,TO=%%d,A=%%d				| Sending to node (TO) failed, attempt (A) is retried later
+* |!| TSF | TXQ   | DROP,TO=%%d								| Sending to node (TO) failed too often, message dropped
 * | | TSF | TDI   | TSL												| Set transport to sleep
 * | | TSF | TDI   | TPD												| Power down transport
 * | | TSF | TRI   | TRI												| Reinitialise transport
@@ -253,6 +258,24 @@
  */
 typedef void(*transportCallback_t)(void);
 
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+ * @brief TX queue callback type, called with the queued message once it is sent or dropped
+ */
+typedef void(*transportTxCallback_t)(const MyMessage &message, const bool success);
+
+/**
+ * @brief TX queue entry
+ */
+typedef struct {
+	MyMessage message;							//!< Message as queued, signed again for every attempt
+	uint32_t due;										//!< Time (hwMillis) of the next attempt
+	uint16_t seq;										//!< Queueing order, keeps messages to one node in order
+	uint8_t attempts;								//!< Failed attempts so far
+	bool used;											//!< Entry holds a message
+} transportTxQueueEntry_t;
+#endif
+
 /**
  * @brief Node configuration
  *
@@ -430,6 +453,27 @@ bool transportRouteMessage(MyMessage &message);
 * @return true if message sent successfully and false if sending error or transport !OK
 */
 bool transportSendRoute(MyMessage &message);
+#if defined(MY_TRANSPORT_TX_QUEUE_FEATURE)
+/**
+* @brief Queue message for sending from @ref transportProcessTxQueue()
+* @param message
+* @return true if message queued, false if queue full
+*/
+bool transportQueueSend(MyMessage &message);
+/**
+* @brief Send at most one due message from the TX queue
+*
+* Messages to the same destination are sent in order, one at a time. The message is transmitted
+* once (@ref transportHALSendOnce), failed sends are rescheduled with exponential back-off, so an
+* unreachable node does not delay the others.
+*/
+void transportProcessTxQueue(void);
+/**
+* @brief Register callback for sent and dropped messages of the TX queue
+* @param cb Callback, NULL to unregister
+*/
+void transportRegisterTxCallback(transportTxCallback_t cb);
+#endif
 /**
 * @brief Send message to recipient
 * @param to Recipient of message
@@ -515,6 +559,20 @@ void transportSetRoute(const uint8_t node, const uint8_t route);
 * @return route to node
 */
 uint8_t transportGetRoute(const uint8_t node);
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+/**
+* @brief Update radio a neighbour is reached on
+* @param node
+* @param radio backend index, see @ref transportHALGetReceivingRadio
+*/
+void transportSetRadio(const uint8_t node, const uint8_t radio);
+/**
+* @brief Load radio a neighbour is reached on
+* @param node
+* @return backend index, TRANSPORT_HAL_ALL_BACKENDS if not known
+*/
+uint8_t transportGetRadio(const uint8_t node);
+#endif
 /**
 * @brief Reports content of routing table
 */
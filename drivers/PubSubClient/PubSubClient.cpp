@@ -171,68 +171,8 @@ bool PubSubClient::connect(const char *id, const char *user, const char *pass,
 		} else {
 			result = _client->connect(this->ip, this->port);
 		}
-		if (result == 1) {
-			nextMsgId = 1;
-			// Leave room in the buffer for header and variable length field
-			uint16_t length = MQTT_MAX_HEADER_SIZE;
-			unsigned int j;
-
-#if MQTT_VERSION == MQTT_VERSION_3_1
-			uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
-#define MQTT_HEADER_VERSION_LENGTH 9
-#elif MQTT_VERSION == MQTT_VERSION_3_1_1
-			uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
-#define MQTT_HEADER_VERSION_LENGTH 7
-#endif
-			for (j = 0; j<MQTT_HEADER_VERSION_LENGTH; j++) {
-				buffer[length++] = d[j];
-			}
-
-			uint8_t v;
-			if (willTopic) {
-				v = 0x04|(willQos<<3)|(willRetain<<5);
-			} else {
-				v = 0x00;
-			}
-			if (cleanSession) {
-				v = v|0x02;
-			}
-
-			if(user != NULL) {
-				v = v|0x80;
-
-				if(pass != NULL) {
-					v = v|(0x80>>1);
-				}
-			}
-
-			buffer[length++] = v;
-
-			buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
-			buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
-
-			CHECK_STRING_LENGTH(length,id)
-			length = writeString(id,buffer,length);
-			if (willTopic) {
-				CHECK_STRING_LENGTH(length,willTopic)
-				length = writeString(willTopic,buffer,length);
-				CHECK_STRING_LENGTH(length,willMessage)
-				length = writeString(willMessage,buffer,length);
-			}
-
-			if(user != NULL) {
-				CHECK_STRING_LENGTH(length,user)
-				length = writeString(user,buffer,length);
-				if(pass != NULL) {
-					CHECK_STRING_LENGTH(length,pass)
-					length = writeString(pass,buffer,length);
-				}
-			}
-
-			write(MQTTCONNECT,buffer,length-MQTT_MAX_HEADER_SIZE);
-
-			lastInActivity = lastOutActivity = millis();
-
+		if (result == 1 && beginSession(id, user, pass, willTopic, willQos, willRetain, willMessage,
+		                                cleanSession)) {
 			while (!_client->available()) {
 				unsigned long t = millis();
 				if (t-lastInActivity >= ((int32_t) MQTT_SOCKET_TIMEOUT*1000UL)) {
@@ -263,6 +203,82 @@ bool PubSubClient::connect(const char *id, const char *user, const char *pass,
 	return true;
 }
 
+bool PubSubClient::beginSession(const char *id, const char *user, const char *pass,
+                                const char* willTopic, uint8_t willQos, bool willRetain, const char* willMessage,
+                                bool cleanSession)
+{
+	nextMsgId = 1;
+	// Leave room in the buffer for header and variable length field
+	uint16_t length = MQTT_MAX_HEADER_SIZE;
+	unsigned int j;
+
+#if MQTT_VERSION == MQTT_VERSION_3_1
+	uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
+#define MQTT_HEADER_VERSION_LENGTH 9
+#elif MQTT_VERSION == MQTT_VERSION_3_1_1
+	uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
+#define MQTT_HEADER_VERSION_LENGTH 7
+#endif
+	for (j = 0; j<MQTT_HEADER_VERSION_LENGTH; j++) {
+		buffer[length++] = d[j];
+	}
+
+	uint8_t v;
+	if (willTopic) {
+		v = 0x04|(willQos<<3)|(willRetain<<5);
+	} else {
+		v = 0x00;
+	}
+	if (cleanSession) {
+		v = v|0x02;
+	}
+
+	if(user != NULL) {
+		v = v|0x80;
+
+		if(pass != NULL) {
+			v = v|(0x80>>1);
+		}
+	}
+
+	buffer[length++] = v;
+
+	buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
+	buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
+
+	CHECK_STRING_LENGTH(length,id)
+	length = writeString(id,buffer,length);
+	if (willTopic) {
+		CHECK_STRING_LENGTH(length,willTopic)
+		length = writeString(willTopic,buffer,length);
+		CHECK_STRING_LENGTH(length,willMessage)
+		length = writeString(willMessage,buffer,length);
+	}
+
+	if(user != NULL) {
+		CHECK_STRING_LENGTH(length,user)
+		length = writeString(user,buffer,length);
+		if(pass != NULL) {
+			CHECK_STRING_LENGTH(length,pass)
+			length = writeString(pass,buffer,length);
+		}
+	}
+
+	if (!write(MQTTCONNECT,buffer,length-MQTT_MAX_HEADER_SIZE)) {
+		_state = MQTT_CONNECT_FAILED;
+		return false;
+	}
+
+	lastInActivity = lastOutActivity = millis();
+	pingOutstanding = false;
+#if defined(MQTT_NONBLOCKING)
+	rxLength = 0;
+	rxHeader = false;
+#endif
+	_state = MQTT_CONNECTING;
+	return true;
+}
+
 // reads a byte into result
 bool PubSubClient::readByte(uint8_t * result)
 {
@@ -357,8 +373,121 @@ uint16_t PubSubClient::readPacket(uint8_t* lengthLength)
 	return len;
 }
 
+#if defined(MQTT_NONBLOCKING)
+// reads the available bytes of the current packet into rxBuffer, returns the packet length once
+// it is complete and 0 while more bytes are needed
+uint16_t PubSubClient::readPacketNonBlocking(uint8_t* lengthLength)
+{
+	while (_client->available()) {
+		const uint8_t digit = _client->read();
+		if (rxLength < MQTT_MAX_PACKET_SIZE) {
+			rxBuffer[rxLength] = digit;
+		}
+		rxLength++;
+		if (!rxHeader) {
+			if (rxLength == 1) {
+				rxRemaining = 0;
+				continue;
+			}
+			if (rxLength == 6) {
+				// Invalid remaining length encoding - kill the connection
+				_state = MQTT_DISCONNECTED;
+				_client->stop();
+				rxLength = 0;
+				return 0;
+			}
+			rxRemaining += (uint32_t)(digit & 127) << (7 * (rxLength - 2));
+			if (digit & 128) {
+				continue;
+			}
+			rxHeader = true;
+			rxLengthLength = rxLength - 1;
+		} else {
+			rxRemaining--;
+		}
+		if (!rxRemaining) {
+			const uint32_t len = rxLength;
+			*lengthLength = rxLengthLength;
+			rxLength = 0;
+			rxHeader = false;
+			// Packets not fitting into the buffer are ignored
+			return (len > MQTT_MAX_PACKET_SIZE) ? 0 : len;
+		}
+	}
+	return 0;
+}
+#endif
+
+uint8_t PubSubClient::handlePacket(uint8_t* packet, uint16_t len, uint8_t llen)
+{
+	uint8_t ack[4];
+	uint8_t type = packet[0]&0xF0;
+	if (type == MQTTPUBLISH) {
+		if (callback) {
+			uint16_t tl = (packet[llen+1]<<8)+packet[llen+2]; /* topic length in bytes */
+			memmove(packet+llen+2,packet+llen+3,tl); /* move topic inside buffer 1 byte to front */
+			packet[llen+2+tl] = 0; /* end the topic as a 'C' string with \x00 */
+			char *topic = (char*) packet+llen+2;
+			uint8_t *payload;
+			// msgId only present for QOS>0
+			if ((packet[0]&0x06) == MQTTQOS1) {
+				uint16_t msgId = 0;
+				msgId = (packet[llen+3+tl]<<8)+packet[llen+3+tl+1];
+				payload = packet+llen+3+tl+2;
+				callback(topic,payload,len-llen-3-tl-2);
+
+				ack[0] = MQTTPUBACK;
+				ack[1] = 2;
+				ack[2] = (msgId >> 8);
+				ack[3] = (msgId & 0xFF);
+				_client->write(ack,4);
+				lastOutActivity = millis();
+
+			} else {
+				payload = packet+llen+3+tl;
+				callback(topic,payload,len-llen-3-tl);
+			}
+		}
+	} else if (type == MQTTPINGREQ) {
+		ack[0] = MQTTPINGRESP;
+		ack[1] = 0;
+		_client->write(ack,2);
+	} else if (type == MQTTPINGRESP) {
+		pingOutstanding = false;
+	} else if (type == MQTTPUBACK && len == 4) {
+		if (pubackCallback) {
+			pubackCallback((packet[2]<<8)+packet[3]);
+		}
+	}
+	return type;
+}
+
 bool PubSubClient::loop()
 {
+#if defined(MQTT_NONBLOCKING)
+	if (_state == MQTT_CONNECTING) {
+		// Waiting for CONNACK after beginSession()
+		uint8_t llen;
+		const uint16_t len = readPacketNonBlocking(&llen);
+		if (len == 4 && (rxBuffer[0]&0xF0) == MQTTCONNACK) {
+			if (rxBuffer[3] == 0) {
+				lastInActivity = millis();
+				pingOutstanding = false;
+				_state = MQTT_CONNECTED;
+				return true;
+			}
+			_state = rxBuffer[3];
+			_client->stop();
+		} else if (len > 0 || !_client->connected()) {
+			_state = MQTT_CONNECT_FAILED;
+			_client->stop();
+		} else if (millis() - lastInActivity >= MQTT_SOCKET_TIMEOUT*1000UL) {
+			_state = MQTT_CONNECTION_TIMEOUT;
+			_client->stop();
+		}
+		return false;
+	}
+#endif
 	if (connected()) {
 		unsigned long t = millis();
 		if ((t - lastInActivity > MQTT_KEEPALIVE*1000UL) || (t - lastOutActivity > MQTT_KEEPALIVE*1000UL)) {
@@ -375,50 +504,36 @@ bool PubSubClient::loop()
 				pingOutstanding = true;
 			}
 		}
+#if defined(MQTT_NONBLOCKING)
+		// Acknowledgements are handled in one go, a PUBLISH ends the pass as its payload
+		// is only valid until the next packet is read
+		while (_client->available()) {
+			uint8_t llen;
+			uint8_t *packet = this->stream ? buffer : rxBuffer;
+			uint16_t len = this->stream ? readPacket(&llen) : readPacketNonBlocking(&llen);
+			if (len > 0) {
+				lastInActivity = t;
+				if (handlePacket(packet, len, llen) == MQTTPUBLISH) {
+					break;
+				}
+			} else if (!connected()) {
+				// readPacket has closed the connection
+				return false;
+			}
+		}
+#else
 		if (_client->available()) {
 			uint8_t llen;
 			uint16_t len = readPacket(&llen);
 			if (len > 0) {
 				lastInActivity = t;
-				uint8_t type = buffer[0]&0xF0;
-				if (type == MQTTPUBLISH) {
-					if (callback) {
-						uint16_t tl = (buffer[llen+1]<<8)+buffer[llen+2]; /* topic length in bytes */
-						memmove(buffer+llen+2,buffer+llen+3,tl); /* move topic inside buffer 1 byte to front */
-						buffer[llen+2+tl] = 0; /* end the topic as a 'C' string with \x00 */
-						char *topic = (char*) buffer+llen+2;
-						uint8_t *payload;
-						// msgId only present for QOS>0
-						if ((buffer[0]&0x06) == MQTTQOS1) {
-							uint16_t msgId = 0;
-							msgId = (buffer[llen+3+tl]<<8)+buffer[llen+3+tl+1];
-							payload = buffer+llen+3+tl+2;
-							callback(topic,payload,len-llen-3-tl-2);
-
-							buffer[0] = MQTTPUBACK;
-							buffer[1] = 2;
-							buffer[2] = (msgId >> 8);
-							buffer[3] = (msgId & 0xFF);
-							_client->write(buffer,4);
-							lastOutActivity = t;
-
-						} else {
-							payload = buffer+llen+3+tl;
-							callback(topic,payload,len-llen-3-tl);
-						}
-					}
-				} else if (type == MQTTPINGREQ) {
-					buffer[0] = MQTTPINGRESP;
-					buffer[1] = 0;
-					_client->write(buffer,2);
-				} else if (type == MQTTPINGRESP) {
-					pingOutstanding = false;
-				}
+				handlePacket(buffer, len, llen);
 			} else if (!connected()) {
 				// readPacket has closed the connection
 				return false;
 			}
 		}
+#endif
 		return true;
 	}
 	return false;
@@ -442,19 +557,38 @@ bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned i
 bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength,
                            bool retained)
 {
+	return publish(topic, payload, plength, retained, 0, NULL);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength,
+                           bool retained, uint8_t qos, uint16_t* msgId)
+{
+	if (qos > 1) {
+		return false;
+	}
 	if (connected()) {
-		if (MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 2+strlen(topic) + plength) {
+		if (MQTT_MAX_PACKET_SIZE < MQTT_MAX_HEADER_SIZE + 2+strlen(topic) + (qos ? 2 : 0) + plength) {
 			// Too long
 			return false;
 		}
 		// Leave room in the buffer for header and variable length field
 		uint16_t length = MQTT_MAX_HEADER_SIZE;
 		length = writeString(topic,buffer,length);
-		uint16_t i;
-		for (i=0; i<plength; i++) {
-			buffer[length++] = payload[i];
-		}
 		uint8_t header = MQTTPUBLISH;
+		if (qos) {
+			nextMsgId++;
+			if (nextMsgId == 0) {
+				nextMsgId = 1;
+			}
+			buffer[length++] = (nextMsgId >> 8);
+			buffer[length++] = (nextMsgId & 0xFF);
+			header |= MQTTQOS1;
+			if (msgId) {
+				*msgId = nextMsgId;
+			}
+		}
+		(void)memcpy(buffer+length, payload, plength);
+		length += plength;
 		if (retained) {
 			header |= 1;
 		}
@@ -718,6 +852,13 @@ PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
 	return *this;
 }
 
+// cppcheck-suppress passedByValue
+PubSubClient& PubSubClient::setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE)
+{
+	this->pubackCallback = pubackCallback;
+	return *this;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client)
 {
 	this->_client = &client;
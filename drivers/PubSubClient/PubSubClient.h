@@ -36,12 +36,19 @@
 #define MQTT_SOCKET_TIMEOUT 15
 #endif
 
+// MQTT_NONBLOCKING : loop() assembles incoming packets from whatever bytes are available
+//  instead of waiting up to MQTT_SOCKET_TIMEOUT for the rest of a packet, and the connection
+//  can be set up with beginSession() on an already connected client. Takes a second packet
+//  buffer.
+//#define MQTT_NONBLOCKING
+
 // MQTT_MAX_TRANSFER_SIZE : limit how much data is passed to the network client
 //  in each write call. Needed for the Arduino Wifi Shield. Leave undefined to
 //  pass the entire MQTT packet in each write call.
 //#define MQTT_MAX_TRANSFER_SIZE 80
 
 // Possible values for client.state()
+#define MQTT_CONNECTING             -5
 #define MQTT_CONNECTION_TIMEOUT     -4
 #define MQTT_CONNECTION_LOST        -3
 #define MQTT_CONNECT_FAILED         -2
@@ -79,8 +86,10 @@
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_PUBACK_CALLBACK_SIGNATURE std::function<void(uint16_t)> pubackCallback
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_PUBACK_CALLBACK_SIGNATURE void (*pubackCallback)(uint16_t)
 #endif
 
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strlen(s) > MQTT_MAX_PACKET_SIZE) {_client->stop();return false;}
@@ -96,6 +105,7 @@ private:
 	unsigned long lastInActivity;
 	bool pingOutstanding;
 	MQTT_CALLBACK_SIGNATURE;
+	MQTT_PUBACK_CALLBACK_SIGNATURE = NULL;
 	uint16_t readPacket(uint8_t*);
 	bool readByte(uint8_t * result);
 	bool readByte(uint8_t * result, uint16_t * index);
@@ -106,6 +116,15 @@ private:
 	// Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
 	//       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
 	size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+	uint8_t handlePacket(uint8_t* packet, uint16_t len, uint8_t llen);
+#if defined(MQTT_NONBLOCKING)
+	uint8_t rxBuffer[MQTT_MAX_PACKET_SIZE];
+	uint32_t rxLength;
+	uint32_t rxRemaining;
+	uint8_t rxLengthLength;
+	bool rxHeader;
+	uint16_t readPacketNonBlocking(uint8_t*);
+#endif
 	IPAddress ip;
 	const char* domain;
 	uint16_t port;
@@ -134,6 +153,8 @@ public:
 	PubSubClient& setServer(uint8_t * ip, uint16_t port); //!< setServer
 	PubSubClient& setServer(const char * domain, uint16_t port); //!< setServer
 	PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE); //!< setCallback
+	// Called by loop() with the packet identifier of each PUBACK received
+	PubSubClient& setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE); //!< setPubackCallback
 	PubSubClient& setClient(Client& client); //!< setClient
 	PubSubClient& setStream(Stream& stream); //!< setStream
 
@@ -145,12 +166,22 @@ public:
 	             uint8_t willQos, bool willRetain, const char* willMessage); //!< connect
 	bool connect(const char* id, const char* user, const char* pass, const char* willTopic,
 	             uint8_t willQos, bool willRetain, const char* willMessage, bool cleanSession); //!< connect
+	// Start the MQTT session on a client that is already connected, without waiting for the
+	// broker's answer. state() is MQTT_CONNECTING until loop() has received the CONNACK
+	// Returns 1 if the CONNECT packet was sent, 0 if there was an error
+	bool beginSession(const char* id, const char* user, const char* pass, const char* willTopic,
+	                  uint8_t willQos, bool willRetain, const char* willMessage,
+	                  bool cleanSession); //!< beginSession
 	void disconnect(); //!< disconnect
 	bool publish(const char* topic, const char* payload); //!< publish
 	bool publish(const char* topic, const char* payload, bool retained); //!< publish
 	bool publish(const char* topic, const uint8_t * payload, unsigned int plength); //!< publish
 	bool publish(const char* topic, const uint8_t * payload, unsigned int plength,
 	             bool retained); //!< publish
+	// Publish with QoS 0 or 1. For QoS 1 the packet identifier is stored in msgId, the broker
+	// confirms it with a PUBACK, see setPubackCallback()
+	bool publish(const char* topic, const uint8_t * payload, unsigned int plength, bool retained,
+	             uint8_t qos, uint16_t* msgId); //!< publish
 	bool publish_P(const char* topic, const char* payload, bool retained); //!< publish
 	bool publish_P(const char* topic, const uint8_t * payload, unsigned int plength,
 	               bool retained); //!< publish
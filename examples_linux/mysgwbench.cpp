@@ -0,0 +1,268 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Gateway benchmark: the Ethernet gateway, with the loopback transport instead of a radio.
+ * A radio thread plays the nodes, each sending a sequence number at a fixed rate, a controller
+ * thread connects to the gateway and takes the time every number arrives. At the end the
+ * sustained throughput and the latency from injection to the controller are printed.
+ *
+ * Build: make bench (the gateway and transport options of configure are ignored)
+ * Run:   ./bin/mysgw-bench --config-file=<file>
+ *
+ * The configuration file is the one of mysgw, use verbose=warn. The load is set with
+ * environment variables:
+ *   MYSGW_BENCH_NODES    Number of nodes, 1-254 (default 10)
+ *   MYSGW_BENCH_RATE     Messages per second and node (default 10)
+ *   MYSGW_BENCH_SECONDS  Duration (default 10)
+ *
+ * Nodes x rate x duration is limited to 10 million messages.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define MY_RADIO_LOOPBACK
+
+// Not the port of a gateway that may be running on the same machine
+#define MY_PORT 5903
+
+#include <MySensors.h>
+
+#define BENCH_SENSOR_ID (1u)		//!< Sensor of the benchmark messages
+#define BENCH_WARMUP_MS (200u)		//!< Pause between the controller connection and the first message
+#define BENCH_DRAIN_MS (2000u)		//!< Time to wait for outstanding messages at the end
+#define BENCH_MAX_MESSAGES (10000000ull)	//!< Messages of one run, 12 bytes of bookkeeping each
+
+static uint32_t _benchNodes;
+static uint32_t _benchRate;
+static uint32_t _benchSeconds;
+static uint32_t _benchTotal;
+
+static std::vector<uint64_t> _benchSentAt;		// Injection time of each sequence number
+static std::vector<uint32_t> _benchLatency;		// Controller thread only
+static std::atomic<uint32_t> _benchDropped(0);	// Written by the radio thread
+static uint64_t _benchFirstSent = 0;
+static uint64_t _benchLastReceived = 0;
+static std::atomic<bool> _benchConnected(false);
+static std::atomic<bool> _benchInjected(false);
+static std::atomic<bool> _benchDone(false);
+static pthread_t _benchRadioThread;
+static pthread_t _benchControllerThread;
+
+static uint64_t benchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void benchSleepUntil(const uint64_t ns)
+{
+	struct timespec ts;
+	ts.tv_sec = ns / 1000000000ull;
+	ts.tv_nsec = ns % 1000000000ull;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+static uint32_t benchSetting(const char *name, const uint32_t value, const uint32_t maximum)
+{
+	const char *str = getenv(name);
+	if (!str) {
+		return value;
+	}
+	const unsigned long result = strtoul(str, NULL, 10);
+	return (result < 1) ? 1 : (result > maximum) ? maximum : result;
+}
+
+// Frames sent to the nodes are acknowledged and discarded
+static bool benchRadioSend(const uint8_t to, const void *data, const uint8_t len)
+{
+	(void)to;
+	(void)data;
+	(void)len;
+	return true;
+}
+
+static void *benchRadio(void *arg)
+{
+	(void)arg;
+	while (!_benchConnected.load()) {
+		usleep(1000);
+	}
+	usleep(BENCH_WARMUP_MS * 1000u);
+	const uint64_t interval = 1000000000ull / ((uint64_t)_benchNodes * _benchRate);
+	uint64_t next = benchNow();
+	_benchFirstSent = next;
+	for (uint32_t seq = 0; seq < _benchTotal; seq++) {
+		benchSleepUntil(next);
+		next += interval;
+		const uint8_t node = 1u + seq % _benchNodes;
+		MyMessage message(BENCH_SENSOR_ID, V_CUSTOM);
+		message.setCommand(C_SET);
+		message.setSender(node);
+		message.setLast(node);
+		message.setDestination(GATEWAY_ADDRESS);
+		message.set(seq);
+		// a late frame is sent right away, its delay is part of the measured latency
+		_benchSentAt[seq] = benchNow();
+		if (!transportLoopbackInject(&message.last, HEADER_SIZE + message.getLength())) {
+			_benchDropped++;
+			_benchSentAt[seq] = 0;
+		}
+	}
+	_benchInjected.store(true);
+	return NULL;
+}
+
+// A line of the serial protocol: NODE;SENSOR;CMD;ECHO;TYPE;PAYLOAD
+static void benchReceive(const char *line, const uint64_t now)
+{
+	unsigned int node, sensor, command, echo, type;
+	unsigned long seq;
+	if (sscanf(line, "%u;%u;%u;%u;%u;%lu", &node, &sensor, &command, &echo, &type, &seq) != 6 ||
+	        sensor != BENCH_SENSOR_ID || command != C_SET || type != V_CUSTOM || seq >= _benchTotal ||
+	        !_benchSentAt[seq]) {
+		return;
+	}
+	_benchLatency.push_back((uint32_t)((now - _benchSentAt[seq]) / 1000u));
+	_benchSentAt[seq] = 0;
+	_benchLastReceived = now;
+}
+
+static void *benchController(void *arg)
+{
+	(void)arg;
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(MY_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int fd;
+	// the gateway starts listening in its first loop iterations
+	for (;;) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+			break;
+		}
+		if (fd >= 0) {
+			close(fd);
+		}
+		usleep(10000);
+	}
+	_benchConnected.store(true);
+
+	char buffer[4096];
+	size_t length = 0;
+	uint64_t drainUntil = 0;
+	while (_benchLatency.size() + _benchDropped.load() < _benchTotal) {
+		if (_benchInjected.load()) {
+			if (!drainUntil) {
+				drainUntil = benchNow() + BENCH_DRAIN_MS * 1000000ull;
+			} else if (benchNow() > drainUntil) {
+				break;
+			}
+		}
+		struct pollfd pfd = { fd, POLLIN, 0 };
+		if (poll(&pfd, 1, 100) <= 0) {
+			continue;
+		}
+		const ssize_t received = recv(fd, buffer + length, sizeof(buffer) - length - 1, 0);
+		if (received <= 0) {
+			break;
+		}
+		const uint64_t now = benchNow();
+		length += received;
+		buffer[length] = '\0';
+		char *line = buffer;
+		char *end;
+		while ((end = strchr(line, '\n')) != NULL) {
+			*end = '\0';
+			benchReceive(line, now);
+			line = end + 1;
+		}
+		length -= line - buffer;
+		(void)memmove(buffer, line, length);
+	}
+	close(fd);
+	_benchDone.store(true);
+	eventLoopNotify();
+	return NULL;
+}
+
+static void benchReport(void)
+{
+	const uint32_t received = _benchLatency.size();
+	printf("nodes %" PRIu32 ", %" PRIu32 " msg/s per node, %" PRIu32 " s\n", _benchNodes, _benchRate,
+	       _benchSeconds);
+	printf("offered    %.1f msg/s\n", (double)_benchNodes * _benchRate);
+	printf("sent       %" PRIu32 ", dropped %" PRIu32 " (RX queue full), lost %" PRIu32 "\n", _benchTotal,
+	       _benchDropped.load(), _benchTotal - _benchDropped.load() - received);
+	if (!received) {
+		return;
+	}
+	printf("throughput %.1f msg/s\n", received * 1e9 / (double)(_benchLastReceived - _benchFirstSent));
+	std::sort(_benchLatency.begin(), _benchLatency.end());
+	printf("latency    p50 %" PRIu32 " us, p99 %" PRIu32 " us, max %" PRIu32 " us\n",
+	       _benchLatency[received / 2u], _benchLatency[(uint64_t)received * 99u / 100u],
+	       _benchLatency[received - 1u]);
+}
+
+void setup()
+{
+	_benchNodes = benchSetting("MYSGW_BENCH_NODES", 10u, 254u);
+	_benchRate = benchSetting("MYSGW_BENCH_RATE", 10u, 1000000u);
+	_benchSeconds = benchSetting("MYSGW_BENCH_SECONDS", 10u, 3600u);
+	const uint64_t total = (uint64_t)_benchNodes * _benchRate * _benchSeconds;
+	if (total > BENCH_MAX_MESSAGES) {
+		logError("%" PRIu64 " messages requested, at most %" PRIu64 " per run\n", total,
+		         (uint64_t)BENCH_MAX_MESSAGES);
+		exit(EXIT_FAILURE);
+	}
+	_benchTotal = (uint32_t)total;
+	_benchSentAt.assign(_benchTotal, 0);
+	_benchLatency.reserve(_benchTotal);
+	transportLoopbackSetSendHandler(benchRadioSend);
+	if (pthread_create(&_benchControllerThread, NULL, benchController, NULL) != 0 ||
+	        pthread_create(&_benchRadioThread, NULL, benchRadio, NULL) != 0) {
+		logError("Failed to start the benchmark threads\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void presentation()
+{
+}
+
+void loop()
+{
+	if (!_benchDone.load()) {
+		return;
+	}
+	(void)pthread_join(_benchRadioThread, NULL);
+	(void)pthread_join(_benchControllerThread, NULL);
+	benchReport();
+	exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,322 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Known answer tests of the generic crypto HAL used by the Linux gateway. Every test runs with
+ * the portable code and again with the CPU instructions, if the gateway would use them (SHA-NI
+ * and AES-NI on x86, the ARMv8 cryptography extensions with MY_LINUX_CRYPTO_ARMV8). Random
+ * inputs are hashed and encrypted with both and compared as well. At the end both are timed.
+ *
+ * Build and run: make check
+ * The exit status is 0 if all tests passed.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <Arduino.h>
+
+#include "MyConfig.h"
+#include "hal/crypto/MyCryptoHAL.h"
+#include "hal/crypto/generic/MyCryptoGeneric.cpp"
+
+#define TEST_RANDOM_INPUTS (2000u)	//!< Random inputs processed with both implementations
+#define TEST_RANDOM_MAX_LENGTH (300u)	//!< Longest random input
+#define TEST_BENCH_LENGTH (1024u)	//!< Input of the hash and encryption benchmarks
+#define TEST_BENCH_NS (200000000.0)	//!< Minimum duration of each benchmark
+
+static uint32_t _testFailed = 0;
+
+static void testHex(uint8_t *dest, const char *hex)
+{
+	for (size_t i = 0; hex[i * 2]; i++) {
+		const char byte[3] = { hex[i * 2], hex[i * 2 + 1], '\0' };
+		dest[i] = (uint8_t)strtoul(byte, NULL, 16);
+	}
+}
+
+static void testCheck(const char *name, const char *impl, const uint8_t *result,
+                      const char *expected)
+{
+	uint8_t digest[64];
+	testHex(digest, expected);
+	if (memcmp(result, digest, strlen(expected) / 2)) {
+		printf("FAIL %s (%s)\n", name, impl);
+		_testFailed++;
+	}
+}
+
+static void testSHA256(const char *impl)
+{
+	uint8_t result[32];
+	SHA256(result, (const uint8_t *)"", 0);
+	testCheck("SHA-256 empty", impl, result,
+	          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	SHA256(result, (const uint8_t *)"abc", 3);
+	testCheck("SHA-256 FIPS 180-2 B.1", impl, result,
+	          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	const char *two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	SHA256(result, (const uint8_t *)two, strlen(two));
+	testCheck("SHA-256 FIPS 180-2 B.2", impl, result,
+	          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	uint8_t a[1000];
+	(void)memset((void *)a, 'a', sizeof(a));
+	SHA256Init();
+	for (uint16_t i = 0; i < 1000; i++) {
+		SHA256Add(a, sizeof(a));
+	}
+	SHA256Result(result);
+	testCheck("SHA-256 FIPS 180-2 B.3", impl, result,
+	          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+	// RFC 4231 test cases 1, 2, 6 and 7
+	uint8_t key[131];
+	(void)memset((void *)key, 0x0b, 20);
+	SHA256HMAC(result, key, 20, (const uint8_t *)"Hi There", 8);
+	testCheck("HMAC-SHA-256 RFC 4231 1", impl, result,
+	          "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+	const char *data = "what do ya want for nothing?";
+	SHA256HMAC(result, (const uint8_t *)"Jefe", 4, (const uint8_t *)data, strlen(data));
+	testCheck("HMAC-SHA-256 RFC 4231 2", impl, result,
+	          "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+	(void)memset((void *)key, 0xaa, sizeof(key));
+	data = "Test Using Larger Than Block-Size Key - Hash Key First";
+	SHA256HMAC(result, key, sizeof(key), (const uint8_t *)data, strlen(data));
+	testCheck("HMAC-SHA-256 RFC 4231 6", impl, result,
+	          "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+	data = "This is a test using a larger than block-size key and a larger than block-size data. "
+	       "The key needs to be hashed before being used by the HMAC algorithm.";
+	SHA256HMAC(result, key, sizeof(key), (const uint8_t *)data, strlen(data));
+	testCheck("HMAC-SHA-256 RFC 4231 7", impl, result,
+	          "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2");
+}
+
+static uint8_t _testBenchData[TEST_BENCH_LENGTH];
+static uint8_t _testBenchResult[32];
+
+static double testNow(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+// Calls of func per second
+static double testRate(void (*func)(void))
+{
+	uint32_t calls = 0;
+	const double start = testNow();
+	double elapsed;
+	do {
+		for (uint8_t i = 0; i < 100u; i++) {
+			func();
+		}
+		calls += 100u;
+		elapsed = testNow() - start;
+	} while (elapsed < TEST_BENCH_NS);
+	return calls * 1e9 / elapsed;
+}
+
+static void testBenchSHA256(void)
+{
+	SHA256(_testBenchResult, _testBenchData, sizeof(_testBenchData));
+}
+
+// The signing backend hashes messages of at most 32 bytes with a 32 byte key
+static void testBenchHMAC(void)
+{
+	SHA256HMAC(_testBenchResult, _testBenchResult, sizeof(_testBenchResult), _testBenchData, 32);
+}
+
+static void testBenchmarkSHA256(const char *impl)
+{
+	const double hashes = testRate(testBenchSHA256);
+	printf("SHA-256 (%s): %.0f hashes/s of %u bytes (%.1f MB/s), %.0f HMAC/s of 32 bytes\n", impl,
+	       hashes, TEST_BENCH_LENGTH, hashes * TEST_BENCH_LENGTH / 1e6, testRate(testBenchHMAC));
+}
+
+static void testBenchEncrypt(void)
+{
+	AES128CBCEncrypt(_testBenchResult, _testBenchData, sizeof(_testBenchData));
+}
+
+static void testBenchDecrypt(void)
+{
+	AES128CBCDecrypt(_testBenchResult, _testBenchData, sizeof(_testBenchData));
+}
+
+static void testBenchmarkAES128CBC(const char *impl)
+{
+	AES128CBCInit(_testBenchResult);
+	const double encrypt = testRate(testBenchEncrypt) * TEST_BENCH_LENGTH / 1e6;
+	const double decrypt = testRate(testBenchDecrypt) * TEST_BENCH_LENGTH / 1e6;
+	printf("AES-128-CBC (%s): encryption %.1f MB/s, decryption %.1f MB/s of %u bytes\n", impl,
+	       encrypt, decrypt, TEST_BENCH_LENGTH);
+}
+
+static void testAES128CBC(const char *impl)
+{
+	// NIST SP 800-38A F.2.1 and F.2.2
+	uint8_t key[16];
+	uint8_t iv[16];
+	uint8_t buffer[64];
+	const char *plain = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+	                    "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+	testHex(key, "2b7e151628aed2a6abf7158809cf4f3c");
+	testHex(iv, "000102030405060708090a0b0c0d0e0f");
+	testHex(buffer, plain);
+	AES128CBCInit(key);
+	AES128CBCEncrypt(iv, buffer, sizeof(buffer));
+	testCheck("AES-128-CBC SP 800-38A F.2.1", impl, buffer,
+	          "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+	          "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+	testCheck("AES-128-CBC SP 800-38A F.2.1 IV", impl, iv, "3ff1caa1681fac09120eca307586e1a7");
+	testHex(iv, "000102030405060708090a0b0c0d0e0f");
+	AES128CBCDecrypt(iv, buffer, sizeof(buffer));
+	testCheck("AES-128-CBC SP 800-38A F.2.2", impl, buffer, plain);
+}
+
+int main(void)
+{
+#if defined(SHA256hashBlockHw)
+	// The first block selects the implementation, the instructions must pass their self test
+	testSHA256(SHA256hwSupported() ? "CPU instructions" : "portable");
+	if (SHA256hwSupported() && SHA256hashBlockImpl != SHA256hashBlockHw) {
+		printf("FAIL SHA-256 self test of the CPU instructions\n");
+		_testFailed++;
+	}
+	SHA256hashBlockImpl = SHA256hashBlockGeneric;
+	testSHA256("portable");
+	if (SHA256hwSupported()) {
+		uint8_t data[TEST_RANDOM_MAX_LENGTH];
+		uint8_t expected[32];
+		uint8_t result[32];
+		srand(1);
+		for (uint32_t i = 0; i < TEST_RANDOM_INPUTS; i++) {
+			const size_t length = rand() % (sizeof(data) + 1);
+			for (size_t j = 0; j < length; j++) {
+				data[j] = rand();
+			}
+			SHA256hashBlockImpl = SHA256hashBlockGeneric;
+			SHA256(expected, data, length);
+			SHA256hashBlockImpl = SHA256hashBlockHw;
+			SHA256(result, data, length);
+			if (memcmp(result, expected, sizeof(result))) {
+				printf("FAIL SHA-256 of %zu random bytes (CPU instructions)\n", length);
+				_testFailed++;
+				break;
+			}
+		}
+		printf("SHA-256: portable and CPU instructions tested\n");
+	} else {
+		printf("SHA-256: portable tested, the CPU has no SHA-256 instructions\n");
+	}
+#else
+	testSHA256("portable");
+	printf("SHA-256: portable tested, no SHA-256 instructions in this build\n");
+#endif
+
+#if defined(AES_HW)
+	// The first key probes the instructions, they must pass their self test
+	testAES128CBC(AEShwSupported() ? "CPU instructions" : "portable");
+	if (AEShwSupported() && _aes_hw != 1) {
+		printf("FAIL AES-128 self test of the CPU instructions\n");
+		_testFailed++;
+	}
+	_aes_hw = 0;
+	testAES128CBC("portable");
+	if (AEShwSupported()) {
+		uint8_t key[16];
+		uint8_t ivStart[16];
+		uint8_t iv[16];
+		uint8_t ivHw[16];
+		uint8_t plain[TEST_RANDOM_MAX_LENGTH / 16 * 16];
+		uint8_t data[sizeof(plain)];
+		uint8_t expected[sizeof(plain)];
+		srand(2);
+		for (uint32_t i = 0; i < TEST_RANDOM_INPUTS; i++) {
+			const size_t length = (rand() % (sizeof(plain) / 16) + 1) * 16;
+			for (size_t j = 0; j < sizeof(key); j++) {
+				key[j] = rand();
+				ivStart[j] = rand();
+			}
+			for (size_t j = 0; j < length; j++) {
+				plain[j] = rand();
+			}
+			(void)memcpy((void *)expected, (const void *)plain, length);
+			(void)memcpy((void *)data, (const void *)plain, length);
+			(void)memcpy((void *)iv, (const void *)ivStart, sizeof(iv));
+			(void)memcpy((void *)ivHw, (const void *)ivStart, sizeof(ivHw));
+			_aes_hw = 0;
+			AES128CBCInit(key);
+			AES128CBCEncrypt(iv, expected, length);
+			_aes_hw = 1;
+			AES128CBCInit(key);
+			AES128CBCEncrypt(ivHw, data, length);
+			if (memcmp(data, expected, length) || memcmp(ivHw, iv, sizeof(iv))) {
+				printf("FAIL AES-128-CBC encryption of %zu random bytes (CPU instructions)\n", length);
+				_testFailed++;
+				break;
+			}
+			(void)memcpy((void *)ivHw, (const void *)ivStart, sizeof(ivHw));
+			AES128CBCDecrypt(ivHw, data, length);
+			if (memcmp(data, plain, length)) {
+				printf("FAIL AES-128-CBC decryption of %zu random bytes (CPU instructions)\n", length);
+				_testFailed++;
+				break;
+			}
+		}
+		printf("AES-128: portable and CPU instructions tested\n");
+	} else {
+		printf("AES-128: portable tested, the CPU has no AES instructions\n");
+	}
+#else
+	testAES128CBC("portable");
+	printf("AES-128: portable tested, no AES instructions in this build\n");
+#endif
+
+	// Throughput of the portable code and the CPU instructions
+#if defined(SHA256hashBlockHw)
+	SHA256hashBlockImpl = SHA256hashBlockGeneric;
+	testBenchmarkSHA256("portable");
+	if (SHA256hwSupported()) {
+		SHA256hashBlockImpl = SHA256hashBlockHw;
+		testBenchmarkSHA256("CPU instructions");
+	}
+#else
+	testBenchmarkSHA256("portable");
+#endif
+#if defined(AES_HW)
+	_aes_hw = 0;
+	testBenchmarkAES128CBC("portable");
+	if (AEShwSupported()) {
+		_aes_hw = 1;
+		testBenchmarkAES128CBC("CPU instructions");
+	}
+#else
+	testBenchmarkAES128CBC("portable");
+#endif
+
+	if (_testFailed) {
+		printf("%" PRIu32 " tests FAILED\n", _testFailed);
+		return EXIT_FAILURE;
+	}
+	printf("All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,577 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Tests and benchmark of the gateway protocol encoder and parser. Random messages of every
+ * payload type are formatted with protocolFormatSerial, protocolFormatMQTT and
+ * protocolFormatPayload and compared byte for byte with the snprintf and MyMessage::getString
+ * reference, also with short buffers. Every line and topic is parsed back with
+ * protocolSerialParse and protocolMQTT2MyMessage and must give the original header and payload.
+ *
+ * The serial parser is also fuzzed: random and semi-structured lines are decoded with
+ * protocolSerial2MyMessage and with the strtok parser it replaced, and must give the same
+ * message. A random byte stream with overlong lines must never produce an oversized payload, and
+ * a valid line after any garbage must be decoded correctly. At the end the encoders and the
+ * parser are timed against their predecessors.
+ *
+ * Build and run: make check
+ * The exit status is 0 if all tests passed.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <Arduino.h>
+
+#define MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "mygateway1-in"
+
+#include "MyConfig.h"
+#include "core/MySensorsCore.h"
+#include "core/MyHelperFunctions.cpp"
+#include "core/MyMessage.cpp"
+#include "core/MyProtocol.cpp"
+
+#define TEST_RANDOM_MESSAGES (20000u)	//!< Random messages formatted and parsed back
+#define TEST_BENCH_MESSAGES (256u)	//!< Distinct messages of the benchmark
+#define TEST_BENCH_ROUNDS (2000u)	//!< Passes over the benchmark messages
+#define TEST_FUZZ_LINES (1000000u)	//!< Random lines decoded by both serial parsers
+#define TEST_FUZZ_BYTES (20000000u)	//!< Random bytes fed into the streaming parser
+#define TEST_BENCH_STREAM (1u << 20)	//!< Size of the parser benchmark input
+#define TEST_BENCH_STREAM_ROUNDS (20u)	//!< Passes over the parser benchmark input
+
+static uint32_t _testFailed = 0;
+static char _testReference[MY_GATEWAY_MAX_SEND_LENGTH];
+static char _testReferencePayload[MAX_PAYLOAD_SIZE * 2 + 16];
+
+static float testRandomFloat(void)
+{
+	switch (rand() % 4) {
+	case 0:
+		return (float)(rand() % 2001 - 1000) / 8.0f;
+	case 1:
+		return (float)(rand() - RAND_MAX / 2) / (float)(rand() % 10000 + 1);
+	case 2:
+		// ties of the rounding
+		return (float)(rand() % 2001 - 1000) + 0.5f / (float)(1u << (rand() % 4));
+	default: {
+		// any bit pattern, including infinity and NaN
+		float value;
+		const uint32_t bits = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		(void)memcpy((void *)&value, (const void *)&bits, sizeof(value));
+		return value;
+	}
+	}
+}
+
+static void testRandomMessage(MyMessage &message)
+{
+	message.clear();
+	message.setSender(rand());
+	message.setSensor(rand());
+	message.setCommand(static_cast<mysensors_command_t>(rand() % 5));
+	message.setEcho(rand() & 1);
+	message.setType(rand());
+	switch (rand() % 8) {
+	case 0: {
+		// printable, without the separators of the serial protocol
+		char str[MAX_PAYLOAD_SIZE + 1];
+		const uint8_t length = rand() % MAX_PAYLOAD_SIZE + 1;
+		for (uint8_t i = 0; i < length; i++) {
+			do {
+				str[i] = ' ' + rand() % 95;
+			} while (str[i] == ';' || str[i] == '/');
+		}
+		str[length] = 0;
+		message.set(str);
+		break;
+	}
+	case 1:
+		message.set((uint8_t)rand());
+		break;
+	case 2:
+		message.set((int16_t)rand());
+		break;
+	case 3:
+		message.set((uint16_t)rand());
+		break;
+	case 4:
+		message.set((int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand()));
+		break;
+	case 5:
+		message.set((uint32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand()));
+		break;
+	case 6:
+		message.set(testRandomFloat(), rand() % 10);
+		break;
+	default: {
+		uint8_t data[MAX_PAYLOAD_SIZE];
+		const uint8_t length = rand() % (MAX_PAYLOAD_SIZE + 1);
+		for (uint8_t i = 0; i < length; i++) {
+			data[i] = rand();
+		}
+		message.set(data, length);
+		break;
+	}
+	}
+}
+
+// The encoders before protocolFormatSerial and protocolFormatMQTT
+static void testReferenceSerial(const MyMessage &message)
+{
+	(void)snprintf(_testReference, sizeof(_testReference),
+	               "%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n", message.getSender(),
+	               message.getSensor(), message.getCommand(), message.isEcho(), message.getType(),
+	               message.getString(_testReferencePayload));
+}
+
+static void testReferenceMQTT(const MyMessage &message)
+{
+	(void)snprintf(_testReference, sizeof(_testReference),
+	               "%s/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "/%" PRIu8 "", MY_MQTT_SUBSCRIBE_TOPIC_PREFIX,
+	               message.getSender(), message.getSensor(), message.getCommand(), message.isEcho(),
+	               message.getType());
+	(void)message.getString(_testReferencePayload);
+}
+
+static void testFail(const char *name, const MyMessage &message, const char *result)
+{
+	printf("FAIL %s: payload type %" PRIu8 ", expected \"%s\", got \"%s\"\n", name,
+	       message.getPayloadType(), _testReference, result);
+	_testFailed++;
+}
+
+// Every shorter buffer must hold the start of the full result
+static void testTruncation(const char *name, const MyMessage &message, const char *full,
+                           uint8_t (*format)(char *, const uint8_t, const MyMessage &))
+{
+	char buffer[MY_GATEWAY_MAX_SEND_LENGTH];
+	const uint8_t length = strlen(full);
+	for (uint8_t size = 1; size <= length; size++) {
+		(void)memset((void *)buffer, 0x55, sizeof(buffer));
+		if (format(buffer, size, message) != size - 1 || memcmp(buffer, full, size - 1) ||
+		        buffer[size - 1] != 0 || buffer[size] != 0x55) {
+			testFail(name, message, buffer);
+			return;
+		}
+	}
+}
+
+static uint8_t testFormatPayload(char *buffer, const uint8_t size, const MyMessage &message)
+{
+	return protocolFormatPayload(buffer, size, message);
+}
+
+static void testSerial(const MyMessage &message)
+{
+	char line[MY_GATEWAY_MAX_SEND_LENGTH];
+	testReferenceSerial(message);
+	const uint8_t length = protocolFormatSerial(line, sizeof(line), message);
+	if (strcmp(line, _testReference) || length != strlen(line)) {
+		testFail("serial format", message, line);
+		return;
+	}
+	testTruncation("serial format truncated", message, line, protocolFormatSerial);
+
+	MyMessage parsed;
+	protocolSerialParser_t parser;
+	protocolSerialParserReset(parser);
+	bool ok = false;
+	for (uint8_t i = 0; i < length; i++) {
+		ok = protocolSerialParse(parser, parsed, line[i]);
+	}
+	if (!ok || parsed.getDestination() != message.getSender() ||
+	        parsed.getSensor() != message.getSensor() || parsed.getCommand() != message.getCommand() ||
+	        parsed.getRequestEcho() != message.isEcho() || parsed.getType() != message.getType() ||
+	        parsed.getSender() != GATEWAY_ADDRESS) {
+		testFail("serial parse header", message, line);
+		return;
+	}
+	// the string payload is cut at the message size
+	const uint8_t payloadLength = min((uint8_t)strlen(_testReferencePayload),
+	                                  (uint8_t)MAX_PAYLOAD_SIZE);
+	if (!payloadLength) {
+		if (parsed.getPayloadType() != P_BYTE || parsed.getByte() != 0) {
+			testFail("serial parse empty payload", message, line);
+		}
+	} else if (message.getCommand() == C_STREAM && message.getPayloadType() == P_CUSTOM) {
+		if (parsed.getPayloadType() != P_CUSTOM || parsed.getLength() != message.getLength() ||
+		        memcmp(parsed.data, message.data, message.getLength())) {
+			testFail("serial parse stream", message, line);
+		}
+	} else if (message.getCommand() != C_STREAM) {
+		if (parsed.getPayloadType() != P_STRING || parsed.getLength() != payloadLength ||
+		        memcmp(parsed.data, _testReferencePayload, payloadLength)) {
+			testFail("serial parse payload", message, line);
+		}
+	}
+}
+
+static void testMQTT(const MyMessage &message)
+{
+	char topic[MY_GATEWAY_MAX_SEND_LENGTH];
+	char payload[MY_GATEWAY_MAX_SEND_LENGTH];
+	testReferenceMQTT(message);
+	uint8_t length = protocolFormatMQTT(topic, sizeof(topic), MY_MQTT_SUBSCRIBE_TOPIC_PREFIX,
+	                                    message);
+	if (strcmp(topic, _testReference) || length != strlen(topic)) {
+		testFail("MQTT topic", message, topic);
+		return;
+	}
+	length = protocolFormatPayload(payload, sizeof(payload), message);
+	(void)strcpy(_testReference, _testReferencePayload);
+	if (strcmp(payload, _testReference) || length != strlen(payload)) {
+		testFail("MQTT payload", message, payload);
+		return;
+	}
+	testTruncation("MQTT payload truncated", message, payload, testFormatPayload);
+
+	MyMessage parsed;
+	if (!protocolMQTT2MyMessage(parsed, topic, (uint8_t *)payload, length) ||
+	        parsed.getDestination() != message.getSender() ||
+	        parsed.getSensor() != message.getSensor() || parsed.getCommand() != message.getCommand() ||
+	        parsed.getRequestEcho() != message.isEcho() || parsed.getType() != message.getType() ||
+	        parsed.getSender() != GATEWAY_ADDRESS) {
+		testFail("MQTT parse header", message, topic);
+		return;
+	}
+	if (message.getCommand() == C_STREAM && message.getPayloadType() == P_CUSTOM) {
+		if (parsed.getPayloadType() != P_CUSTOM || parsed.getLength() != message.getLength() ||
+		        memcmp(parsed.data, message.data, message.getLength())) {
+			testFail("MQTT parse stream", message, payload);
+		}
+	} else if (message.getCommand() != C_STREAM) {
+		const uint8_t payloadLength = min((uint8_t)strlen(_testReferencePayload),
+		                                  (uint8_t)MAX_PAYLOAD_SIZE);
+		if (parsed.getPayloadType() != P_STRING || parsed.getLength() != payloadLength ||
+		        memcmp(parsed.data, _testReferencePayload, payloadLength)) {
+			testFail("MQTT parse payload", message, payload);
+		}
+	}
+}
+
+// The serial parser before protocolSerialParse, with the C_STREAM payload bounded
+static bool testReferenceParse(MyMessage &message, char *inputString)
+{
+	char *str, *p;
+	uint8_t index = 0;
+	mysensors_command_t command = C_INVALID_7;
+	message.setSender(GATEWAY_ADDRESS);
+	message.setLast(GATEWAY_ADDRESS);
+	message.setEcho(false);
+
+	for (str = strtok_r(inputString, ";", &p); str && index < 5;
+	        str = strtok_r(NULL, ";", &p), index++) {
+		switch (index) {
+		case 0:
+			message.setDestination(atoi(str));
+			break;
+		case 1:
+			message.setSensor(atoi(str));
+			break;
+		case 2:
+			command = static_cast<mysensors_command_t>(atoi(str));
+			message.setCommand(command);
+			break;
+		case 3:
+			message.setRequestEcho(atoi(str) ? 1 : 0);
+			break;
+		case 4:
+			message.setType(atoi(str));
+			break;
+		}
+	}
+	if (str == NULL) {
+		message.set((uint8_t)0);
+	} else if (command == C_STREAM) {
+		uint8_t bvalue[MAX_PAYLOAD_SIZE];
+		uint8_t blen = 0;
+		while (*str && str[1] && blen < MAX_PAYLOAD_SIZE) {
+			uint8_t val = convertH2I(*str++) << 4;
+			val += convertH2I(*str++);
+			bvalue[blen++] = val;
+		}
+		message.set(bvalue, blen);
+	} else {
+		message.set(str);
+	}
+	return (index == 5);
+}
+
+static void testParseFail(const char *name, const char *line, const MyMessage &expected,
+                          const MyMessage &result)
+{
+	char expectedPayload[MAX_PAYLOAD_SIZE * 2 + 1];
+	char resultPayload[MAX_PAYLOAD_SIZE * 2 + 1];
+	printf("FAIL %s: \"%s\", expected %" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s, got %"
+	       PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%" PRIu8 ";%s\n", name, line,
+	       expected.getDestination(), expected.getSensor(), expected.getCommand(),
+	       expected.getRequestEcho(), expected.getType(), expected.getString(expectedPayload),
+	       result.getDestination(), result.getSensor(), result.getCommand(), result.getRequestEcho(),
+	       result.getType(), result.getString(resultPayload));
+	_testFailed++;
+}
+
+static bool testSameMessage(const MyMessage &expected, const MyMessage &result)
+{
+	return expected.getDestination() == result.getDestination() &&
+	       expected.getSensor() == result.getSensor() && expected.getCommand() == result.getCommand() &&
+	       expected.getRequestEcho() == result.getRequestEcho() && expected.getType() == result.getType() &&
+	       expected.getSender() == result.getSender() && expected.getPayloadType() == result.getPayloadType() &&
+	       expected.getLength() == result.getLength() &&
+	       !memcmp(expected.data, result.data, expected.getLength());
+}
+
+// Random line, either anything from an alphabet with many separators or a valid header with a
+// mostly hexadecimal payload
+static void testRandomLine(char *line, const uint8_t size)
+{
+	static const char alphabet[] = "0123456789;;;;;abcdefABCDEF#xyz.";
+	uint8_t length = 0;
+	if (rand() & 1) {
+		length = rand() % size;
+		for (uint8_t i = 0; i < length; i++) {
+			line[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+		}
+	} else {
+		length = snprintf(line, size, "%u;%u;%u;%u;%u;", rand() % 300, rand() % 256, rand() % 5,
+		                  rand() % 2, rand() % 256);
+		const uint8_t payloadLength = rand() % 60;
+		for (uint8_t i = 0; i < payloadLength && length < size - 1; i++) {
+			line[length++] = (rand() % 50) ? "0123456789abcdef"[rand() % 16] :
+			                 alphabet[rand() % (sizeof(alphabet) - 1)];
+		}
+	}
+	line[length] = 0;
+}
+
+static void testParserFuzz(void)
+{
+	char line[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+	char copy[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+	uint32_t failed = _testFailed;
+	srand(4);
+	for (uint32_t i = 0; i < TEST_FUZZ_LINES && _testFailed - failed < 10u; i++) {
+		testRandomLine(line, sizeof(line));
+		MyMessage expected;
+		MyMessage result;
+		(void)strcpy(copy, line);
+		const bool expectedOk = testReferenceParse(expected, copy);
+		(void)strcpy(copy, line);
+		const bool resultOk = protocolSerial2MyMessage(result, copy);
+		// command numbers above 7 wrap into the 3 bit header field, the old parser then took a
+		// text payload as stream
+		if (expectedOk && expected.getCommand() == C_STREAM) {
+			char *p;
+			(void)strcpy(copy, line);
+			(void)strtok_r(copy, ";", &p);
+			(void)strtok_r(NULL, ";", &p);
+			if (atoi(strtok_r(NULL, ";", &p)) != C_STREAM) {
+				continue;
+			}
+		}
+		if (expectedOk != resultOk || (expectedOk && !testSameMessage(expected, result))) {
+			testParseFail("parser differs from strtok parser", line, expected, result);
+		}
+	}
+
+	// Arbitrary bytes, with overlong lines and CR/LF, must never overrun the payload
+	protocolSerialParser_t parser;
+	protocolSerialParserReset(parser);
+	MyMessage message;
+	for (uint32_t i = 0; i < TEST_FUZZ_BYTES; i++) {
+		char c = (char)rand();
+		if (!(rand() % 7)) {
+			c = ';';
+		} else if (!(rand() % 150)) {
+			c = (rand() & 1) ? '\n' : '\r';
+		}
+		if (protocolSerialParse(parser, message, c) && message.getLength() > MAX_PAYLOAD_SIZE) {
+			printf("FAIL parser payload of %" PRIu8 " bytes\n", message.getLength());
+			_testFailed++;
+			break;
+		}
+	}
+
+	// A valid line is decoded correctly whatever came before it
+	for (uint32_t i = 0; i < TEST_FUZZ_LINES / 10u && _testFailed - failed < 10u; i++) {
+		const uint16_t garbage = rand() % (2u * MY_GATEWAY_MAX_RECEIVE_LENGTH);
+		for (uint16_t j = 0; j < garbage; j++) {
+			char c;
+			do {
+				c = (char)rand();
+			} while (c == '\n' || c == '\r');
+			(void)protocolSerialParse(parser, message, c);
+		}
+		(void)protocolSerialParse(parser, message, '\n');
+		MyMessage expected;
+		expected.setDestination(rand()).setSensor(rand()).setCommand(static_cast<mysensors_command_t>
+		        (rand() % 5)).setRequestEcho(rand() & 1).setType(rand());
+		int length = snprintf(line, sizeof(line), "%u;%u;%u;%u;%u;", expected.getDestination(),
+		                      expected.getSensor(), expected.getCommand(), expected.getRequestEcho(),
+		                      expected.getType());
+		if (expected.getCommand() == C_STREAM) {
+			const uint8_t stream[] = { 0x0A, 0x1B };
+			(void)snprintf(&line[length], sizeof(line) - length, "0A1B");
+			expected.set(stream, sizeof(stream));
+		} else {
+			(void)snprintf(&line[length], sizeof(line) - length, "v%u", (unsigned)rand());
+			expected.set(&line[length]);
+		}
+		expected.setSender(GATEWAY_ADDRESS).setLast(GATEWAY_ADDRESS).setEcho(false);
+		bool early = false;
+		for (const char *c = line; *c; c++) {
+			early |= protocolSerialParse(parser, message, *c);
+		}
+		const bool ok = protocolSerialParse(parser, message, '\n') && !early;
+		if (!ok || !testSameMessage(expected, message)) {
+			testParseFail("parser after garbage", line, expected, message);
+		}
+	}
+	printf("Parser: %" PRIu32 " random lines compared with the strtok parser, %" PRIu32
+	       " random bytes\n", TEST_FUZZ_LINES, TEST_FUZZ_BYTES);
+}
+
+static double testNow(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+static void testBenchmark(void)
+{
+	static MyMessage messages[TEST_BENCH_MESSAGES];
+	char buffer[MY_GATEWAY_MAX_SEND_LENGTH];
+	uint32_t sink = 0;
+	srand(3);
+	for (uint16_t i = 0; i < TEST_BENCH_MESSAGES; i++) {
+		testRandomMessage(messages[i]);
+	}
+
+	double start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_ROUNDS; round++) {
+		for (uint16_t i = 0; i < TEST_BENCH_MESSAGES; i++) {
+			sink += protocolFormatSerial(buffer, sizeof(buffer), messages[i]);
+		}
+	}
+	const double serial = (testNow() - start) / (TEST_BENCH_ROUNDS * TEST_BENCH_MESSAGES);
+	start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_ROUNDS; round++) {
+		for (uint16_t i = 0; i < TEST_BENCH_MESSAGES; i++) {
+			testReferenceSerial(messages[i]);
+			sink += (uint8_t)_testReference[0];
+		}
+	}
+	const double serialReference = (testNow() - start) / (TEST_BENCH_ROUNDS * TEST_BENCH_MESSAGES);
+
+	start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_ROUNDS; round++) {
+		for (uint16_t i = 0; i < TEST_BENCH_MESSAGES; i++) {
+			sink += protocolFormatMQTT(buffer, sizeof(buffer), MY_MQTT_SUBSCRIBE_TOPIC_PREFIX,
+			                           messages[i]);
+			sink += protocolFormatPayload(buffer, sizeof(buffer), messages[i]);
+		}
+	}
+	const double mqtt = (testNow() - start) / (TEST_BENCH_ROUNDS * TEST_BENCH_MESSAGES);
+	start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_ROUNDS; round++) {
+		for (uint16_t i = 0; i < TEST_BENCH_MESSAGES; i++) {
+			testReferenceMQTT(messages[i]);
+			sink += (uint8_t)_testReference[0] + (uint8_t)_testReferencePayload[0];
+		}
+	}
+	const double mqttReference = (testNow() - start) / (TEST_BENCH_ROUNDS * TEST_BENCH_MESSAGES);
+
+	// A flood of typical controller lines, as one byte stream
+	static char stream[TEST_BENCH_STREAM];
+	uint32_t length = 0;
+	while (length < sizeof(stream) - 64u) {
+		length += snprintf(&stream[length], 64u, "%u;%u;1;0;2;%u\n", rand() % 255, rand() % 255,
+		                   (unsigned)rand());
+	}
+	MyMessage message;
+	uint32_t parsed = 0;
+	start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_STREAM_ROUNDS; round++) {
+		protocolSerialParser_t parser;
+		protocolSerialParserReset(parser);
+		for (uint32_t i = 0; i < length; i++) {
+			parsed += protocolSerialParse(parser, message, stream[i]);
+		}
+	}
+	const double parser = parsed * 1e3 / (testNow() - start);
+	// The line buffer and strtok parser before
+	uint32_t parsedReference = 0;
+	start = testNow();
+	for (uint32_t round = 0; round < TEST_BENCH_STREAM_ROUNDS; round++) {
+		char line[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+		uint8_t index = 0;
+		for (uint32_t i = 0; i < length; i++) {
+			if (stream[i] == '\n') {
+				line[index] = 0;
+				index = 0;
+				parsedReference += testReferenceParse(message, line);
+			} else {
+				line[index++] = stream[i];
+			}
+		}
+	}
+	const double parserReference = parsedReference * 1e3 / (testNow() - start);
+	if (parsed != parsedReference) {
+		printf("FAIL parser benchmark decoded %" PRIu32 " messages, the strtok parser %" PRIu32 "\n",
+		       parsed, parsedReference);
+		_testFailed++;
+	}
+
+	printf("Serial line: %.0f ns per message, snprintf reference %.0f ns\n", serial,
+	       serialReference);
+	printf("MQTT topic and payload: %.0f ns per message, snprintf reference %.0f ns\n", mqtt,
+	       mqttReference);
+	printf("Serial parser: %.2f M messages/s, strtok reference %.2f M messages/s\n", parser,
+	       parserReference);
+	if (!sink) {
+		printf("FAIL benchmark produced no output\n");
+		_testFailed++;
+	}
+}
+
+int main(void)
+{
+	MyMessage message;
+	srand(1);
+	for (uint32_t i = 0; i < TEST_RANDOM_MESSAGES; i++) {
+		testRandomMessage(message);
+		testSerial(message);
+		testMQTT(message);
+		if (_testFailed > 10u) {
+			break;
+		}
+	}
+	printf("Protocol: %" PRIu32 " random messages formatted and parsed back\n", TEST_RANDOM_MESSAGES);
+
+	testParserFuzz();
+	testBenchmark();
+
+	if (_testFailed) {
+		printf("%" PRIu32 " tests FAILED\n", _testFailed);
+		return EXIT_FAILURE;
+	}
+	printf("All tests passed\n");
+	return EXIT_SUCCESS;
+}
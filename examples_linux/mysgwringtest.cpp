@@ -0,0 +1,149 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * Contention test and benchmark of the RX queue between the Linux interrupt thread and the main
+ * loop. A producer thread pushes numbered frames as fast as the queue takes them, the main
+ * thread pops them and checks that every frame arrives once, in order and intact. This runs
+ * with SPSCRingBuffer and with CircularBuffer behind the mutex of MY_CRITICAL_SECTION, which
+ * the Linux HAL used before, and the frames per second of both are printed.
+ *
+ * Build and run: make check
+ * The exit status is 0 if all tests passed.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+// The critical section of the Linux HAL (MyHwLinuxGeneric.h), but with a recursive mutex:
+// CircularBuffer nests it, e.g. getFront() calls full()
+static pthread_mutex_t hw_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static __inline__ void __hwUnlock(const uint8_t *__s)
+{
+	pthread_mutex_unlock(&hw_mutex);
+	(void)__s;
+}
+
+static __inline__ uint8_t __hwLock()
+{
+	pthread_mutex_lock(&hw_mutex);
+	return 1;
+}
+
+#define MY_CRITICAL_SECTION for (uint8_t __atomic_loop __attribute__((__cleanup__(__hwUnlock))) = \
+                                 __hwLock(); __atomic_loop; __atomic_loop = 0)
+
+#include "drivers/CircularBuffer/CircularBuffer.h"
+#include "hal/architecture/Linux/drivers/core/SPSCRingBuffer.h"
+
+#define TEST_FRAMES (2000000u)		//!< Frames passed through each queue
+#define TEST_QUEUE_SIZE (20u)		//!< Records of the queue, the default MY_RX_MESSAGE_BUFFER_SIZE
+#define TEST_FRAME_SIZE (32u)		//!< Payload of a frame, MAX_MESSAGE_SIZE of the RF24
+
+/**
+ * @brief Queued frame, like transportQueuedMessage
+ */
+typedef struct {
+	uint8_t length;					//!< Length of data
+	uint8_t data[TEST_FRAME_SIZE];	//!< Sequence number, repeated over the payload
+} testFrame_t;
+
+static uint32_t _testFailed = 0;
+static testFrame_t _testStorage[TEST_QUEUE_SIZE];
+
+static double testNow(void)
+{
+	struct timespec now;
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+template <class Q> static void *testProducer(void *arg)
+{
+	Q *queue = static_cast<Q *>(arg);
+	for (uint32_t seq = 0; seq < TEST_FRAMES;) {
+		testFrame_t *frame = queue->getFront();
+		if (!frame) {
+			(void)sched_yield();
+			continue;
+		}
+		frame->length = TEST_FRAME_SIZE;
+		for (uint8_t i = 0; i < TEST_FRAME_SIZE; i += sizeof(seq)) {
+			(void)memcpy((void *)&frame->data[i], (const void *)&seq, sizeof(seq));
+		}
+		(void)queue->pushFront(frame);
+		seq++;
+	}
+	return NULL;
+}
+
+template <class Q> static void testQueue(const char *name, Q &queue)
+{
+	pthread_t producer;
+	uint32_t errors = 0;
+	const double start = testNow();
+	if (pthread_create(&producer, NULL, testProducer<Q>, &queue) != 0) {
+		printf("FAIL %s: could not start the producer thread\n", name);
+		_testFailed++;
+		return;
+	}
+	for (uint32_t seq = 0; seq < TEST_FRAMES;) {
+		const testFrame_t *frame = queue.getBack();
+		if (!frame) {
+			(void)sched_yield();
+			continue;
+		}
+		bool intact = frame->length == TEST_FRAME_SIZE;
+		for (uint8_t i = 0; i < TEST_FRAME_SIZE; i += sizeof(seq)) {
+			intact = intact && !memcmp(&frame->data[i], &seq, sizeof(seq));
+		}
+		if (!intact && !errors++) {
+			printf("FAIL %s: frame %" PRIu32 " lost, reordered or torn\n", name, seq);
+			_testFailed++;
+		}
+		(void)queue.popBack();
+		seq++;
+	}
+	(void)pthread_join(producer, NULL);
+	const double elapsed = testNow() - start;
+	if (!queue.empty()) {
+		printf("FAIL %s: frames left after the last one\n", name);
+		_testFailed++;
+	}
+	printf("%s: %.2f M frames/s\n", name, TEST_FRAMES * 1e3 / elapsed);
+}
+
+int main(void)
+{
+	CircularBuffer<testFrame_t> circular(_testStorage, TEST_QUEUE_SIZE);
+	testQueue("CircularBuffer with mutex", circular);
+	SPSCRingBuffer<testFrame_t> spsc(_testStorage, TEST_QUEUE_SIZE);
+	testQueue("SPSCRingBuffer", spsc);
+
+	if (_testFailed) {
+		printf("%" PRIu32 " tests FAILED\n", _testFailed);
+		return EXIT_FAILURE;
+	}
+	printf("All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -32,6 +32,7 @@
 #include <syscall.h>
 #include <unistd.h>
 #include "SoftEeprom.h"
+#include "eventloop.h"
 #include "log.h"
 #include "config.h"
 
@@ -85,9 +86,10 @@ static __inline__ void __hwUnlock(const  uint8_t *__s)
 	(void)__s;
 }
 
-static __inline__ void __hwLock()
+static __inline__ uint8_t __hwLock()
 {
 	pthread_mutex_lock(&hw_mutex);
+	return 1;
 }
 #endif
 
@@ -95,7 +97,7 @@ static __inline__ void __hwLock()
 #define ATOMIC_BLOCK_CLEANUP
 #elif defined(MY_RF24_IRQ_PIN)
 #define ATOMIC_BLOCK_CLEANUP uint8_t __atomic_loop \
-	__attribute__((__cleanup__( __hwUnlock ))) = 1
+	__attribute__((__cleanup__( __hwUnlock ))) = __hwLock()
 #else
 #define ATOMIC_BLOCK_CLEANUP
 #endif	/* DOXYGEN */
@@ -103,7 +105,7 @@ static __inline__ void __hwLock()
 #if defined(DOXYGEN)
 #define ATOMIC_BLOCK
 #elif defined(MY_RF24_IRQ_PIN)
-#define ATOMIC_BLOCK for ( ATOMIC_BLOCK_CLEANUP, __hwLock(); \
+#define ATOMIC_BLOCK for ( ATOMIC_BLOCK_CLEANUP; \
                            __atomic_loop ; __atomic_loop = 0 )
 #else
 #define ATOMIC_BLOCK
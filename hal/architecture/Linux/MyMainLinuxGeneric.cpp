@@ -27,18 +27,46 @@
 #include <syslog.h>
 #include <errno.h>
 #include <getopt.h>
+#include <ctype.h>
 #include "log.h"
 #include "config.h"
+#include "eventloop.h"
 #include "MySensorsCore.h"
 
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NODE_WHITELISTING)
+static volatile sig_atomic_t reload_whitelist = 0;
+
+void handle_sighup(int sig)
+{
+	(void)sig;
+	// The whitelist is reloaded from the main loop
+	reload_whitelist = 1;
+}
+#endif
+
+static volatile sig_atomic_t quit_signal = 0;
+
 void handle_sigint(int sig)
 {
-	if (sig == SIGINT) {
+	if (sig != SIGINT && sig != SIGTERM) {
+		return;
+	}
+	if (quit_signal) {
+		// Second request, the main loop did not get to shut down
+		_exit(EXIT_FAILURE);
+	}
+	// The gateway is shut down from the main loop, the signal may have interrupted a
+	// thread holding a lock that the shutdown needs (e.g. the EEPROM or the log ring)
+	quit_signal = sig;
+	eventLoopNotify();
+}
+
+static void shutdown_gateway(void)
+{
+	if (quit_signal == SIGINT) {
 		logNotice("Received SIGINT\n\n");
-	} else if (sig == SIGTERM) {
-		logNotice("Received SIGTERM\n\n");
 	} else {
-		return;
+		logNotice("Received SIGTERM\n\n");
 	}
 
 #ifdef MY_RF24_IRQ_PIN
@@ -49,8 +77,10 @@ void handle_sigint(int sig)
 	MY_SERIALDEVICE.end();
 #endif
 
+	eventLoopClose();
 	logClose();
 
+	// The EEPROM is written out by its destructor
 	exit(EXIT_SUCCESS);
 }
 
@@ -266,6 +296,66 @@ void set_soft_sign_serial_key(char *key_str)
 	}
 }
 
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NODE_WHITELISTING)
+void load_soft_sign_whitelist(const char *whitelist_file)
+{
+	FILE *fptr;
+	char buf[128];
+	int line = 0, entries = 0;
+
+	fptr = fopen(whitelist_file, "rt");
+	if (!fptr) {
+		logError("Error opening whitelist file \"%s\", keeping the current whitelist.\n",
+		         whitelist_file);
+		return;
+	}
+
+	signerWhitelistReset();
+	while (fgets(buf, sizeof(buf), fptr)) {
+		unsigned int node_id;
+		char key_str[19];
+		uint8_t key[9];
+		int i;
+
+		line++;
+		if (buf[0] == '#' || buf[0] == 10 || buf[0] == 13) {
+			continue;
+		}
+		if (sscanf(buf, "%u %18s", &node_id, key_str) != 2 || node_id > 255 ||
+		        strlen(key_str) != 18) {
+			logWarning("Invalid whitelist entry at %s:%d\n", whitelist_file, line);
+			continue;
+		}
+		for (i = 0; i < 18 && isxdigit(key_str[i]); ++i) {
+			int n;
+			char c = key_str[i];
+			if (c <= '9') {
+				n = c - '0';
+			} else if (c >= 'a') {
+				n = c - 'a' + 10;
+			} else {
+				n = c - 'A' + 10;
+			}
+
+			if ((i & 0x1) == 0) {
+				key[i/2] = n * 16;
+			} else {
+				key[i/2] += n;
+			}
+		}
+		if (i != 18) {
+			logWarning("Invalid whitelist entry at %s:%d\n", whitelist_file, line);
+			continue;
+		}
+		signerWhitelistSet((uint8_t)node_id, key);
+		entries++;
+	}
+	fclose(fptr);
+
+	logInfo("Loaded %d whitelist entries from %s\n", entries, whitelist_file);
+}
+#endif
+
 void print_aes_key(uint8_t *key_ptr = NULL)
 {
 	uint8_t key[16];
@@ -354,6 +444,9 @@ int main(int argc, char *argv[])
 	signal(SIGINT, handle_sigint);
 	signal(SIGTERM, handle_sigint);
 	signal(SIGPIPE, handle_sigint);
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NODE_WHITELISTING)
+	signal(SIGHUP, handle_sighup);
+#endif
 
 	hwRandomNumberInit();
 
@@ -441,6 +534,11 @@ int main(int argc, char *argv[])
 		logSetSyslog(LOG_CONS, LOG_USER);
 	}
 
+	// From here on log lines are written by a background thread
+	if (logSetAsync(1) != 0) {
+		logWarning("Failed to start log thread, logging synchronously.\n");
+	}
+
 	logInfo("Starting gateway...\n");
 	logInfo("Protocol version - %s\n", MYSENSORS_LIBRARY_VERSION);
 
@@ -474,15 +572,30 @@ int main(int argc, char *argv[])
 	}
 #endif
 
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NODE_WHITELISTING)
+	if (conf.soft_whitelist_file) {
+		load_soft_sign_whitelist(conf.soft_whitelist_file);
+	}
+#endif
+
 	if (config_file) {
 		free(config_file);
 	}
 
-	for (;;) {
+	while (!quit_signal) {
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NODE_WHITELISTING)
+		if (reload_whitelist) {
+			reload_whitelist = 0;
+			if (conf.soft_whitelist_file) {
+				load_soft_sign_whitelist(conf.soft_whitelist_file);
+			}
+		}
+#endif
 		_process();  // Process incoming data
 		if (loop) {
 			loop(); // Call sketch loop
 		}
 	}
+	shutdown_gateway();
 	return 0;
 }
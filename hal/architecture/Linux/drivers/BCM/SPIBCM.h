@@ -183,6 +183,19 @@ public:
 	 * @param len Buffer length.
 	 */
 	inline static void transfern(char* buf, uint32_t len);
+	/**
+	 * @brief Send and receive a number of bytes. The BCM driver does not use ioctls, the bytes are
+	 * sent right away.
+	 *
+	 * @param tbuf Sending buffer.
+	 * @param rbuf Receive buffer.
+	 * @param len Buffer length.
+	 */
+	inline static void queue(char* tbuf, char* rbuf, uint32_t len);
+	/**
+	 * @brief Nothing to do, queued bytes are already sent.
+	 */
+	inline static void flush();
 	/**
 	 * @brief Start SPI operations.
 	 */
@@ -257,6 +270,15 @@ void SPIBCMClass::transfern(char* buf, uint32_t len)
 	transfernb(buf, buf, len);
 }
 
+void SPIBCMClass::queue(char* tbuf, char* rbuf, uint32_t len)
+{
+	transfernb(tbuf, rbuf, len);
+}
+
+void SPIBCMClass::flush()
+{
+}
+
 extern SPIBCMClass SPIBCM;
 
 #endif
@@ -28,20 +28,36 @@
 #include <arpa/inet.h>
 #include <cstring>
 #include <unistd.h>
-#include <sys/time.h>
 #include <netinet/tcp.h>
 #include <errno.h>
+#include <fcntl.h>
 #include "log.h"
+#include "eventloop.h"
 
-EthernetClient::EthernetClient() : _sock(-1)
+EthernetClient::EthernetClient() : _sock(-1), _rxHead(0), _rxTail(0)
 {
 }
 
-EthernetClient::EthernetClient(int sock) : _sock(sock)
+EthernetClient::EthernetClient(int sock) : _sock(sock), _rxHead(0), _rxTail(0)
 {
 }
 
 int EthernetClient::connect(const char* host, uint16_t port)
+{
+	return _connect(host, port, false);
+}
+
+int EthernetClient::connectAsync(const char* host, uint16_t port)
+{
+	return _connect(host, port, true);
+}
+
+int EthernetClient::connectAsync(IPAddress ip, uint16_t port)
+{
+	return _connect(ip.toString().c_str(), port, true);
+}
+
+int EthernetClient::_connect(const char* host, uint16_t port, bool async)
 {
 	struct addrinfo hints, *servinfo, *localinfo, *p;
 	int rv;
@@ -83,7 +99,13 @@ int EthernetClient::connect(const char* host, uint16_t port)
 			}
 		}
 
-		if (::connect(_sock, p->ai_addr, p->ai_addrlen) == -1) {
+		if (async && fcntl(_sock, F_SETFL, fcntl(_sock, F_GETFL) | O_NONBLOCK) == -1) {
+			close();
+			logError("fcntl: %s\n", strerror(errno));
+			continue;
+		}
+
+		if (::connect(_sock, p->ai_addr, p->ai_addrlen) == -1 && !(async && errno == EINPROGRESS)) {
 			close();
 			logError("connect: %s\n", strerror(errno));
 			continue;
@@ -97,9 +119,11 @@ int EthernetClient::connect(const char* host, uint16_t port)
 		return -1;
 	}
 
+	eventLoopAdd(_sock);
+
 	void *addr = &(((struct sockaddr_in*)p->ai_addr)->sin_addr);
 	inet_ntop(p->ai_family, addr, s, sizeof s);
-	logDebug("connected to %s\n", s);
+	logDebug("%s %s\n", async ? "connecting to" : "connected to", s);
 
 	freeaddrinfo(servinfo); // all done with this structure
 	if (use_bind) {
@@ -153,23 +177,30 @@ size_t EthernetClient::write(const char *buffer, size_t size)
 	return write((const uint8_t *)buffer, size);
 }
 
-int EthernetClient::available()
+int EthernetClient::_fill()
 {
-	int count = 0;
-
-	if (_sock != -1) {
-		ioctl(_sock, SIOCINQ, &count);
+	if (_rxHead == _rxTail && _sock != -1) {
+		// Take everything that is pending at once, callers then consume it byte by byte
+		int rc = recv(_sock, _rxBuffer, sizeof(_rxBuffer), MSG_DONTWAIT);
+		_rxHead = 0;
+		_rxTail = rc > 0 ? rc : 0;
+	}
+	if (_rxHead != _rxTail) {
+		// The socket no longer looks readable, keep the main loop from blocking on it
+		eventLoopWakeupIn(0);
 	}
+	return _rxTail - _rxHead;
+}
 
-	return count;
+int EthernetClient::available()
+{
+	return _fill();
 }
 
 int EthernetClient::read()
 {
-	uint8_t b;
-	if ( recv(_sock, &b, 1, MSG_DONTWAIT) > 0 ) {
-		// recv worked
-		return b;
+	if (_fill() > 0) {
+		return _rxBuffer[_rxHead++];
 	} else {
 		// No data available
 		return -1;
@@ -178,15 +209,25 @@ int EthernetClient::read()
 
 int EthernetClient::read(uint8_t *buf, size_t bytes)
 {
-	return recv(_sock, buf, bytes, MSG_DONTWAIT);
+	size_t buffered = _rxTail - _rxHead;
+	if (buffered == 0) {
+		return recv(_sock, buf, bytes, MSG_DONTWAIT);
+	}
+	if (buffered > bytes) {
+		buffered = bytes;
+	}
+	memcpy(buf, _rxBuffer + _rxHead, buffered);
+	_rxHead += buffered;
+	if (_rxHead != _rxTail) {
+		eventLoopWakeupIn(0);
+	}
+	return buffered;
 }
 
 int EthernetClient::peek()
 {
-	uint8_t b;
-
-	if (recv(_sock, &b, 1, MSG_PEEK | MSG_DONTWAIT) > 0) {
-		return b;
+	if (_fill() > 0) {
+		return _rxBuffer[_rxHead];
 	} else {
 		return -1;
 	}
@@ -197,7 +238,7 @@ void EthernetClient::flush()
 	int count = 0;
 
 	if (_sock != -1) {
-		while (true) {
+		while (status() == ETHERNETCLIENT_W5100_ESTABLISHED) {
 			ioctl(_sock, SIOCOUTQ, &count);
 			if (count == 0) {
 				return;
@@ -213,26 +254,15 @@ void EthernetClient::stop()
 		return;
 	}
 
-	// attempt to close the connection gracefully (send a FIN to other side)
+	// close the connection gracefully (send a FIN to other side), the kernel takes care of the
+	// rest of the shutdown once the descriptor is closed
 	shutdown(_sock, SHUT_RDWR);
 
-	timeval startTime, curTime;
-	gettimeofday(&startTime, NULL);
-
-	// wait up to a second for the connection to close
-	do {
-		uint8_t s = status();
-		if (s == ETHERNETCLIENT_W5100_CLOSED) {
-			break; // exit the loop
-		}
-		usleep(1000);
-		gettimeofday(&curTime, NULL);
-	} while (((curTime.tv_sec - startTime.tv_sec) * 1000000) + (curTime.tv_usec - startTime.tv_usec) <
-	         1000000);
-
 	// free up the socket descriptor
+	eventLoopRemove(_sock);
 	::close(_sock);
 	_sock = -1;
+	_rxHead = _rxTail = 0;
 }
 
 uint8_t EthernetClient::status()
@@ -282,9 +312,11 @@ uint8_t EthernetClient::connected()
 void EthernetClient::close()
 {
 	if (_sock != -1) {
+		eventLoopRemove(_sock);
 		::close(_sock);
 		_sock = -1;
 	}
+	_rxHead = _rxTail = 0;
 }
 
 void EthernetClient::bind(IPAddress ip)
@@ -37,6 +37,8 @@
 #define ETHERNETCLIENT_W5100_CLOSE_WAIT 0x1C
 #define ETHERNETCLIENT_W5100_LAST_ACK 0x1D
 
+#define ETHERNETCLIENT_RX_BUFFER_SIZE 1024 //!< Bytes taken from the socket with a single recv
+
 /**
  * EthernetClient class
  */
@@ -70,6 +72,26 @@ public:
 	 * @return 1 if SUCCESS or -1 if FAILURE.
 	 */
 	virtual int connect(IPAddress ip, uint16_t port);
+	/**
+	 * @brief Start a connection with host:port without waiting for it to be established.
+	 *
+	 * Progress is reported by status(): ETHERNETCLIENT_W5100_SYNSENT while the connection is
+	 * pending, ETHERNETCLIENT_W5100_ESTABLISHED once connected and ETHERNETCLIENT_W5100_CLOSED
+	 * if it failed. Name resolution still blocks, use a dotted IP address to avoid it.
+	 *
+	 * @param host name to resolve or a stringified dotted IP address.
+	 * @param port to connect to.
+	 * @return 1 if the connection was started or -1 if FAILURE.
+	 */
+	int connectAsync(const char *host, uint16_t port);
+	/**
+	 * @brief Start a connection with ip:port without waiting for it to be established.
+	 *
+	 * @param ip to connect to.
+	 * @param port to connect to.
+	 * @return 1 if the connection was started or -1 if FAILURE.
+	 */
+	int connectAsync(IPAddress ip, uint16_t port);
 	/**
 	 * @brief Write a byte.
 	 *
@@ -127,13 +149,14 @@ public:
 	 */
 	virtual int peek();
 	/**
-	 * @brief Waits until all outgoing bytes in buffer have been sent.
+	 * @brief Waits until all outgoing bytes in buffer have been sent, or the connection is
+	 * no longer established.
 	 */
 	virtual void flush();
 	/**
 	 * @brief Close the connection gracefully.
 	 *
-	 * Send a FIN and wait 1s for a response. If no response close it forcefully.
+	 * Send a FIN and release the socket, the kernel completes the shutdown in the background.
 	 */
 	virtual void stop();
 	/**
@@ -206,6 +229,17 @@ public:
 private:
 	int _sock; //!< @brief Network socket file descriptor.
 	IPAddress _srcip; //!< @brief Local ip to bind to.
+	uint8_t _rxBuffer[ETHERNETCLIENT_RX_BUFFER_SIZE]; //!< @brief Data received but not read yet.
+	uint16_t _rxHead; //!< @brief Position of the next byte to read in _rxBuffer.
+	uint16_t _rxTail; //!< @brief End of the received data in _rxBuffer.
+
+	/**
+	 * @brief Refill the receive buffer with whatever the socket has, if the buffer is empty.
+	 *
+	 * @return number of buffered bytes.
+	 */
+	int _fill();
+	int _connect(const char *host, uint16_t port, bool async);
 };
 
 #endif
@@ -29,11 +29,24 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include "log.h"
+#include "eventloop.h"
 #include "EthernetClient.h"
 
-EthernetServer::EthernetServer(uint16_t port, uint16_t max_clients) : port(port),
-	max_clients(max_clients), sockfd(-1)
+static uint64_t _monotonicMillis(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+EthernetServer::EthernetServer(uint16_t port, uint16_t max_clients, uint32_t flush_delay) :
+	port(port), max_clients(max_clients), sockfd(-1), epollfd(-1), evicted(0),
+	flushDelay(flush_delay), flushAt(0)
 {
 	clients.reserve(max_clients);
 }
@@ -56,6 +69,15 @@ void EthernetServer::begin(IPAddress address)
 		sockfd = -1;
 	}
 
+	if (epollfd == -1) {
+		if ((epollfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			logError("epoll_create1: %s\n", strerror(errno));
+			return;
+		}
+		// Wake up the main loop whenever the server has something to do
+		eventLoopAdd(epollfd);
+	}
+
 	memset(&hints, 0, sizeof hints);
 	hints.ai_family = AF_UNSPEC;
 	hints.ai_socktype = SOCK_STREAM;
@@ -105,6 +127,14 @@ void EthernetServer::begin(IPAddress address)
 
 	fcntl(sockfd, F_SETFL, O_NONBLOCK);
 
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = sockfd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, sockfd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+	}
+
 	struct sockaddr_in *ipv4 = (struct sockaddr_in *)p->ai_addr;
 	void *addr = &(ipv4->sin_addr);
 	inet_ntop(p->ai_family, addr, ipstr, sizeof ipstr);
@@ -113,25 +143,7 @@ void EthernetServer::begin(IPAddress address)
 
 bool EthernetServer::hasClient()
 {
-	// Check if any client has disconnected
-	for (size_t i = 0; i < clients.size(); ++i) {
-		EthernetClient client(clients[i]);
-		if (!client.connected()) {
-			// Checks if this disconnected client is also on the new clients list
-			for (std::list<int>::iterator it = new_clients.begin(); it != new_clients.end(); ++it) {
-				if (*it == clients[i]) {
-					new_clients.erase(it);
-					break;
-				}
-			}
-			client.stop();
-			clients[i] = clients.back();
-			clients.pop_back();
-			logDebug("Ethernet client disconnected.\n");
-		}
-	}
-
-	_accept();
+	_processEvents();
 
 	return !new_clients.empty();
 }
@@ -140,11 +152,18 @@ EthernetClient EthernetServer::available()
 {
 	if (new_clients.empty()) {
 		return EthernetClient();
-	} else {
-		int sock = new_clients.front();
-		new_clients.pop_front();
-		return EthernetClient(sock);
 	}
+
+	int sock = new_clients.front();
+	new_clients.pop_front();
+	for (size_t i = 0; i < clients.size(); ++i) {
+		if (clients[i].fd == sock) {
+			int handle = clients[i].handle;
+			clients[i].handle = -1;
+			return EthernetClient(handle);
+		}
+	}
+	return EthernetClient();
 }
 
 size_t EthernetServer::write(uint8_t b)
@@ -156,13 +175,21 @@ size_t EthernetServer::write(const uint8_t *buffer, size_t size)
 {
 	size_t n = 0;
 
-	for (size_t i = 0; i < clients.size(); ++i) {
-		EthernetClient client(clients[i]);
-		if (client.status() == ETHERNETCLIENT_W5100_ESTABLISHED) {
-			n += client.write(buffer, size);
+	for (size_t i = 0; i < clients.size();) {
+		if (_send(clients[i], buffer, size)) {
+			n += size;
+			++i;
+		} else {
+			_remove(i, true);
 		}
 	}
 
+	if (n > 0 && flushAt == 0) {
+		flushAt = _monotonicMillis() + flushDelay;
+		// Make sure the main loop does not sleep past the deadline
+		eventLoopWakeupIn(flushDelay);
+	}
+
 	return n;
 }
 
@@ -179,6 +206,19 @@ size_t EthernetServer::write(const char *buffer, size_t size)
 	return write((const uint8_t *)buffer, size);
 }
 
+void EthernetServer::flush()
+{
+	flushAt = 0;
+	for (size_t i = 0; i < clients.size();) {
+		// Clients waiting for writability are flushed on EPOLLOUT
+		if (clients[i].watching || _flush(clients[i])) {
+			++i;
+		} else {
+			_remove(i, true);
+		}
+	}
+}
+
 void EthernetServer::_accept()
 {
 	int new_fd;
@@ -202,10 +242,214 @@ void EthernetServer::_accept()
 		return;
 	}
 
+	// The server keeps its own descriptor so that it notices the hang up
+	// even if the user of available() closes the other one first
+	int handle = dup(new_fd);
+	if (handle == -1) {
+		logError("dup: %s\n", strerror(errno));
+		close(new_fd);
+		return;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.fd = new_fd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, new_fd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		close(handle);
+		close(new_fd);
+		return;
+	}
+
+	EthernetServerClient client;
+	client.fd = new_fd;
+	client.handle = handle;
+	client.head = 0;
+	client.queued = 0;
+	client.highWater = 0;
+	client.stalledSince = 0;
+	client.watching = false;
+	clients.push_back(client);
 	new_clients.push_back(new_fd);
-	clients.push_back(new_fd);
 
 	void *addr = &(((struct sockaddr_in*)&client_addr)->sin_addr);
 	inet_ntop(client_addr.ss_family, addr, ipstr, sizeof ipstr);
 	logDebug("New connection from %s\n", ipstr);
 }
+
+void EthernetServer::_processEvents()
+{
+	struct epoll_event events[ETHERNETSERVER_MAX_CLIENTS + 1];
+
+	if (epollfd == -1) {
+		return;
+	}
+
+	int n = epoll_wait(epollfd, events, ETHERNETSERVER_MAX_CLIENTS + 1, 0);
+	if (n == -1) {
+		if (errno != EINTR) {
+			logError("epoll_wait: %s\n", strerror(errno));
+		}
+		return;
+	}
+
+	for (int e = 0; e < n; ++e) {
+		if (events[e].data.fd == sockfd) {
+			_accept();
+			continue;
+		}
+
+		size_t i = 0;
+		while (i < clients.size() && clients[i].fd != events[e].data.fd) {
+			++i;
+		}
+		if (i == clients.size()) {
+			continue;
+		}
+
+		if (events[e].events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) {
+			logDebug("Ethernet client disconnected.\n");
+			// Unread data stays available through the handed out descriptor
+			_remove(i, false);
+		} else if ((events[e].events & EPOLLOUT) && !_flush(clients[i])) {
+			_remove(i, true);
+		}
+	}
+
+	if (flushAt != 0 && _monotonicMillis() >= flushAt) {
+		flush();
+	}
+}
+
+bool EthernetServer::_send(EthernetServerClient &client, const uint8_t *buffer, size_t size)
+{
+	if (client.stalledSince != 0 &&
+	        _monotonicMillis() - client.stalledSince > ETHERNETSERVER_CLIENT_TIMEOUT_MS) {
+		logWarning("Evicting ethernet client: no progress for %d ms (%zu bytes queued).\n",
+		           ETHERNETSERVER_CLIENT_TIMEOUT_MS, client.queued);
+		evicted++;
+		return false;
+	}
+
+	if (client.queue.empty()) {
+		client.queue.resize(ETHERNETSERVER_CLIENT_BUFFER_SIZE);
+	}
+	if (client.queued + size > client.queue.size()) {
+		// Make room by sending the batch collected so far
+		if (!client.watching && !_flush(client)) {
+			return false;
+		}
+		if (client.queued + size > client.queue.size()) {
+			logWarning("Evicting ethernet client: output queue full (%zu bytes queued, high water %zu).\n",
+			           client.queued, client.highWater);
+			evicted++;
+			return false;
+		}
+	}
+
+	size_t tail = (client.head + client.queued) % client.queue.size();
+	for (size_t i = 0; i < size; ++i) {
+		client.queue[tail] = buffer[i];
+		tail = (tail + 1) % client.queue.size();
+	}
+	client.queued += size;
+	if (client.queued > client.highWater) {
+		client.highWater = client.queued;
+	}
+
+	return true;
+}
+
+bool EthernetServer::_flush(EthernetServerClient &client)
+{
+	struct iovec iov[2];
+	struct msghdr msg;
+	size_t first;
+
+	if (client.queued == 0) {
+		_watchWrite(client, false);
+		return true;
+	}
+
+	// The pending data wraps around at most once
+	first = client.queue.size() - client.head;
+	if (first > client.queued) {
+		first = client.queued;
+	}
+	iov[0].iov_base = &client.queue[client.head];
+	iov[0].iov_len = first;
+	iov[1].iov_base = &client.queue[0];
+	iov[1].iov_len = client.queued - first;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iov[1].iov_len ? 2 : 1;
+
+	ssize_t rc = sendmsg(client.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (rc == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			// Waiting for a batch flush is not a stall, only a send the kernel does not take
+			if (client.stalledSince == 0) {
+				client.stalledSince = _monotonicMillis();
+			}
+			_watchWrite(client, true);
+			return true;
+		}
+		logError("send: %s\n", strerror(errno));
+		return false;
+	}
+
+	client.head = (client.head + rc) % client.queue.size();
+	client.queued -= rc;
+	client.stalledSince = _monotonicMillis();
+	if (client.queued == 0) {
+		client.head = 0;
+		client.stalledSince = 0;
+		_watchWrite(client, false);
+	} else {
+		// The kernel is full, send the rest once the socket is writable
+		_watchWrite(client, true);
+	}
+
+	return true;
+}
+
+void EthernetServer::_watchWrite(EthernetServerClient &client, bool enable)
+{
+	struct epoll_event ev;
+
+	if (client.watching == enable) {
+		return;
+	}
+	client.watching = enable;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	if (enable) {
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.fd = client.fd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_MOD, client.fd, &ev) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+	}
+}
+
+void EthernetServer::_remove(size_t index, bool teardown)
+{
+	EthernetServerClient &client = clients[index];
+
+	new_clients.remove(client.fd);
+	epoll_ctl(epollfd, EPOLL_CTL_DEL, client.fd, NULL);
+	if (teardown) {
+		// Make sure the connection ends even if the handed out descriptor is still open
+		shutdown(client.fd, SHUT_RDWR);
+	}
+	close(client.fd);
+	if (client.handle != -1) {
+		close(client.handle);
+	}
+
+	clients[index] = clients.back();
+	clients.pop_back();
+}
@@ -24,6 +24,7 @@
 
 #include <list>
 #include <vector>
+#include <stdint.h>
 #include "Server.h"
 #include "IPAddress.h"
 
@@ -34,8 +35,34 @@
 #define ETHERNETSERVER_BACKLOG 10 //!< Maximum length to which the queue of pending connections may grow.
 #endif
 
+#ifndef ETHERNETSERVER_CLIENT_BUFFER_SIZE
+#define ETHERNETSERVER_CLIENT_BUFFER_SIZE 8192 //!< Per client output queue size in bytes.
+#endif
+
+#ifndef ETHERNETSERVER_CLIENT_TIMEOUT_MS
+#define ETHERNETSERVER_CLIENT_TIMEOUT_MS 10000 //!< A client whose queue does not drain within this time is evicted.
+#endif
+
 class EthernetClient;
 
+/**
+ * @brief Connected client as seen by the server.
+ *
+ * Output is collected in a ring buffer so that the messages of one loop pass
+ * go out with a single system call. Data that the kernel does not accept right
+ * away stays queued until the socket becomes writable again.
+ */
+struct EthernetServerClient {
+	int fd; //!< @brief Socket owned by the server.
+	int handle; //!< @brief Duplicate of fd not yet handed out by available(), else -1.
+	std::vector<uint8_t> queue; //!< @brief Ring buffer of pending output.
+	size_t head; //!< @brief Index of the first pending byte in queue.
+	size_t queued; //!< @brief Number of pending bytes in queue.
+	size_t highWater; //!< @brief Largest number of pending bytes seen.
+	uint64_t stalledSince; //!< @brief Time (ms) of the last send progress while the kernel left bytes queued, 0 if none.
+	bool watching; //!< @brief Writability of fd is being watched.
+};
+
 /**
  * @brief EthernetServer class
  */
@@ -48,8 +75,10 @@ public:
 	 *
 	 * @param port number for the socket addresses.
 	 * @param max_clients The maximum number allowed for connected clients.
+	 * @param flush_delay Time (ms) output may be held back to be sent together with later writes.
 	 */
-	EthernetServer(uint16_t port, uint16_t max_clients = ETHERNETSERVER_MAX_CLIENTS);
+	EthernetServer(uint16_t port, uint16_t max_clients = ETHERNETSERVER_MAX_CLIENTS,
+	               uint32_t flush_delay = 0);
 	/**
 	 * @brief Listen for inbound connection request.
 	 *
@@ -83,9 +112,15 @@ public:
 	/**
 	 * @brief Write at most 'size' bytes to all clients.
 	 *
+	 * This never blocks: the data is queued and sent together with the other writes
+	 * of the current loop pass, at the latest flush_delay ms later. Whatever a client
+	 * cannot take right away stays queued until its socket becomes writable. A client
+	 * whose queue overflows or stops draining for ETHERNETSERVER_CLIENT_TIMEOUT_MS is
+	 * disconnected.
+	 *
 	 * @param buffer to read from.
 	 * @param size of the buffer.
-	 * @return 0 if FAILURE else number of bytes sent.
+	 * @return 0 if FAILURE else number of bytes sent or queued.
 	 */
 	virtual size_t write(const uint8_t *buffer, size_t size);
 	/**
@@ -103,19 +138,64 @@ public:
 	 * @return 0 if FAILURE else the number of characters sent.
 	 */
 	size_t write(const char *buffer, size_t size);
+	/**
+	 * @brief Send the queued output of all clients now.
+	 *
+	 */
+	void flush();
 
 private:
 	uint16_t port; //!< @brief Port number for the network socket.
 	std::list<int> new_clients; //!< Socket list of new connected clients.
-	std::vector<int> clients; //!< @brief Socket list of connected clients.
+	std::vector<EthernetServerClient> clients; //!< @brief List of connected clients.
 	uint16_t max_clients; //!< @brief The maximum number of allowed clients.
 	int sockfd; //!< @brief Network socket used to accept connections.
+	int epollfd; //!< @brief epoll instance watching sockfd and the clients.
+	uint32_t evicted; //!< @brief Number of clients dropped because they could not keep up.
+	uint32_t flushDelay; //!< @brief Time (ms) output may be held back for batching.
+	uint64_t flushAt; //!< @brief Time (ms) the queued output is due, 0 if nothing is due.
 
 	/**
 	 * @brief Accept new clients if the total of connected clients is below max_clients.
 	 *
 	 */
 	void _accept();
+	/**
+	 * @brief Handle pending socket events: new connections, hang ups and writable clients.
+	 *
+	 * Also sends the queued output once it is due.
+	 */
+	void _processEvents();
+	/**
+	 * @brief Queue data for a client.
+	 *
+	 * @param client to send to.
+	 * @param buffer to read from.
+	 * @param size of the buffer.
+	 * @return @c false if the client must be removed.
+	 */
+	bool _send(EthernetServerClient &client, const uint8_t *buffer, size_t size);
+	/**
+	 * @brief Try to send the queued data of a client.
+	 *
+	 * @param client to flush.
+	 * @return @c false if the client must be removed.
+	 */
+	bool _flush(EthernetServerClient &client);
+	/**
+	 * @brief Enable or disable writability notifications for a client.
+	 *
+	 * @param client to update.
+	 * @param enable @c true to be notified when the socket is writable.
+	 */
+	void _watchWrite(EthernetServerClient &client, bool enable);
+	/**
+	 * @brief Close a client and forget about it.
+	 *
+	 * @param index of the client in clients.
+	 * @param teardown @c true to shut the connection down, @c false if the peer already hung up.
+	 */
+	void _remove(size_t index, bool teardown);
 };
 
 #endif
@@ -19,177 +19,354 @@
 
 #include "GPIO.h"
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include "log.h"
 
+#define GPIO_CONSUMER "mysgw"
+#define GPIO_MAX_CHIPS 64
+#define GPIO_SYSFS_WAIT_MS 10000 // Time udev may take to make an exported pin accessible
+
 // Declare a single default instance
 GPIOClass GPIO = GPIOClass();
 
-GPIOClass::GPIOClass()
+static bool writeSysfs(const char *file, const char *value)
 {
-	FILE *f;
-	DIR* dp;
-	char file[64];
-
-	dp = opendir("/sys/class/gpio");
-	if (dp == NULL) {
-		logError("Could not open /sys/class/gpio directory");
-		exit(1);
+	FILE *f = fopen(file, "w");
+	if (f == NULL) {
+		return false;
 	}
+	bool ok = fputs(value, f) >= 0;
+	// sysfs reports a rejected value when the buffer is written out
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
 
-	lastPinNum = 0;
-
-	while (true) {
-		dirent *de = readdir(dp);
-		if (de == NULL) {
-			break;
-		}
+static int readSysfsInt(const char *file)
+{
+	int value = -1;
+	FILE *f = fopen(file, "r");
+	if (f == NULL) {
+		logError("Failed to open %s\n", file);
+		return -1;
+	}
+	if (fscanf(f, "%d", &value) != 1) {
+		logError("Failed to read %s\n", file);
+		value = -1;
+	}
+	fclose(f);
+	return value;
+}
 
-		if (strncmp("gpiochip", de->d_name, 8) == 0) {
-			snprintf(file, sizeof(file), "/sys/class/gpio/%s/base", de->d_name);
-			f = fopen(file, "r");
-			int base;
-			if (fscanf(f, "%d", &base) == EOF) {
-				logError("Failed to open %s\n", file);
-				base = 0;
+GPIOClass::GPIOClass()
+{
+	char file[300];
+
+	lastPinNum = -1;
+	numChips = 0;
+	chips = new GPIOChip[GPIO_MAX_CHIPS];
+
+	// Keep the sysfs pin numbering: each /sys/class/gpio/gpiochip<base> tells the base and size of
+	// a chip, its parent device holds the name of the matching character device
+	DIR *dp = opendir("/sys/class/gpio");
+	if (dp != NULL) {
+		dirent *de;
+		while ((de = readdir(dp)) != NULL) {
+			if (strncmp("gpiochip", de->d_name, 8) != 0) {
+				continue;
 			}
-			fclose(f);
-
+			snprintf(file, sizeof(file), "/sys/class/gpio/%s/base", de->d_name);
+			int base = readSysfsInt(file);
 			snprintf(file, sizeof(file), "/sys/class/gpio/%s/ngpio", de->d_name);
-			f = fopen(file, "r");
-			int ngpio;
-			if (fscanf(f, "%d", &ngpio) == EOF) {
-				logError("Failed to open %s\n", file);
-				ngpio = 0;
+			int ngpio = readSysfsInt(file);
+			if (base < 0 || ngpio <= 0) {
+				continue;
+			}
+			// Kernels without the character device only have the sysfs interface
+			const char *chardev = "";
+			snprintf(file, sizeof(file), "/sys/class/gpio/%s/device", de->d_name);
+			DIR *dev = opendir(file);
+			dirent *dde = NULL;
+			if (dev != NULL) {
+				while ((dde = readdir(dev)) != NULL && strncmp("gpiochip", dde->d_name, 8) != 0);
+				if (dde != NULL) {
+					chardev = dde->d_name;
+				}
 			}
-			fclose(f);
+			addChip(base, ngpio, chardev);
+			if (dev != NULL) {
+				closedir(dev);
+			}
+		}
+		closedir(dp);
+	}
 
-			int max = ngpio + base - 1;
-			if (lastPinNum < max) {
-				lastPinNum = max;
+	// Without the sysfs interface number the chips one after another
+	if (numChips == 0) {
+		int base = 0;
+		for (int i = 0; i < GPIO_MAX_CHIPS; i++) {
+			char dev[32];
+			snprintf(dev, sizeof(dev), "gpiochip%d", i);
+			snprintf(file, sizeof(file), "/dev/%s", dev);
+			int fd = open(file, O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				continue;
 			}
+			struct gpiochip_info info;
+			if (ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info) == 0) {
+				addChip(base, info.lines, dev);
+				base += info.lines;
+			}
+			close(fd);
 		}
 	}
-	closedir(dp);
 
-	exportedPins = new uint8_t[lastPinNum + 1];
+	// Not an error on hosts without GPIO, as long as no pin is used
+	if (numChips == 0) {
+		logDebug("No GPIO chips found\n");
+	}
 
+	lineFds = new int[lastPinNum + 1];
+	exportedPins = new uint8_t[lastPinNum + 1];
 	for (int i = 0; i < lastPinNum + 1; ++i) {
+		lineFds[i] = -1;
 		exportedPins[i] = 0;
 	}
 }
 
 GPIOClass::GPIOClass(const GPIOClass& other)
+{
+	copy(other);
+}
+
+GPIOClass::~GPIOClass()
+{
+	release();
+}
+
+void GPIOClass::copy(const GPIOClass& other)
 {
 	lastPinNum = other.lastPinNum;
+	numChips = other.numChips;
+	chips = new GPIOChip[GPIO_MAX_CHIPS];
+	memcpy(chips, other.chips, sizeof(GPIOChip) * GPIO_MAX_CHIPS);
 
+	lineFds = new int[lastPinNum + 1];
 	exportedPins = new uint8_t[lastPinNum + 1];
 	for (int i = 0; i < lastPinNum + 1; ++i) {
+		lineFds[i] = other.lineFds[i] < 0 ? -1 : fcntl(other.lineFds[i], F_DUPFD_CLOEXEC, 0);
 		exportedPins[i] = other.exportedPins[i];
 	}
 }
 
-GPIOClass::~GPIOClass()
+void GPIOClass::release()
 {
-	FILE *f;
-
+	// Closing the line requests hands the lines back to the kernel
 	for (int i = 0; i < lastPinNum + 1; ++i) {
+		if (lineFds[i] >= 0) {
+			close(lineFds[i]);
+		}
 		if (exportedPins[i]) {
-			f = fopen("/sys/class/gpio/unexport", "w");
-			fprintf(f, "%d\n", i);
-			fclose(f);
+			char value[12];
+			snprintf(value, sizeof(value), "%d\n", i);
+			(void)writeSysfs("/sys/class/gpio/unexport", value);
 		}
 	}
-
 	delete [] exportedPins;
+	delete [] lineFds;
+	delete [] chips;
 }
 
-void GPIOClass::pinMode(uint8_t pin, uint8_t mode)
+void GPIOClass::addChip(int base, int ngpio, const char *dev)
 {
-	FILE *f;
-
-	if (pin > lastPinNum) {
+	if (numChips == GPIO_MAX_CHIPS || strlen(dev) >= sizeof(chips[numChips].dev)) {
 		return;
 	}
+	chips[numChips].base = base;
+	chips[numChips].ngpio = ngpio;
+	memcpy(chips[numChips].dev, dev, strlen(dev) + 1);
+	numChips++;
+	if (lastPinNum < base + ngpio - 1) {
+		lastPinNum = base + ngpio - 1;
+	}
+}
 
-	f = fopen("/sys/class/gpio/export", "w");
-	fprintf(f, "%d\n", pin);
-	fclose(f);
+bool GPIOClass::configureSysfs(uint8_t pin, uint64_t flags)
+{
+	char file[64];
+	char value[8];
+
+	if (!exportedPins[pin]) {
+		snprintf(value, sizeof(value), "%u\n", pin);
+		// Fails with EBUSY if the pin is already exported
+		if (!writeSysfs("/sys/class/gpio/export", value) && errno != EBUSY) {
+			logError("Could not export pin %u: %s\n", pin, strerror(errno));
+			return false;
+		}
+		exportedPins[pin] = 1;
+	}
+
+	snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/direction", pin);
+	const char *direction = (flags & GPIO_V2_LINE_FLAG_OUTPUT) ? "out\n" : "in\n";
+	int waited = 0;
+	while (!writeSysfs(file, direction)) {
+		// Wait for the file to become accessible after the export
+		if (waited >= GPIO_SYSFS_WAIT_MS) {
+			logError("Could not set the direction of pin %u: %s\n", pin, strerror(errno));
+			return false;
+		}
+		usleep(10000);
+		waited += 10;
+	}
 
-	int counter = 0;
-	char file[128];
-	sprintf(file, "/sys/class/gpio/gpio%d/direction", pin);
+	if (!(flags & GPIO_V2_LINE_FLAG_OUTPUT)) {
+		const char *edge = "none\n";
+		if ((flags & GPIO_V2_LINE_FLAG_EDGE_RISING) && (flags & GPIO_V2_LINE_FLAG_EDGE_FALLING)) {
+			edge = "both\n";
+		} else if (flags & GPIO_V2_LINE_FLAG_EDGE_RISING) {
+			edge = "rising\n";
+		} else if (flags & GPIO_V2_LINE_FLAG_EDGE_FALLING) {
+			edge = "falling\n";
+		}
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/edge", pin);
+		// Pins without interrupt support have no edge file
+		if (!writeSysfs(file, edge) && strcmp(edge, "none\n") != 0) {
+			logError("Could not set the edge of pin %u: %s\n", pin, strerror(errno));
+			return false;
+		}
+	}
 
-	while ((f = fopen(file,"w")) == NULL) {
-		// Wait 10 seconds for the file to be accessible if not open on first attempt
-		sleep(1);
-		counter++;
-		if (counter > 10) {
-			logError("Could not open /sys/class/gpio/gpio%u/direction", pin);
-			exit(1);
+	if (lineFds[pin] < 0) {
+		snprintf(file, sizeof(file), "/sys/class/gpio/gpio%u/value", pin);
+		if ((lineFds[pin] = open(file, O_RDWR | O_CLOEXEC)) < 0) {
+			logError("Could not open %s: %s\n", file, strerror(errno));
+			return false;
 		}
 	}
-	if (mode == INPUT) {
-		fprintf(f, "in\n");
-	} else {
-		fprintf(f, "out\n");
+	return true;
+}
+
+bool GPIOClass::configure(uint8_t pin, uint64_t flags)
+{
+	if (exportedPins[pin]) {
+		return configureSysfs(pin, flags);
+	}
+	if (lineFds[pin] >= 0) {
+		struct gpio_v2_line_config config;
+		memset(&config, 0, sizeof(config));
+		config.flags = flags;
+		if (ioctl(lineFds[pin], GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+			logError("Could not configure pin %u: %s\n", pin, strerror(errno));
+			return false;
+		}
+		return true;
 	}
 
-	exportedPins[pin] = 1;
+	for (int i = 0; i < numChips; i++) {
+		if (pin < chips[i].base || pin >= chips[i].base + chips[i].ngpio) {
+			continue;
+		}
+		if (chips[i].dev[0] == '\0') {
+			return configureSysfs(pin, flags);
+		}
+		char file[48];
+		snprintf(file, sizeof(file), "/dev/%s", chips[i].dev);
+		int fd = open(file, O_RDWR | O_CLOEXEC);
+		if (fd < 0) {
+			logDebug("Could not open %s: %s, using sysfs for pin %u\n", file, strerror(errno), pin);
+			return configureSysfs(pin, flags);
+		}
+		struct gpio_v2_line_request req;
+		memset(&req, 0, sizeof(req));
+		req.offsets[0] = pin - chips[i].base;
+		req.num_lines = 1;
+		req.config.flags = flags;
+		strncpy(req.consumer, GPIO_CONSUMER, sizeof(req.consumer) - 1);
+		int ret = ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req);
+		close(fd);
+		if (ret < 0) {
+			// Kernels before 5.10 have no uAPI v2
+			logDebug("Could not request pin %u: %s, using sysfs\n", pin, strerror(errno));
+			return configureSysfs(pin, flags);
+		}
+		lineFds[pin] = req.fd;
+		return true;
+	}
+	logError("Pin %u does not belong to any GPIO chip\n", pin);
+	return false;
+}
 
-	fclose(f);
+void GPIOClass::pinMode(uint8_t pin, uint8_t mode)
+{
+	if (pin > lastPinNum) {
+		if (numChips == 0) {
+			logError("No GPIO chips found, pin %u cannot be used\n", pin);
+		}
+		return;
+	}
+
+	if (!configure(pin, mode == INPUT ? GPIO_V2_LINE_FLAG_INPUT : GPIO_V2_LINE_FLAG_OUTPUT)) {
+		exit(1);
+	}
 }
 
 void GPIOClass::digitalWrite(uint8_t pin, uint8_t value)
 {
-	FILE *f;
-	char file[128];
-
 	if (pin > lastPinNum) {
 		return;
 	}
-	if (0 == exportedPins[pin]) {
+	if (lineFds[pin] < 0) {
 		pinMode(pin, OUTPUT);
 	}
 
-	sprintf(file, "/sys/class/gpio/gpio%d/value", pin);
-	f = fopen(file, "w");
-
-	if (value == 0)	{
-		fprintf(f, "0\n");
-	} else {
-		fprintf(f, "1\n");
+	if (exportedPins[pin]) {
+		if (pwrite(lineFds[pin], value ? "1" : "0", 1, 0) != 1) {
+			logError("digitalWrite: failed to write pin %u: %s\n", pin, strerror(errno));
+		}
+		return;
 	}
 
-	fclose(f);
+	struct gpio_v2_line_values values;
+	values.bits = value ? 1 : 0;
+	values.mask = 1;
+	if (ioctl(lineFds[pin], GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+		logError("digitalWrite: failed to write pin %u: %s\n", pin, strerror(errno));
+	}
 }
 
 uint8_t GPIOClass::digitalRead(uint8_t pin)
 {
-	FILE *f;
-	char file[128];
-
 	if (pin > lastPinNum) {
 		return 0;
 	}
-	if (0 == exportedPins[pin]) {
+	if (lineFds[pin] < 0) {
 		pinMode(pin, INPUT);
 	}
 
-	sprintf(file, "/sys/class/gpio/gpio%d/value", pin);
-	f = fopen(file, "r");
+	if (exportedPins[pin]) {
+		char c;
+		if (pread(lineFds[pin], &c, 1, 0) != 1) {
+			logError("digitalRead: failed to read pin %u: %s\n", pin, strerror(errno));
+			return 0;
+		}
+		return c == '1';
+	}
 
-	int i;
-	if (fscanf(f, "%d", &i) == EOF) {
-		logError("digitalRead: failed to read pin %u\n", pin);
-		i = 0;
+	struct gpio_v2_line_values values;
+	values.bits = 0;
+	values.mask = 1;
+	if (ioctl(lineFds[pin], GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+		logError("digitalRead: failed to read pin %u: %s\n", pin, strerror(errno));
+		return 0;
 	}
-	fclose(f);
-	return i;
+	return values.bits & 1;
 }
 
 uint8_t GPIOClass::digitalPinToInterrupt(uint8_t pin)
@@ -197,15 +374,38 @@ uint8_t GPIOClass::digitalPinToInterrupt(uint8_t pin)
 	return pin;
 }
 
+int GPIOClass::edgeDetect(uint8_t pin, bool rising, bool falling)
+{
+	if (pin > lastPinNum) {
+		if (numChips == 0) {
+			logError("No GPIO chips found, pin %u cannot be used\n", pin);
+		}
+		return -1;
+	}
+
+	uint64_t flags = GPIO_V2_LINE_FLAG_INPUT;
+	if (rising) {
+		flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+	}
+	if (falling) {
+		flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	}
+	if (!configure(pin, flags)) {
+		return -1;
+	}
+	return lineFds[pin];
+}
+
+bool GPIOClass::isSysfs(uint8_t pin)
+{
+	return pin <= lastPinNum && exportedPins[pin];
+}
+
 GPIOClass& GPIOClass::operator=(const GPIOClass& other)
 {
 	if (this != &other) {
-		lastPinNum = other.lastPinNum;
-
-		exportedPins = new uint8_t[lastPinNum + 1];
-		for (int i = 0; i < lastPinNum + 1; ++i) {
-			exportedPins[i] = other.exportedPins[i];
-		}
+		release();
+		copy(other);
 	}
 	return *this;
 }
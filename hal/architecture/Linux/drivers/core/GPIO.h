@@ -30,6 +30,12 @@
 
 /**
  * @brief GPIO class
+ *
+ * Pins are numbered like the legacy sysfs interface (chip base + line offset) but are driven
+ * through the GPIO character device. Every pin gets its own line request on first use and the
+ * request fd is kept open, so reading or writing a pin is a single ioctl. On kernels without
+ * the GPIO uAPI v2 (before 5.10) the pin is exported through sysfs instead, with its value file
+ * kept open.
  */
 class GPIOClass
 {
@@ -75,6 +81,26 @@ public:
 	 * @return The same parameter pin number.
 	 */
 	uint8_t digitalPinToInterrupt(uint8_t pin);
+	/**
+	 * @brief Configures the pin as an input with edge detection.
+	 *
+	 * Edge events (struct gpio_v2_line_event) can then be read from the returned fd, which is
+	 * the same one used by digitalRead(). For a pin driven through sysfs the fd is the value
+	 * file, which signals an edge with POLLPRI. The fd stays owned by GPIOClass.
+	 *
+	 * @param pin The number of the pin.
+	 * @param rising Report rising edges.
+	 * @param falling Report falling edges.
+	 * @return The line request fd or -1 on error.
+	 */
+	int edgeDetect(uint8_t pin, bool rising, bool falling);
+	/**
+	 * @brief Tells whether a pin is driven through the legacy sysfs interface.
+	 *
+	 * @param pin The number of the pin.
+	 * @return @c true if the pin was exported through sysfs.
+	 */
+	bool isSysfs(uint8_t pin);
 	/**
 	 * @brief Overloaded assign operator.
 	 *
@@ -82,8 +108,26 @@ public:
 	GPIOClass& operator=(const GPIOClass& other);
 
 private:
+	/**
+	 * @brief A GPIO chip and the pin numbers it covers.
+	 */
+	struct GPIOChip {
+		int base; //!< @brief First pin number of the chip.
+		int ngpio; //!< @brief Number of lines.
+		char dev[32]; //!< @brief Character device name, e.g. gpiochip0.
+	};
+
 	int lastPinNum; //!< @brief Highest pin number supported.
-	uint8_t *exportedPins; //!< @brief Array with information of which pins were exported.
+	int numChips; //!< @brief Number of entries in chips.
+	GPIOChip *chips; //!< @brief Chips found at startup.
+	int *lineFds; //!< @brief Line request fd (or sysfs value fd) of each pin, -1 if not requested yet.
+	uint8_t *exportedPins; //!< @brief Pins exported through sysfs because the character device could not be used.
+
+	void copy(const GPIOClass& other);
+	void release();
+	void addChip(int base, int ngpio, const char *dev);
+	bool configure(uint8_t pin, uint64_t flags);
+	bool configureSysfs(uint8_t pin, uint64_t flags);
 };
 
 extern GPIOClass GPIO;
@@ -41,6 +41,9 @@ uint8_t SPIDEVClass::mode = SPI_MODE0;
 uint32_t SPIDEVClass::speed = SPI_CLOCK_BASE;
 uint8_t SPIDEVClass::bit_order = MSBFIRST;
 struct spi_ioc_transfer SPIDEVClass::tr = {0,0,0,0,0,8,0,0,0,0};	// 8 bits_per_word, 0 cs_change
+struct spi_ioc_transfer SPIDEVClass::queued[SPI_SPIDEV_QUEUE_SIZE];
+uint8_t SPIDEVClass::queueLength = 0;
+uint8_t SPIDEVClass::transactions = 0;
 
 SPIDEVClass::SPIDEVClass()
 {
@@ -154,8 +157,17 @@ void SPIDEVClass::setClockDivider(uint16_t divider)
 
 void SPIDEVClass::chipSelect(int csn_chip)
 {
-	if (csn_chip >= 0 && csn_chip <= 9) {
-		device[13] = '0' + (csn_chip % 10);
+	// header pins of CE0 and CE1, as with the BCM driver
+	if (csn_chip == 24) {
+		csn_chip = 0;
+	} else if (csn_chip == 26) {
+		csn_chip = 1;
+	}
+	// the device is only reopened when another chip is selected
+	if (csn_chip >= 0 && csn_chip <= 9 && device[13] != '0' + csn_chip) {
+		// queued transfers go to the previous chip
+		flush();
+		device[13] = '0' + csn_chip;
 
 		init();
 	}
@@ -169,6 +181,8 @@ uint8_t SPIDEVClass::transfer(uint8_t data)
 
 	pthread_mutex_lock(&spiMutex);
 
+	flush();
+
 	tr.tx_buf = (unsigned long)&tx[0];
 	tr.rx_buf = (unsigned long)&rx[0];
 	tr.len = 1;
@@ -191,6 +205,8 @@ void SPIDEVClass::transfernb(char* tbuf, char* rbuf, uint32_t len)
 
 	pthread_mutex_lock(&spiMutex);
 
+	flush();
+
 	tr.tx_buf = (unsigned long)tbuf;
 	tr.rx_buf = (unsigned long)rbuf;
 	tr.len = len;
@@ -210,12 +226,66 @@ void SPIDEVClass::transfern(char* buf, uint32_t len)
 	transfernb(buf, buf, len);
 }
 
+void SPIDEVClass::queue(char* tbuf, char* rbuf, uint32_t len)
+{
+	pthread_mutex_lock(&spiMutex);
+
+	if (queueLength == SPI_SPIDEV_QUEUE_SIZE) {
+		flush();
+	}
+
+	struct spi_ioc_transfer *transfer = &queued[queueLength++];
+	memset(transfer, 0, sizeof(*transfer));
+	transfer->tx_buf = (unsigned long)tbuf;
+	transfer->rx_buf = (unsigned long)rbuf;
+	transfer->len = len;
+	transfer->speed_hz = speed;
+	transfer->bits_per_word = 8;
+	// release chip select before the next transfer
+	transfer->cs_change = 1;
+
+	// outside of a transaction nobody else sends it
+	if (!transactions) {
+		flush();
+	}
+
+	pthread_mutex_unlock(&spiMutex);
+}
+
+void SPIDEVClass::flush()
+{
+	int ret;
+
+	pthread_mutex_lock(&spiMutex);
+
+	if (queueLength) {
+		// the message ends with the last transfer, chip select is released anyway
+		queued[queueLength - 1].cs_change = 0;
+
+		ret = ioctl(fd, SPI_IOC_MESSAGE(queueLength), queued);
+		if (ret < 1) {
+			logError("Can't send spi message.\n");
+			abort();
+		}
+		queueLength = 0;
+	}
+
+	pthread_mutex_unlock(&spiMutex);
+}
+
 void SPIDEVClass::beginTransaction(SPISettings settings)
 {
 	int ret;
 
 	pthread_mutex_lock(&spiMutex);
 
+	transactions++;
+
+	// queued transfers are sent with the settings they were queued with
+	if (settings.dmode != mode || settings.clock != speed || settings.border != bit_order) {
+		flush();
+	}
+
 	/*
 	 * spi mode
 	 */
@@ -276,6 +346,10 @@ void SPIDEVClass::beginTransaction(SPISettings settings)
 
 void SPIDEVClass::endTransaction()
 {
+	if (transactions && !--transactions) {
+		flush();
+	}
+
 	pthread_mutex_unlock(&spiMutex);
 }
 
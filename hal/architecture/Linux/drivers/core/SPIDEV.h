@@ -53,6 +53,10 @@
 #define SPI_SPIDEV_DEVICE "/dev/spidev0.0"
 #endif
 
+#ifndef SPI_SPIDEV_QUEUE_SIZE
+#define SPI_SPIDEV_QUEUE_SIZE 32	// Transfers sent in a single ioctl
+#endif
+
 // Default to Raspberry Pi
 const uint8_t SS   = 24;
 const uint8_t MOSI = 19;
@@ -147,7 +151,7 @@ public:
 	/**
 	 * @brief Sets the chip select pin.
 	 *
-	 * @param csn_chip Specifies the CS chip.
+	 * @param csn_chip Specifies the CS chip, 0-9 or the header pin of CE0 (24) or CE1 (26).
 	 */
 	static void chipSelect(int csn_chip);
 	/**
@@ -172,6 +176,19 @@ public:
 	* @param len Length of the data
 	*/
 	static void transfern(char* buf, uint32_t len);
+	/**
+	* @brief Queue a transfer, the queued transfers are sent in a single ioctl by flush() or when
+	* the outermost transaction ends. Chip select is released between two transfers.
+	*
+	* @param tbuf Transmit buffer, must stay valid until the transfer is sent
+	* @param rbuf Receive buffer, filled when the transfer is sent
+	* @param len Length of the data
+	*/
+	static void queue(char* tbuf, char* rbuf, uint32_t len);
+	/**
+	* @brief Send the queued transfers.
+	*/
+	static void flush();
 	/**
 	 * @brief Start SPI transaction.
 	 *
@@ -203,6 +220,9 @@ private:
 	static uint32_t speed; //!< @brief SPI speed.
 	static uint8_t bit_order; //!< @brief SPI bit order.
 	static struct spi_ioc_transfer tr; //!< @brief Auxiliar struct for data transfer.
+	static struct spi_ioc_transfer queued[SPI_SPIDEV_QUEUE_SIZE]; //!< @brief Queued transfers.
+	static uint8_t queueLength; //!< @brief Number of queued transfers.
+	static uint8_t transactions; //!< @brief Depth of nested transactions.
 
 	static void init();
 };
@@ -0,0 +1,190 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef SPSCRingBuffer_h
+#define SPSCRingBuffer_h
+
+#include <stdint.h>
+#include <atomic>
+
+#define SPSC_RING_BUFFER_CACHE_LINE 64 //!< Keeps producer and consumer state apart
+
+/**
+ * @brief Lock-free ring buffer for exactly one producer and one consumer thread.
+ *
+ * Same interface as CircularBuffer, but without a critical section: the producer (interrupt
+ * thread) only calls full(), getFront() and pushFront(), the consumer (main loop) only
+ * empty(), getBack() and popBack(). Each side owns one index and publishes it with release
+ * semantics, the other side reads it with acquire semantics.
+ */
+template <class T> class SPSCRingBuffer
+{
+public:
+	/**
+	 * Constructor
+	 * @param buffer   Preallocated buffer of at least size records.
+	 * @param size     Number of records available in the buffer.
+	 */
+	SPSCRingBuffer(T* buffer, const uint8_t size)
+		: m_size(size), m_buff(buffer), m_head(0), m_tailCache(0), m_tail(0), m_headCache(0)
+	{
+	}
+
+	/**
+	 * Clear all entries. Neither producer nor consumer must be active.
+	 */
+	void clear(void)
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+		m_tailCache = 0;
+		m_headCache = 0;
+	}
+
+	/**
+	 * Test if the buffer is empty (consumer).
+	 * @return True, when empty.
+	 */
+	inline bool empty(void) const
+	{
+		const uint16_t tail = m_tail.load(std::memory_order_relaxed);
+		if (m_headCache != tail) {
+			return false;
+		}
+		m_headCache = m_head.load(std::memory_order_acquire);
+		return m_headCache == tail;
+	}
+
+	/**
+	 * Test if the buffer is full (producer).
+	 * @return True, when full.
+	 */
+	inline bool full(void) const
+	{
+		const uint16_t head = m_head.load(std::memory_order_relaxed);
+		if (distance(head, m_tailCache) < m_size) {
+			return false;
+		}
+		m_tailCache = m_tail.load(std::memory_order_acquire);
+		return distance(head, m_tailCache) == m_size;
+	}
+
+	/**
+	 * Return the number of records stored in the buffer.
+	 * @return number of records.
+	 */
+	inline uint8_t available(void) const
+	{
+		const uint16_t tail = m_tail.load(std::memory_order_acquire);
+		return static_cast<uint8_t>(distance(m_head.load(std::memory_order_acquire), tail));
+	}
+
+	/**
+	 * Aquire unused record on front of the buffer, for writing (producer).
+	 * @return Pointer to record, or NULL when buffer is full.
+	 */
+	T* getFront(void) const
+	{
+		return full() ? static_cast<T*>(NULL) : get(m_head.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * Push record to front of the buffer (producer).
+	 * @param record   Record to push. If record was aquired previously (using getFront) its
+	 *                 data will not be copied as it is already present in the buffer.
+	 * @return True, when record was pushed successfully.
+	 */
+	bool pushFront(T* record)
+	{
+		if (full()) {
+			return false;
+		}
+		const uint16_t head = m_head.load(std::memory_order_relaxed);
+		T* f = get(head);
+		if (f != record) {
+			*f = *record;
+		}
+		m_head.store(next(head), std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Aquire record on back of the buffer, for reading (consumer).
+	 * @return Pointer to record, or NULL when buffer is empty.
+	 */
+	T* getBack(void) const
+	{
+		return empty() ? static_cast<T*>(NULL) : get(m_tail.load(std::memory_order_relaxed));
+	}
+
+	/**
+	 * Remove record from back of the buffer (consumer).
+	 * @return True, when record was pop'ed successfully.
+	 */
+	bool popBack(void)
+	{
+		if (empty()) {
+			return false;
+		}
+		m_tail.store(next(m_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+		return true;
+	}
+
+protected:
+	/**
+	 * Internal index increment. Indices run over twice the size, so a full buffer can be told
+	 * apart from an empty one without wasting a record.
+	 * @param idx   Index.
+	 * @return Next index.
+	 */
+	inline uint16_t next(const uint16_t idx) const
+	{
+		return (idx + 1u == 2u * m_size) ? 0u : idx + 1u;
+	}
+
+	/**
+	 * Internal getter for the number of records between two indices.
+	 * @param head   Producer index.
+	 * @param tail   Consumer index.
+	 * @return Number of records.
+	 */
+	inline uint16_t distance(const uint16_t head, const uint16_t tail) const
+	{
+		return (head >= tail) ? head - tail : head + 2u * m_size - tail;
+	}
+
+	/**
+	 * Internal getter for records.
+	 * @param idx   Index.
+	 * @return Ptr to record.
+	 */
+	inline T* get(const uint16_t idx) const
+	{
+		return &(m_buff[(idx < m_size) ? idx : idx - m_size]);
+	}
+
+	const uint8_t      m_size;     //!< Total number of records that can be stored in the buffer.
+	T* const           m_buff;     //!< Ptr to buffer holding all records.
+	alignas(SPSC_RING_BUFFER_CACHE_LINE) std::atomic<uint16_t> m_head; //!< Next record to write, owned by the producer.
+	mutable uint16_t   m_tailCache; //!< Producer's last seen m_tail.
+	alignas(SPSC_RING_BUFFER_CACHE_LINE) std::atomic<uint16_t> m_tail; //!< Next record to read, owned by the consumer.
+	mutable uint16_t   m_headCache; //!< Consumer's last seen m_head.
+};
+
+#endif // SPSCRingBuffer_h
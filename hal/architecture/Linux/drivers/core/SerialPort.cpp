@@ -29,11 +29,13 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include "log.h"
+#include "eventloop.h"
 #include "SerialPort.h"
 
 SerialPort::SerialPort(const char *port, bool isPty) : serialPort(std::string(port)), isPty(isPty)
 {
 	sd = -1;
+	rxHead = rxTail = 0;
 }
 
 void SerialPort::begin(int bauds)
@@ -50,6 +52,7 @@ bool SerialPort::open(int bauds)
 	speed_t speed;
 	struct termios options;
 
+	rxHead = rxTail = 0;
 	if (isPty) {
 		sd = posix_openpt(O_RDWR | O_NOCTTY | O_NDELAY);
 		if (sd < 0) {
@@ -175,6 +178,8 @@ bool SerialPort::open(int bauds)
 
 	usleep(10000);
 
+	eventLoopAdd(sd);
+
 	return true;
 }
 
@@ -213,31 +218,63 @@ bool SerialPort::setGroupPerm(const char *groupName)
 	return false;
 }
 
-int SerialPort::available()
+int SerialPort::fill()
 {
-	int nbytes = 0;
-
-	if (ioctl(sd, FIONREAD, &nbytes) < 0) {
-		logError("Failed to get byte count on serial.\n");
-		exit(-1);
+	if (rxHead == rxTail) {
+		// Take everything that is pending at once, callers then consume it byte by byte
+		int ret = ::read(sd, rxBuffer, sizeof(rxBuffer));
+		rxHead = 0;
+		rxTail = 0;
+		if (ret > 0) {
+			rxTail = ret;
+		} else if (ret < 0 && errno != EAGAIN && errno != EINTR && errno != EIO) {
+			// EIO only means that nobody has the other side of a PTY open
+			logError("Serial - read failed: %s\n", strerror(errno));
+		}
+	}
+	if (rxHead != rxTail) {
+		// The device no longer looks readable, keep the main loop from blocking on it
+		eventLoopWakeupIn(0);
 	}
-	return nbytes;
+	return rxTail - rxHead;
 }
 
-int SerialPort::read()
+int SerialPort::available()
 {
-	unsigned char c;
+	return fill();
+}
 
-	int ret = ::read(sd, &c, 1);
-	if (ret < 0) {
-		logError("Serial - read failed: %s\n", strerror(errno));
-	} else if (ret == 1) {
-		return c;
+int SerialPort::read()
+{
+	if (fill() > 0) {
+		return rxBuffer[rxHead++];
 	}
 
 	return -1;
 }
 
+int SerialPort::read(uint8_t *buffer, size_t size)
+{
+	size_t buffered = rxTail - rxHead;
+	if (buffered == 0) {
+		// Nothing buffered, read straight into the caller's buffer
+		int ret = ::read(sd, buffer, size);
+		if (ret < 0 && errno != EAGAIN && errno != EINTR && errno != EIO) {
+			logError("Serial - read failed: %s\n", strerror(errno));
+		}
+		return ret > 0 ? ret : -1;
+	}
+	if (buffered > size) {
+		buffered = size;
+	}
+	memcpy(buffer, rxBuffer + rxHead, buffered);
+	rxHead += buffered;
+	if (rxHead != rxTail) {
+		eventLoopWakeupIn(0);
+	}
+	return buffered;
+}
+
 size_t SerialPort::write(uint8_t b)
 {
 	int ret = ::write(sd, &b, 1);
@@ -258,13 +295,10 @@ size_t SerialPort::write(const uint8_t *buffer, size_t size)
 
 int SerialPort::peek()
 {
-	FILE * f = fdopen(sd, "r+");
-	int c = getc(f);
-	if (c == EOF) {
-		return -1;
+	if (fill() > 0) {
+		return rxBuffer[rxHead];
 	}
-	ungetc(c, f);
-	return c;
+	return -1;
 }
 
 void SerialPort::flush()
@@ -277,7 +311,9 @@ void SerialPort::flush()
 
 void SerialPort::end()
 {
+	eventLoopRemove(sd);
 	close(sd);
+	rxHead = rxTail = 0;
 
 	if (isPty) {
 		unlink(serialPort.c_str());	// remove the symlink
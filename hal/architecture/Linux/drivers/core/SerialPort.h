@@ -24,6 +24,8 @@
 #include <stdbool.h>
 #include "Stream.h"
 
+#define SERIALPORT_RX_BUFFER_SIZE 1024 //!< Bytes taken from the device with a single read
+
 /**
  * SerialPort Class
  * Class that provides the functionality of arduino Serial library
@@ -35,6 +37,16 @@ private:
 	int sd; //!< @brief file descriptor number.
 	std::string serialPort;	//!< @brief tty name.
 	bool isPty; //!< @brief true if serial is pseudo terminal.
+	uint8_t rxBuffer[SERIALPORT_RX_BUFFER_SIZE]; //!< @brief Data received but not read yet.
+	uint16_t rxHead; //!< @brief Position of the next byte to read in rxBuffer.
+	uint16_t rxTail; //!< @brief End of the received data in rxBuffer.
+
+	/**
+	* @brief Refill the receive buffer with whatever the device has, if the buffer is empty.
+	*
+	* @return number of buffered bytes.
+	*/
+	int fill();
 
 public:
 	/**
@@ -78,6 +90,14 @@ public:
 	*/
 	int read();
 	/**
+	* @brief Reads incoming serial data in bulk.
+	*
+	* @param buffer to store the data.
+	* @param size of the buffer.
+	* @return -1 if no data else number of bytes read.
+	*/
+	int read(uint8_t *buffer, size_t size);
+	/**
 	* @brief Writes a single byte to the serial port.
 	*
 	* @param b byte to write.
@@ -18,37 +18,66 @@
  */
 
 #include <stdlib.h>
-#include <iostream>
-#include <fstream>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
 #include <string.h>
 #include <errno.h>
 #include "log.h"
 #include "SoftEeprom.h"
 
-SoftEeprom::SoftEeprom() : _length(0), _fileName(NULL), _values(NULL)
+#define SOFTEEPROM_JOURNAL_SUFFIX ".journal"
+#define SOFTEEPROM_JOURNAL_MAGIC 0x4A53594Du	// "MYSJ"
+
+// A journal record is this header followed by the committed bytes
+struct softEepromJournal {
+	uint32_t magic;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t crc;
+};
+
+static uint32_t _crc32(const uint8_t *data, size_t length)
 {
+	uint32_t crc = 0xFFFFFFFFu;
+
+	for (size_t i = 0; i < length; ++i) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+		}
+	}
+	return ~crc;
 }
 
-SoftEeprom::SoftEeprom(const SoftEeprom& other)
+SoftEeprom::SoftEeprom() : _length(0), _fileName(NULL), _values(NULL), _mapped(NULL),
+	_record(NULL), _fd(-1), _journalFd(-1), _dirtyStart(0), _dirtyEnd(0),
+	_syncInterval(SOFTEEPROM_SYNC_INTERVAL_MS), _running(false), _stop(false)
 {
-	_fileName = strdup(other._fileName);
+	pthread_condattr_t attr;
 
-	_length = other._length;
-	_values = new uint8_t[_length];
-	for (size_t i = 0; i < _length; ++i) {
-		_values[i] = other._values[i];
-	}
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&_cond, &attr);
+	pthread_condattr_destroy(&attr);
 }
 
 SoftEeprom::~SoftEeprom()
 {
 	destroy();
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
 }
 
-int SoftEeprom::init(const char *fileName, size_t length)
+int SoftEeprom::init(const char *fileName, size_t length, uint32_t syncInterval)
 {
 	struct stat fileInfo;
+	char *journalName;
+	sigset_t all, old;
 
 	destroy();
 
@@ -59,36 +88,73 @@ int SoftEeprom::init(const char *fileName, size_t length)
 	}
 
 	_length = length;
+	_syncInterval = syncInterval;
 	_values = new uint8_t[_length];
 
 	if (stat(_fileName, &fileInfo) != 0) {
 		//File does not exist.  Create it.
 		logInfo("EEPROM file %s does not exist, creating new file.\n", _fileName);
-		std::ofstream myFile(_fileName, std::ios::out | std::ios::binary);
-		if (!myFile) {
+		_fd = open(_fileName, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+		if (_fd == -1) {
 			logError("Unable to create config file %s.\n", _fileName);
+			destroy();
 			return -1;
 		}
 		// Fill the eeprom with 1s
-		for (size_t i = 0; i < _length; ++i) {
-			_values[i] = 0xFF;
+		memset(_values, 0xFF, _length);
+		if (write(_fd, _values, _length) != (ssize_t)_length || fsync(_fd) != 0) {
+			logError("Unable to create config file %s.\n", _fileName);
+			destroy();
+			return -1;
 		}
-		myFile.write((const char*)_values, _length);
-		myFile.close();
 	} else if (fileInfo.st_size < 0 || (size_t)fileInfo.st_size != _length) {
 		logError("EEPROM file %s is not the correct size of %zu.  Please remove the file and a new one will be created.\n",
 		         _fileName, _length);
 		destroy();
 		return -1;
 	} else {
-		//Read config into local memory.
-		std::ifstream myFile(_fileName, std::ios::in | std::ios::binary);
-		if (!myFile) {
+		_fd = open(_fileName, O_RDWR | O_CLOEXEC);
+		if (_fd == -1) {
 			logError("Unable to open EEPROM file %s for reading.\n", _fileName);
+			destroy();
 			return -1;
 		}
-		myFile.read((char*)_values, _length);
-		myFile.close();
+	}
+
+	_mapped = (uint8_t *)mmap(NULL, _length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+	if (_mapped == MAP_FAILED) {
+		_mapped = NULL;
+		logError("Unable to map EEPROM file %s: %s\n", _fileName, strerror(errno));
+		destroy();
+		return -1;
+	}
+
+	journalName = new char[strlen(_fileName) + sizeof(SOFTEEPROM_JOURNAL_SUFFIX)];
+	strcpy(journalName, _fileName);
+	strcat(journalName, SOFTEEPROM_JOURNAL_SUFFIX);
+	_journalFd = open(journalName, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+	if (_journalFd == -1) {
+		logError("Unable to open EEPROM journal %s: %s\n", journalName, strerror(errno));
+		delete[] journalName;
+		destroy();
+		return -1;
+	}
+	delete[] journalName;
+
+	_record = new uint8_t[sizeof(struct softEepromJournal) + _length];
+	if (_recover() != 0) {
+		destroy();
+		return -1;
+	}
+	memcpy(_values, _mapped, _length);
+
+	// Signals are handled by the main thread
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	_running = pthread_create(&_thread, NULL, _syncThread, this) == 0;
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (!_running) {
+		logWarning("Unable to start EEPROM commit thread, writing synchronously.\n");
 	}
 
 	return 0;
@@ -96,6 +162,34 @@ int SoftEeprom::init(const char *fileName, size_t length)
 
 void SoftEeprom::destroy()
 {
+	if (_running) {
+		pthread_mutex_lock(&_mutex);
+		_stop = true;
+		pthread_cond_signal(&_cond);
+		pthread_mutex_unlock(&_mutex);
+		pthread_join(_thread, NULL);
+		_running = false;
+		_stop = false;
+	}
+	if (_mapped) {
+		pthread_mutex_lock(&_mutex);
+		(void)_commit();
+		pthread_mutex_unlock(&_mutex);
+		munmap(_mapped, _length);
+		_mapped = NULL;
+	}
+	if (_journalFd != -1) {
+		close(_journalFd);
+		_journalFd = -1;
+	}
+	if (_fd != -1) {
+		close(_fd);
+		_fd = -1;
+	}
+	if (_record) {
+		delete[] _record;
+		_record = NULL;
+	}
 	if (_values) {
 		delete[] _values;
 		_values = NULL;
@@ -104,6 +198,7 @@ void SoftEeprom::destroy()
 		free(_fileName);
 		_fileName = NULL;
 	}
+	_dirtyEnd = 0;
 	_length = 0;
 }
 
@@ -135,16 +230,24 @@ void SoftEeprom::writeBlock(void* buf, void* addr, size_t length)
 			return;
 		}
 
+		pthread_mutex_lock(&_mutex);
 		memcpy(_values+offs, buf, length);
-
-		std::ofstream myFile(_fileName, std::ios::out | std::ios::in | std::ios::binary);
-		if (!myFile) {
-			logError("Unable to write config to file %s.\n", _fileName);
-			return;
+		if (_dirtyEnd == 0) {
+			_dirtyStart = offs;
+			_dirtyEnd = offs + length;
+			pthread_cond_signal(&_cond);
+		} else {
+			if (offs < _dirtyStart) {
+				_dirtyStart = offs;
+			}
+			if (offs + length > _dirtyEnd) {
+				_dirtyEnd = offs + length;
+			}
+		}
+		if (!_running) {
+			(void)_commit();
 		}
-		myFile.seekp(offs);
-		myFile.write((const char*)buf, length);
-		myFile.close();
+		pthread_mutex_unlock(&_mutex);
 	}
 }
 
@@ -163,19 +266,124 @@ void SoftEeprom::writeByte(int addr, uint8_t value)
 	}
 }
 
-SoftEeprom& SoftEeprom::operator=(const SoftEeprom& other)
+int SoftEeprom::_recover()
 {
-	if (this != &other) {
-		delete[] _values;
-		free(_fileName);
+	struct softEepromJournal header;
+	const size_t headerSize = sizeof(header);
 
-		_fileName = strdup(other._fileName);
+	ssize_t n = pread(_journalFd, _record, headerSize + _length, 0);
+	if (n <= 0) {
+		// No interrupted commit
+		return 0;
+	}
+
+	memset(&header, 0, headerSize);
+	memcpy(&header, _record, n < (ssize_t)headerSize ? n : headerSize);
+	if (n < (ssize_t)headerSize || header.magic != SOFTEEPROM_JOURNAL_MAGIC ||
+	        header.offset > _length || header.length > _length - header.offset ||
+	        (size_t)n < headerSize + header.length ||
+	        header.crc != _crc32(_record + headerSize, header.length)) {
+		// The journal itself was cut short, the file was not touched yet
+		logWarning("Discarding incomplete EEPROM journal.\n");
+	} else {
+		logNotice("Recovering %u bytes of EEPROM from journal.\n", header.length);
+		memcpy(_mapped + header.offset, _record + headerSize, header.length);
+		if (msync(_mapped, _length, MS_SYNC) != 0) {
+			logError("Unable to write EEPROM file %s: %s\n", _fileName, strerror(errno));
+			return -1;
+		}
+	}
+
+	if (ftruncate(_journalFd, 0) != 0) {
+		logError("Unable to reset EEPROM journal: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+int SoftEeprom::_commit()
+{
+	struct softEepromJournal header;
+	const size_t headerSize = sizeof(header);
+	int rc = -1;
+
+	if (_dirtyEnd == 0) {
+		return 0;
+	}
+
+	header.magic = SOFTEEPROM_JOURNAL_MAGIC;
+	header.offset = _dirtyStart;
+	header.length = _dirtyEnd - _dirtyStart;
+	memcpy(_record + headerSize, _values + header.offset, header.length);
+	_dirtyEnd = 0;
+	// New writes may go on while the file is being updated
+	pthread_mutex_unlock(&_mutex);
 
-		_length = other._length;
-		_values = new uint8_t[_length];
-		for (size_t i = 0; i < _length; ++i) {
-			_values[i] = other._values[i];
+	header.crc = _crc32(_record + headerSize, header.length);
+	memcpy(_record, &header, headerSize);
+	const ssize_t size = headerSize + header.length;
+	if (pwrite(_journalFd, _record, size, 0) != size || fdatasync(_journalFd) != 0) {
+		logError("Unable to write EEPROM journal: %s\n", strerror(errno));
+	} else {
+		// The journal is safe on disk, the file may be updated in place now
+		const size_t page = sysconf(_SC_PAGESIZE);
+		const size_t start = header.offset & ~(page - 1);
+		memcpy(_mapped + header.offset, _record + headerSize, header.length);
+		if (msync(_mapped + start, header.offset + header.length - start, MS_SYNC) != 0) {
+			logError("Unable to write EEPROM file %s: %s\n", _fileName, strerror(errno));
+		} else if (ftruncate(_journalFd, 0) != 0) {
+			logError("Unable to reset EEPROM journal: %s\n", strerror(errno));
+		} else {
+			rc = 0;
+		}
+	}
+
+	pthread_mutex_lock(&_mutex);
+	if (rc != 0) {
+		// Try again with the next commit
+		if (_dirtyEnd == 0) {
+			_dirtyStart = header.offset;
+			_dirtyEnd = header.offset + header.length;
+		} else {
+			if (header.offset < _dirtyStart) {
+				_dirtyStart = header.offset;
+			}
+			if (header.offset + header.length > _dirtyEnd) {
+				_dirtyEnd = header.offset + header.length;
+			}
+		}
+	}
+	return rc;
+}
+
+void SoftEeprom::_syncLoop()
+{
+	pthread_mutex_lock(&_mutex);
+	while (!_stop) {
+		if (_dirtyEnd == 0) {
+			pthread_cond_wait(&_cond, &_mutex);
+			continue;
+		}
+
+		// Let further writes join this commit
+		struct timespec deadline;
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += _syncInterval / 1000;
+		deadline.tv_nsec += (long)(_syncInterval % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		while (!_stop && pthread_cond_timedwait(&_cond, &_mutex, &deadline) != ETIMEDOUT) {
 		}
+
+		(void)_commit();
 	}
-	return *this;
+	pthread_mutex_unlock(&_mutex);
+}
+
+void *SoftEeprom::_syncThread(void *arg)
+{
+	static_cast<SoftEeprom *>(arg)->_syncLoop();
+	return NULL;
 }
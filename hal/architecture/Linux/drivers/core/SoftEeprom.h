@@ -19,13 +19,24 @@
 
 /**
 * This a software emulation of EEPROM that uses a file for data storage.
-* A copy of the eeprom values are also held in memory for faster reading.
+* A copy of the eeprom values are also held in memory for faster reading and writing.
+*
+* Writes only touch the memory copy. A background thread commits the changed range
+* to the file: the range is first written to a journal, then copied into a shared
+* mapping of the file which is synced with msync(). A journal left behind by a crash
+* or power loss is replayed by init(), so the file always holds a consistent state.
 */
 
 #ifndef SoftEeprom_h
 #define SoftEeprom_h
 
 #include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#ifndef SOFTEEPROM_SYNC_INTERVAL_MS
+#define SOFTEEPROM_SYNC_INTERVAL_MS 1000 //!< Time (ms) writes are collected before they are committed.
+#endif
 
 /**
  * SoftEeprom class
@@ -38,12 +49,10 @@ public:
 	 * @brief SoftEeprom constructor.
 	 */
 	SoftEeprom();
-	/**
-	 * @brief SoftEeprom copy constructor.
-	 */
-	SoftEeprom(const SoftEeprom& other);
 	/**
 	 * @brief SoftEeprom destructor.
+	 *
+	 * Commits pending writes.
 	 */
 	~SoftEeprom();
 	/**
@@ -51,11 +60,13 @@ public:
 	 *
 	 * @param fileName filepath where the data is saved.
 	 * @param length eeprom size in bytes.
+	 * @param syncInterval time (ms) writes are collected before they are committed.
 	 * @return 0 if SUCCESS or -1 if FAILURE.
 	 */
-	int init(const char *fileName, size_t length);
+	int init(const char *fileName, size_t length,
+	         uint32_t syncInterval = SOFTEEPROM_SYNC_INTERVAL_MS);
 	/**
-	 * @brief Clear all allocated memory variables.
+	 * @brief Commit pending writes and clear all allocated memory variables.
 	 *
 	 */
 	void destroy();
@@ -89,16 +100,57 @@ public:
 	 * @param value to write.
 	 */
 	void writeByte(int addr, uint8_t value);
-	/**
-	 * @brief Overloaded assign operator.
-	 *
-	 */
-	SoftEeprom& operator=(const SoftEeprom& other);
 
 private:
 	size_t _length; //!< @brief Eeprom max size.
 	char *_fileName; //!< @brief file where the eeprom values are stored.
 	uint8_t *_values; //!< @brief copy of the eeprom values held in memory for a faster reading.
+	uint8_t *_mapped; //!< @brief Shared mapping of the file, holds the committed values.
+	uint8_t *_record; //!< @brief Journal record being committed.
+	int _fd; //!< @brief Descriptor of the eeprom file.
+	int _journalFd; //!< @brief Descriptor of the journal file.
+	size_t _dirtyStart; //!< @brief Start of the range not committed yet.
+	size_t _dirtyEnd; //!< @brief End of the range not committed yet, 0 if there is none.
+	uint32_t _syncInterval; //!< @brief Time (ms) writes are collected before they are committed.
+	bool _running; //!< @brief The commit thread is running.
+	bool _stop; //!< @brief The commit thread has to terminate.
+	pthread_t _thread; //!< @brief Thread committing pending writes.
+	pthread_mutex_t _mutex; //!< @brief Protects the memory copy and the dirty range.
+	pthread_cond_t _cond; //!< @brief Signals new writes and termination to the thread.
+
+	/**
+	 * @brief SoftEeprom is not copyable, it owns the file and the commit thread.
+	 */
+	SoftEeprom(const SoftEeprom& other);
+	/**
+	 * @brief SoftEeprom is not copyable, it owns the file and the commit thread.
+	 */
+	SoftEeprom& operator=(const SoftEeprom& other);
+	/**
+	 * @brief Replay the journal left behind by an interrupted commit.
+	 *
+	 * @return 0 if SUCCESS or -1 if FAILURE.
+	 */
+	int _recover();
+	/**
+	 * @brief Write the dirty range to the journal and then to the file.
+	 *
+	 * Must be called with _mutex held, it is released during the file operations.
+	 *
+	 * @return 0 if SUCCESS or -1 if FAILURE.
+	 */
+	int _commit();
+	/**
+	 * @brief Main function of the commit thread.
+	 *
+	 */
+	void _syncLoop();
+	/**
+	 * @brief Entry point of the commit thread.
+	 *
+	 * @param arg the SoftEeprom instance.
+	 */
+	static void *_syncThread(void *arg);
 };
 
 #endif
@@ -57,6 +57,7 @@ int config_parse(const char *config_file)
 	conf.eeprom_size = 0;
 	conf.soft_hmac_key = NULL;
 	conf.soft_serial_key = NULL;
+	conf.soft_whitelist_file = NULL;
 	conf.aes_key = NULL;
 
 	while (fgets(buf, 1024, fptr)) {
@@ -158,6 +159,11 @@ int config_parse(const char *config_file)
 					fclose(fptr);
 					return -1;
 				}
+			} else if (!strncmp(buf, "soft_whitelist_file=", 20)) {
+				if (_config_parse_string(&(buf[20]), "soft_whitelist_file", &conf.soft_whitelist_file)) {
+					fclose(fptr);
+					return -1;
+				}
 			} else if (!strncmp(buf, "aes_key=", 8)) {
 				if (_config_parse_string(&(buf[8]), "aes_key", &conf.aes_key)) {
 					fclose(fptr);
@@ -205,6 +211,9 @@ void config_cleanup(void)
 	if (conf.soft_serial_key) {
 		free(conf.soft_serial_key);
 	}
+	if (conf.soft_whitelist_file) {
+		free(conf.soft_whitelist_file);
+	}
 	if (conf.aes_key) {
 		free(conf.aes_key);
 	}
@@ -249,6 +258,10 @@ int _config_create(const char *config_file)
 	                            "# To generate a serial key run mysgw with: --gen-soft-serial-key\n" \
 	                            "# copy the new key in the line below and uncomment it.\n" \
 	                            "#soft_serial_key=\n" \
+	                            "# File with the nodes trusted when the gateway was built with\n" \
+	                            "# whitelisting, one \"<node id> <soft_serial_key>\" per line.\n" \
+	                            "# Send SIGHUP to mysgw to reload it.\n" \
+	                            "#soft_whitelist_file=/etc/mysensors.whitelist\n" \
 	                            "\n" \
 	                            "# Encryption settings\n" \
 	                            "# Note: The gateway must have been built with encryption\n" \
@@ -38,6 +38,7 @@ struct config {
 	int eeprom_size;
 	char *soft_hmac_key;
 	char *soft_serial_key;
+	char *soft_whitelist_file;
 	char *aes_key;
 } conf;
 
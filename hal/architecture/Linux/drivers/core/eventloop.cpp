@@ -0,0 +1,192 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "eventloop.h"
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "log.h"
+
+#define EVENTLOOP_MAX_EVENTS 16
+// Set in epoll_event.data.u64 of fds watched edge-triggered because they hung up
+#define EVENTLOOP_HUNG_UP (1ull << 32)
+
+static pthread_once_t _eventLoopOnce = PTHREAD_ONCE_INIT;
+static int _epollFd = -1;
+static int _notifyFd = -1;
+static uint64_t _wakeupAt = 0;	// monotonic time in ms, 0 if no wake up is pending
+
+static uint64_t _monotonicMillis(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int _eventLoopArm(int op, int fd, bool hungUp)
+{
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	// A hung up fd (e.g. a PTY without controller) stays ready until the other side comes
+	// back, only wake up on new events then instead of on every wait
+	ev.events = hungUp ? EPOLLIN | EPOLLET : EPOLLIN;
+	ev.data.u64 = (uint32_t)fd | (hungUp ? EVENTLOOP_HUNG_UP : 0);
+	return epoll_ctl(_epollFd, op, fd, &ev);
+}
+
+static void _eventLoopInit(void)
+{
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epollFd == -1) {
+		logError("epoll_create1: %s\n", strerror(errno));
+		return;
+	}
+
+	_notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_notifyFd == -1) {
+		logError("eventfd: %s\n", strerror(errno));
+		return;
+	}
+
+	if (_eventLoopArm(EPOLL_CTL_ADD, _notifyFd, false) == -1) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		close(_notifyFd);
+		_notifyFd = -1;
+	}
+}
+
+int eventLoopAdd(int fd)
+{
+	pthread_once(&_eventLoopOnce, _eventLoopInit);
+
+	if (_epollFd == -1 || fd < 0) {
+		return -1;
+	}
+
+	if (_eventLoopArm(EPOLL_CTL_ADD, fd, false) == -1 && errno != EEXIST) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+void eventLoopRemove(int fd)
+{
+	if (_epollFd == -1 || fd < 0) {
+		return;
+	}
+	// The fd may have never been registered, nothing to report then
+	(void)epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void eventLoopNotify(void)
+{
+	pthread_once(&_eventLoopOnce, _eventLoopInit);
+
+	if (_notifyFd != -1) {
+		const uint64_t one = 1;
+		if (write(_notifyFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+			logError("eventfd write: %s\n", strerror(errno));
+		}
+	}
+}
+
+void eventLoopWakeupIn(uint32_t ms)
+{
+	const uint64_t at = _monotonicMillis() + ms;
+
+	if (_wakeupAt == 0 || at < _wakeupAt) {
+		_wakeupAt = at;
+	}
+}
+
+int eventLoopWait(uint32_t timeoutMs)
+{
+	struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+	int timeout = (int)timeoutMs;
+
+	pthread_once(&_eventLoopOnce, _eventLoopInit);
+
+	if (_wakeupAt != 0) {
+		const uint64_t now = _monotonicMillis();
+		if (_wakeupAt <= now) {
+			timeout = 0;
+		} else if (_wakeupAt - now < (uint64_t)timeout) {
+			timeout = (int)(_wakeupAt - now);
+		}
+	}
+
+	if (_epollFd == -1) {
+		// No epoll available, fall back to a plain sleep
+		usleep(timeout * 1000);
+		_wakeupAt = 0;
+		return 0;
+	}
+
+	int n = epoll_wait(_epollFd, events, EVENTLOOP_MAX_EVENTS, timeout);
+	if (n == -1) {
+		if (errno == EINTR) {
+			return 0;
+		}
+		logError("epoll_wait: %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (_wakeupAt != 0 && _wakeupAt <= _monotonicMillis()) {
+		_wakeupAt = 0;
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int fd = (int)(uint32_t)events[i].data.u64;
+		if (fd == _notifyFd) {
+			// Reset the eventfd counter
+			uint64_t count;
+			if (read(_notifyFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+				logError("eventfd read: %s\n", strerror(errno));
+			}
+			continue;
+		}
+		// EPOLLHUP and EPOLLERR are level-triggered and cannot be masked, switch the fd to
+		// edge-triggered until it reports input without a hang up again
+		const bool hungUp = (events[i].events & (EPOLLHUP | EPOLLERR)) != 0;
+		if (hungUp != ((events[i].data.u64 & EVENTLOOP_HUNG_UP) != 0)) {
+			(void)_eventLoopArm(EPOLL_CTL_MOD, fd, hungUp);
+		}
+	}
+
+	return n;
+}
+
+void eventLoopClose(void)
+{
+	if (_notifyFd != -1) {
+		close(_notifyFd);
+		_notifyFd = -1;
+	}
+	if (_epollFd != -1) {
+		close(_epollFd);
+		_epollFd = -1;
+	}
+}
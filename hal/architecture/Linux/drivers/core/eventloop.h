@@ -0,0 +1,69 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef eventloop_h
+#define eventloop_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register a file descriptor, the next eventLoopWait() returns as soon as it is readable.
+ *
+ * @param fd file descriptor to watch.
+ * @return 0 if SUCCESS or -1 if FAILURE.
+ */
+int eventLoopAdd(int fd);
+/**
+ * @brief Stop watching a file descriptor. Must be called before the fd is closed.
+ *
+ * @param fd file descriptor to remove.
+ */
+void eventLoopRemove(int fd);
+/**
+ * @brief Wake up the main loop. Safe to call from any thread (e.g. interrupt handlers).
+ */
+void eventLoopNotify(void);
+/**
+ * @brief Request a wake up in at most ms milliseconds, without waiting for an event.
+ *
+ * @param ms delay until the wake up.
+ */
+void eventLoopWakeupIn(uint32_t ms);
+/**
+ * @brief Block until a registered fd is readable, eventLoopNotify() is called, a
+ * requested wake up expires or timeoutMs elapsed.
+ *
+ * @param timeoutMs maximum time to block.
+ * @return number of ready events, 0 on timeout or -1 if FAILURE.
+ */
+int eventLoopWait(uint32_t timeoutMs);
+/**
+ * @brief Release the event loop resources.
+ */
+void eventLoopClose(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -33,7 +33,10 @@
 #include <stropts.h>
 #include <errno.h>
 #include <sched.h>
+#include <linux/gpio.h>
 #include "log.h"
+#include "eventloop.h"
+#include "GPIO.h"
 
 struct ThreadArgs {
 	void (*func)();
@@ -46,7 +49,7 @@ static pthread_mutex_t intMutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t *threadIds[64] = {NULL};
 
 // sysFds:
-//	Map a file descriptor from the /sys/class/gpio/gpioX/value
+//	Line request fd of the pin, owned by GPIOClass. Edge events are read from it
 static int sysFds[64] = {
 	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
 	    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
@@ -77,6 +80,7 @@ void *interruptHandler(void *args)
 {
 	int fd;
 	struct pollfd polls;
+	struct gpio_v2_line_event events[16];
 	char c;
 	struct ThreadArgs *arguments = (struct ThreadArgs *)args;
 	int gpioPin = arguments->gpioPin;
@@ -90,24 +94,24 @@ void *interruptHandler(void *args)
 		return NULL;
 	}
 
-	// Setup poll structure
+	// Setup poll structure, a sysfs value file signals an edge with POLLPRI
+	const bool sysfs = GPIO.isSysfs(gpioPin);
 	polls.fd     = fd;
-	polls.events = POLLPRI | POLLERR;
+	polls.events = sysfs ? (POLLPRI | POLLERR) : (POLLIN | POLLERR);
 
 	while (1) {
 		// Wait for it ...
 		int ret = poll(&polls, 1, -1);
 		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
 			logError("Error waiting for interrupt: %s\n", strerror(errno));
 			break;
 		}
-		// Do a dummy read to clear the interrupt
-		//	A one character read appars to be enough.
-		if (lseek (fd, 0, SEEK_SET) < 0) {
-			logError("Interrupt handler error: %s\n", strerror(errno));
-			break;
-		}
-		if (read (fd, &c, 1) < 0) {
+		// Consume the queued edge events, edges that came in together make one call. A sysfs
+		// value file is cleared by reading it from the start
+		if (sysfs ? pread(fd, &c, 1, 0) < 0 : read(fd, events, sizeof(events)) < 0) {
 			logError("Interrupt handler error: %s\n", strerror(errno));
 			break;
 		}
@@ -116,93 +120,71 @@ void *interruptHandler(void *args)
 		if (interruptsEnabled) {
 			pthread_mutex_unlock(&intMutex);
 			func();
+			// Let the main loop process what the handler did
+			eventLoopNotify();
 		} else {
 			pthread_mutex_unlock(&intMutex);
 		}
 	}
 
-	close(fd);
-
 	return NULL;
 }
 
 void attachInterrupt(uint8_t gpioPin, void (*func)(), uint8_t mode)
 {
-	FILE *fd;
-	char fName[40];
-	char c;
-	int count, i;
-
-	if (threadIds[gpioPin] == NULL) {
-		threadIds[gpioPin] = new pthread_t;
-	} else {
-		// Cancel the existing thread for that pin
-		pthread_cancel(*threadIds[gpioPin]);
-		// Wait a bit
-		usleep(1000);
-	}
-
-	// Export pin for interrupt
-	if ((fd = fopen("/sys/class/gpio/export", "w")) == NULL) {
-		logError("attachInterrupt: Unable to export pin %d for interrupt: %s\n", gpioPin, strerror(errno));
-		exit(1);
-	}
-	fprintf(fd, "%d\n", gpioPin);
-	fclose(fd);
-
-	// Wait a bit the system to create /sys/class/gpio/gpio<GPIO number>
-	usleep(1000);
-
-	snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/direction", gpioPin) ;
-	if ((fd = fopen (fName, "w")) == NULL) {
-		logError("attachInterrupt: Unable to open GPIO direction interface for pin %d: %s\n",
-		         gpioPin, strerror(errno));
-		exit(1) ;
-	}
-	fprintf(fd, "in\n") ;
-	fclose(fd) ;
-
-	snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/edge", gpioPin) ;
-	if ((fd = fopen(fName, "w")) == NULL) {
-		logError("attachInterrupt: Unable to open GPIO edge interface for pin %d: %s\n", gpioPin,
-		         strerror(errno));
-		exit(1) ;
-	}
+	bool rising, falling;
+	struct gpio_v2_line_event event;
+	struct pollfd polls;
 
 	switch (mode) {
 	case CHANGE:
-		fprintf(fd, "both\n");
+		rising = falling = true;
 		break;
 	case FALLING:
-		fprintf(fd, "falling\n");
+		rising = false;
+		falling = true;
 		break;
 	case RISING:
-		fprintf(fd, "rising\n");
+		rising = true;
+		falling = false;
 		break;
 	case NONE:
-		fprintf(fd, "none\n");
+		rising = falling = false;
 		break;
 	default:
 		logError("attachInterrupt: Invalid mode\n");
-		fclose(fd);
 		return;
 	}
-	fclose(fd);
 
-	if (sysFds[gpioPin] == -1) {
-		snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/value", gpioPin);
-		if ((sysFds[gpioPin] = open(fName, O_RDWR)) < 0) {
-			logError("Error reading pin %d: %s\n", gpioPin, strerror(errno));
-			exit(1);
-		}
+	if (threadIds[gpioPin] == NULL) {
+		threadIds[gpioPin] = new pthread_t;
+	} else {
+		// Cancel the existing thread for that pin
+		pthread_cancel(*threadIds[gpioPin]);
+		// Wait a bit
+		usleep(1000);
+	}
+
+	if ((sysFds[gpioPin] = GPIO.edgeDetect(gpioPin, rising, falling)) < 0) {
+		logError("attachInterrupt: Unable to set up edge detection for pin %d\n", gpioPin);
+		exit(1);
 	}
 
 	// Clear any initial pending interrupt
-	ioctl(sysFds[gpioPin], FIONREAD, &count);
-	for (i = 0; i < count; ++i) {
-		if (read(sysFds[gpioPin], &c, 1) == -1) {
+	if (GPIO.isSysfs(gpioPin)) {
+		char c;
+		if (pread(sysFds[gpioPin], &c, 1, 0) == -1) {
 			logError("attachInterrupt: failed to read pin status: %s\n", strerror(errno));
 		}
+	} else {
+		polls.fd = sysFds[gpioPin];
+		polls.events = POLLIN;
+		while (poll(&polls, 1, 0) > 0 && (polls.revents & POLLIN)) {
+			if (read(sysFds[gpioPin], &event, sizeof(event)) == -1) {
+				logError("attachInterrupt: failed to read pin events: %s\n", strerror(errno));
+				break;
+			}
+		}
 	}
 
 	struct ThreadArgs *threadArgs = new struct ThreadArgs;
@@ -222,19 +204,11 @@ void detachInterrupt(uint8_t gpioPin)
 		threadIds[gpioPin] = NULL;
 	}
 
-	// Close filehandle
+	// Stop edge detection, the line itself stays requested by GPIOClass
 	if (sysFds[gpioPin] != -1) {
-		close(sysFds[gpioPin]);
+		(void)GPIO.edgeDetect(gpioPin, false, false);
 		sysFds[gpioPin] = -1;
 	}
-
-	FILE *fp = fopen("/sys/class/gpio/unexport", "w");
-	if (fp == NULL) {
-		logError("Unable to unexport pin %d for interrupt\n", gpioPin);
-		exit(1);
-	}
-	fprintf(fp, "%d", gpioPin);
-	fclose(fp);
 }
 
 void interrupts()
@@ -17,6 +17,9 @@
  * version 2 as published by the Free Software Foundation.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* SCHED_BATCH */
+#endif
 #include "log.h"
 #include <stdio.h>
 #include <stdarg.h>
@@ -27,6 +30,16 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdatomic.h>
+
+/* Log ring, must be a power of two */
+#define LOG_RING_SIZE 256
+/* Longest log line, longer lines are truncated */
+#define LOG_LINE_SIZE 256
 
 static const char *_log_level_colors[] = {
 	"\x1b[1;5;91m", "\x1b[1;91m", "\x1b[91m", "\x1b[31m", "\x1b[33m", "\x1b[34m", "\x1b[32m", "\x1b[36m"
@@ -44,6 +57,33 @@ static int _log_pipe_fd = -1;
 
 static FILE *_log_file_fp = NULL;
 
+/*
+ * Asynchronous logging: vlog() formats the line into a ring slot and returns, a writer
+ * thread adds the timestamp and does the actual output. Any thread may log (bounded
+ * MPSC queue, every slot carries a sequence number telling whose turn it is).
+ */
+typedef struct {
+	atomic_uint seq;
+	uint8_t level;
+	time_t time;
+	char text[LOG_LINE_SIZE];
+} log_record_t;
+
+static log_record_t _log_ring[LOG_RING_SIZE];
+static atomic_uint _log_ring_head;
+static unsigned int _log_ring_tail;
+static atomic_uint _log_dropped;
+static atomic_int _log_async;
+static atomic_int _log_producers;	/* vlog() calls that may be queueing a line */
+static atomic_int _log_stop;
+static sem_t _log_sem;
+static pthread_t _log_thread;
+
+static time_t _log_date_time = (time_t)-1;
+static char _log_date[16];
+
+static void logWrite(int level, time_t t, const char *text);
+
 void logSetQuiet(uint8_t enable)
 {
 	_log_quiet = enable ? 1 : 0;
@@ -97,8 +137,96 @@ int logSetFile(char *file)
 	return 0;
 }
 
+static void *logThread(void *arg)
+{
+	(void)arg;
+	/* no wakeup preemption, the gateway loop keeps the CPU until it blocks */
+	struct sched_param param = { 0 };
+	(void)pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+	for (;;) {
+		const int stop = atomic_load(&_log_stop);
+		log_record_t *record = &_log_ring[_log_ring_tail & (LOG_RING_SIZE - 1)];
+		if (atomic_load_explicit(&record->seq, memory_order_acquire) == _log_ring_tail + 1) {
+			logWrite(record->level, record->time, record->text);
+			atomic_store_explicit(&record->seq, _log_ring_tail + LOG_RING_SIZE, memory_order_release);
+			_log_ring_tail++;
+			continue;
+		}
+		const unsigned int dropped = atomic_exchange(&_log_dropped, 0);
+		if (dropped) {
+			char text[64];
+			snprintf(text, sizeof(text), "Log ring full, %u messages dropped\n", dropped);
+			logWrite(LOG_WARNING, time(NULL), text);
+		}
+		if (_log_file_fp != NULL) {
+			fflush(_log_file_fp);
+		}
+		if (stop) {
+			break;
+		}
+		while (sem_wait(&_log_sem) != 0 && errno == EINTR) {
+		}
+	}
+	return NULL;
+}
+
+static void logAtExit(void)
+{
+	logSetAsync(0);
+}
+
+int logSetAsync(uint8_t enable)
+{
+	static uint8_t atExitRegistered = 0;
+	if (!enable == !atomic_load(&_log_async)) {
+		return 0;
+	}
+	if (!enable) {
+		atomic_store(&_log_async, 0);
+		/* let producers that saw the writer running finish queueing their line */
+		while (atomic_load(&_log_producers) != 0) {
+			sched_yield();
+		}
+		atomic_store(&_log_stop, 1);
+		sem_post(&_log_sem);
+		pthread_join(_log_thread, NULL);
+		sem_destroy(&_log_sem);
+		return 0;
+	}
+
+	for (unsigned int i = 0; i < LOG_RING_SIZE; i++) {
+		atomic_init(&_log_ring[i].seq, i);
+	}
+	atomic_store(&_log_ring_head, 0);
+	_log_ring_tail = 0;
+	atomic_store(&_log_stop, 0);
+	if (sem_init(&_log_sem, 0, 0) != 0) {
+		return -1;
+	}
+	/* signals are handled by the main thread */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	int ret = pthread_create(&_log_thread, NULL, logThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (ret != 0) {
+		sem_destroy(&_log_sem);
+		return ret;
+	}
+	if (!atExitRegistered) {
+		/* do not lose queued lines on exit() */
+		atexit(logAtExit);
+		atExitRegistered = 1;
+	}
+	atomic_store(&_log_async, 1);
+	return 0;
+}
+
 void logClose(void)
 {
+	/* write out what is still queued */
+	logSetAsync(0);
+
 	if (_log_syslog) {
 		closelog();
 		_log_syslog = 0;
@@ -123,40 +251,33 @@ void logClose(void)
 	}
 }
 
-void vlog(int level, const char *fmt, va_list args)
+static void logWrite(int level, time_t t, const char *text)
 {
-	if (_log_level < level) {
-		return;
-	}
-
 	if (!_log_quiet || _log_file_fp != NULL) {
-		/* Get current time */
-		time_t t = time(NULL);
-		struct tm *lt = localtime(&t);
-
-		char date[16];
-		date[strftime(date, sizeof(date), "%b %d %H:%M:%S", lt)] = '\0';
+		/* the date only changes once per second */
+		if (t != _log_date_time) {
+			struct tm lt;
+			_log_date[strftime(_log_date, sizeof(_log_date), "%b %d %H:%M:%S", localtime_r(&t, &lt))] = '\0';
+			_log_date_time = t;
+		}
 
 		if (_log_file_fp != NULL) {
-			fprintf(_log_file_fp, "%s %-5s ", date, _log_level_names[level]);
-			vfprintf(_log_file_fp, fmt, args);
-			fflush(_log_file_fp);
+			fprintf(_log_file_fp, "%s %-5s %s", _log_date, _log_level_names[level], text);
 		}
 
 		if (!_log_quiet) {
 #ifdef LOG_DISABLE_COLOR
 			(void)_log_level_colors;
-			fprintf(stderr, "%s %-5s ", date, _log_level_names[level]);
-			vfprintf(stderr, fmt, args);
+			fprintf(stderr, "%s %-5s %s", _log_date, _log_level_names[level], text);
 #else
-			fprintf(stderr, "%s %s%-5s\x1b[0m ", date, _log_level_colors[level], _log_level_names[level]);
-			vfprintf(stderr, fmt, args);
+			fprintf(stderr, "%s %s%-5s\x1b[0m %s", _log_date, _log_level_colors[level],
+			        _log_level_names[level], text);
 #endif
 		}
 	}
 
 	if (_log_syslog) {
-		vsyslog(level, fmt, args);
+		syslog(level, "%s", text);
 	}
 
 	if (_log_pipe) {
@@ -164,13 +285,93 @@ void vlog(int level, const char *fmt, va_list args)
 			_log_pipe_fd = open(_log_pipe_file, O_WRONLY | O_NONBLOCK);
 		}
 		if (_log_pipe_fd > 0) {
-			if (vdprintf(_log_pipe_fd, fmt, args) < 0) {
+			if (write(_log_pipe_fd, text, strlen(text)) < 0) {
 				close(_log_pipe_fd);
 				_log_pipe_fd = -1;
 			}
 		}
+	}
+}
+
+/* without args, fmt is copied as is */
+static void logFormat(char *text, const char *fmt, va_list *args)
+{
+	int len;
+	if (args != NULL) {
+		len = vsnprintf(text, LOG_LINE_SIZE, fmt, *args);
+	} else {
+		len = strlen(fmt);
+		memcpy(text, fmt, len < LOG_LINE_SIZE ? len + 1 : LOG_LINE_SIZE);
+		text[LOG_LINE_SIZE - 1] = '\0';
+	}
+	if (len >= LOG_LINE_SIZE && fmt[strlen(fmt) - 1] == '\n') {
+		/* keep the line end of truncated lines */
+		text[LOG_LINE_SIZE - 2] = '\n';
+	}
+}
 
+static void logLine(int level, const char *fmt, va_list *args)
+{
+	if (_log_level < level) {
+		return;
 	}
+
+	/* announce the line before looking at _log_async, logSetAsync(0) waits for it */
+	atomic_fetch_add(&_log_producers, 1);
+	if (!atomic_load(&_log_async)) {
+		atomic_fetch_sub(&_log_producers, 1);
+		char text[LOG_LINE_SIZE];
+		logFormat(text, fmt, args);
+		logWrite(level, time(NULL), text);
+		if (_log_file_fp != NULL) {
+			fflush(_log_file_fp);
+		}
+		return;
+	}
+
+	/* claim a slot */
+	log_record_t *record;
+	unsigned int pos = atomic_load_explicit(&_log_ring_head, memory_order_relaxed);
+	for (;;) {
+		record = &_log_ring[pos & (LOG_RING_SIZE - 1)];
+		const int diff = (int)(atomic_load_explicit(&record->seq, memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&_log_ring_head, &pos, pos + 1,
+			        memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* full, the writer is behind */
+			atomic_fetch_add_explicit(&_log_dropped, 1, memory_order_relaxed);
+			atomic_fetch_sub(&_log_producers, 1);
+			return;
+		} else {
+			pos = atomic_load_explicit(&_log_ring_head, memory_order_relaxed);
+		}
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+	record->time = ts.tv_sec;
+	record->level = (uint8_t)level;
+	logFormat(record->text, fmt, args);
+	atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+	sem_post(&_log_sem);
+	atomic_fetch_sub(&_log_producers, 1);
+}
+
+void vlog(int level, const char *fmt, va_list args)
+{
+	va_list copy;
+
+	va_copy(copy, args);
+	logLine(level, fmt, &copy);
+	va_end(copy);
+}
+
+void logText(int level, const char *text)
+{
+	logLine(level, text, NULL);
 }
 
 void
@@ -40,9 +40,11 @@ void logSetLevel(int level);
 void logSetSyslog(int options, int facility);
 int logSetPipe(char *pipe_file);
 int logSetFile(char *file);
+int logSetAsync(uint8_t enable);
 void logClose(void);
 
 void vlog(int level, const char *fmt, va_list args);
+void logText(int level, const char *text);
 void logEmergency(const char *fmt, ...) __attribute__((format(printf,1,2)));
 void logAlert(const char *fmt, ...) __attribute__((format(printf,1,2)));
 void logCritical(const char *fmt, ...) __attribute__((format(printf,1,2)));
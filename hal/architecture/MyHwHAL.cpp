@@ -68,4 +68,44 @@ static void hwDebugBuf2Str(const uint8_t *buf, size_t sz)
 	}
 	hwDebugPrintStr[sz * 2] = '\0';
 }
+
+#if defined(MY_DEBUG_EVENTS)
+void hwDebugEvent(const uint8_t id, const uint8_t *args, const uint8_t sz)
+{
+	// ~ID:ARGS, built and written as is, without a format string
+	char str[DEBUG_EVENT_MAX_SIZE * 2 + 6];
+	str[0] = '~';
+	str[1] = convertI2H(id >> 4);
+	str[2] = convertI2H(id);
+	str[3] = ':';
+	uint8_t pos = 4;
+	for (uint8_t i = 0; i < sz; i++) {
+		str[pos++] = convertI2H(args[i] >> 4);
+		str[pos++] = convertI2H(args[i]);
+	}
+	str[pos++] = '\n';
+	str[pos] = '\0';
+#if defined(MY_DEBUG_OTA)
+	DEBUG_OUTPUT(PSTR("%s"), str);
+#elif defined(MY_DISABLED_SERIAL)
+	(void)str;
+#elif !defined(__linux__)
+#ifdef MY_GATEWAY_SERIAL
+	// prepend debug message to be handled correctly by controller (C_INTERNAL, I_LOG_MESSAGE)
+	MY_DEBUGDEVICE.print(F("0;255;"));
+	MY_DEBUGDEVICE.print(C_INTERNAL);
+	MY_DEBUGDEVICE.print(F(";0;"));
+	MY_DEBUGDEVICE.print(I_LOG_MESSAGE);
+	MY_DEBUGDEVICE.print(';');
+#endif
+	// prepend timestamp
+	MY_DEBUGDEVICE.print(hwMillis());
+	MY_DEBUGDEVICE.print(' ');
+	MY_DEBUGDEVICE.write((const uint8_t *)str, pos);
+	MY_DEBUGDEVICE.flush();
+#else
+	logText(LOG_DEBUG, str);
+#endif
+}
+#endif
 #endif
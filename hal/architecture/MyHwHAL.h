@@ -149,6 +149,15 @@ void hwDebugPrint(const char *fmt, ...);
  * @param sz
  */
 static void hwDebugBuf2Str(const uint8_t *buf, size_t sz) __attribute__((unused));
+#if defined(MY_DEBUG_EVENTS)
+/**
+ * Debug event print, see @ref MyDebugEventsgrp
+ * @param id Event ID
+ * @param args Packed arguments
+ * @param sz Size of arguments
+ */
+void hwDebugEvent(const uint8_t id, const uint8_t *args, const uint8_t sz);
+#endif
 #endif
 
 /**
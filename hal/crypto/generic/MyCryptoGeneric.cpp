@@ -29,17 +29,61 @@ void SHA256HMAC(uint8_t *dest, const uint8_t *key, size_t keyLength, const uint8
 
 AES _aes;
 
+#if defined(AES_HW)
+static int8_t _aes_hw = -1; //!< -1: not probed yet, 0: software AES, 1: AES instructions
+
+// Known answer check (FIPS-197 appendix C.1) before the AES instructions are trusted
+static bool AES128CBCSelfTest(void)
+{
+	static const uint8_t key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	static const uint8_t plain[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+	static const uint8_t cipher[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+	uint8_t iv[16] = { 0 };
+	uint8_t buffer[16];
+	(void)memcpy((void *)buffer, (const void *)plain, sizeof(buffer));
+	AEShwSetKey(key);
+	AEShwCBCEncrypt(iv, buffer, 1);
+	if (memcmp(buffer, cipher, sizeof(buffer))) {
+		return false;
+	}
+	(void)memset((void *)iv, 0, sizeof(iv));
+	AEShwCBCDecrypt(iv, buffer, 1);
+	return !memcmp(buffer, plain, sizeof(buffer));
+}
+#endif
+
 void AES128CBCInit(const uint8_t *key)
 {
+#if defined(AES_HW)
+	if (_aes_hw < 0) {
+		_aes_hw = AEShwSupported() && AES128CBCSelfTest();
+	}
+	if (_aes_hw) {
+		AEShwSetKey(key);
+		return;
+	}
+#endif
 	_aes.set_key((byte *)key, 16);
 }
 
 void AES128CBCEncrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+#if defined(AES_HW)
+	if (_aes_hw > 0) {
+		AEShwCBCEncrypt(iv, buffer, dataLength / 16);
+		return;
+	}
+#endif
 	_aes.cbc_encrypt((byte *)buffer, (byte *)buffer, dataLength / 16, iv);
 }
 
 void AES128CBCDecrypt(uint8_t *iv, uint8_t *buffer, const size_t dataLength)
 {
+#if defined(AES_HW)
+	if (_aes_hw > 0) {
+		AEShwCBCDecrypt(iv, buffer, dataLength / 16);
+		return;
+	}
+#endif
 	_aes.cbc_decrypt((byte *)buffer, (byte *)buffer, dataLength / 16, iv);
 }
@@ -22,6 +22,7 @@
 
 #include "hal/crypto/MyCryptoHAL.h"
 #include "hal/crypto/generic/drivers/AES/AES.cpp"
+#include "hal/crypto/generic/drivers/AES/AES_hw.cpp"
 #include "hal/crypto/generic/drivers/SHA256/sha256.cpp"
 #include "hal/crypto/generic/drivers/HMAC_SHA256/hmac_sha256.cpp"
 
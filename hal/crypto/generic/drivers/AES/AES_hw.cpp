@@ -0,0 +1,213 @@
+/*
+* The MySensors Arduino library handles the wireless radio link and protocol
+* between your home built sensors/actuators and HA controller of choice.
+* The sensors forms a self healing radio network with optional repeaters. Each
+* repeater and gateway builds a routing tables in EEPROM which keeps track of the
+* network topology allowing messages to be routed to nodes.
+*
+* Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+* Copyright (C) 2013-2020 Sensnology AB
+* Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+*
+* Documentation: http://www.mysensors.org
+* Support Forum: http://forum.mysensors.org
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* version 2 as published by the Free Software Foundation.
+*
+*******************************
+*
+* AES-128 CBC using the AES instructions of x86 (AES-NI) and ARMv8 (cryptography extensions).
+* AEShwSupported() tells if the CPU has them, the other functions must not be called otherwise.
+*/
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define AES_HW_AESNI
+#elif defined(__linux__) && defined(MY_LINUX_CRYPTO_ARMV8) && (defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 8))
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#define AES_HW_ARMV8
+#endif
+
+#if defined(AES_HW_AESNI) || defined(AES_HW_ARMV8)
+#define AES_HW
+
+#define AES_HW_ROUNDS 10 //!< AES-128
+
+static uint8_t _aes_hw_enc_key[AES_HW_ROUNDS + 1][16]; //!< Encryption round keys
+static uint8_t _aes_hw_dec_key[AES_HW_ROUNDS + 1][16]; //!< Round keys for the equivalent inverse cipher
+#endif
+
+#if defined(AES_HW_AESNI)
+bool AEShwSupported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+	return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) && (edx & bit_SSE2);
+}
+
+__attribute__((target("aes,sse2"))) static inline __m128i AEShwExpandKey(__m128i key,
+        __m128i assist)
+{
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, assist);
+}
+
+__attribute__((target("aes,sse2"))) void AEShwSetKey(const uint8_t *key)
+{
+	__m128i rk[AES_HW_ROUNDS + 1];
+	rk[0] = _mm_loadu_si128((const __m128i *)key);
+	// The round constant has to be an immediate
+#define AES_HW_EXPAND(i, rcon) rk[i] = AEShwExpandKey(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon))
+	AES_HW_EXPAND(1, 0x01);
+	AES_HW_EXPAND(2, 0x02);
+	AES_HW_EXPAND(3, 0x04);
+	AES_HW_EXPAND(4, 0x08);
+	AES_HW_EXPAND(5, 0x10);
+	AES_HW_EXPAND(6, 0x20);
+	AES_HW_EXPAND(7, 0x40);
+	AES_HW_EXPAND(8, 0x80);
+	AES_HW_EXPAND(9, 0x1B);
+	AES_HW_EXPAND(10, 0x36);
+#undef AES_HW_EXPAND
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		_mm_storeu_si128((__m128i *)_aes_hw_enc_key[i], rk[i]);
+		_mm_storeu_si128((__m128i *)_aes_hw_dec_key[i], (i == 0 || i == AES_HW_ROUNDS) ?
+		                 rk[AES_HW_ROUNDS - i] : _mm_aesimc_si128(rk[AES_HW_ROUNDS - i]));
+	}
+	(void)memset((void *)rk, 0, sizeof(rk));
+}
+
+__attribute__((target("aes,sse2"))) void AEShwCBCEncrypt(uint8_t *iv, uint8_t *buffer,
+        size_t blocks)
+{
+	__m128i rk[AES_HW_ROUNDS + 1];
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		rk[i] = _mm_loadu_si128((const __m128i *)_aes_hw_enc_key[i]);
+	}
+	__m128i x = _mm_loadu_si128((const __m128i *)iv);
+	while (blocks--) {
+		x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buffer), x);
+		x = _mm_xor_si128(x, rk[0]);
+		for (uint8_t i = 1; i < AES_HW_ROUNDS; i++) {
+			x = _mm_aesenc_si128(x, rk[i]);
+		}
+		x = _mm_aesenclast_si128(x, rk[AES_HW_ROUNDS]);
+		_mm_storeu_si128((__m128i *)buffer, x);
+		buffer += 16;
+	}
+	_mm_storeu_si128((__m128i *)iv, x);
+}
+
+__attribute__((target("aes,sse2"))) void AEShwCBCDecrypt(uint8_t *iv, uint8_t *buffer,
+        size_t blocks)
+{
+	__m128i rk[AES_HW_ROUNDS + 1];
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		rk[i] = _mm_loadu_si128((const __m128i *)_aes_hw_dec_key[i]);
+	}
+	__m128i prev = _mm_loadu_si128((const __m128i *)iv);
+	while (blocks--) {
+		const __m128i cipher = _mm_loadu_si128((const __m128i *)buffer);
+		__m128i x = _mm_xor_si128(cipher, rk[0]);
+		for (uint8_t i = 1; i < AES_HW_ROUNDS; i++) {
+			x = _mm_aesdec_si128(x, rk[i]);
+		}
+		x = _mm_aesdeclast_si128(x, rk[AES_HW_ROUNDS]);
+		_mm_storeu_si128((__m128i *)buffer, _mm_xor_si128(x, prev));
+		prev = cipher;
+		buffer += 16;
+	}
+	_mm_storeu_si128((__m128i *)iv, prev);
+}
+#elif defined(AES_HW_ARMV8)
+#if defined(__aarch64__)
+#define AES_HW_TARGET __attribute__((target("+crypto")))
+#else
+#define AES_HW_TARGET __attribute__((target("fpu=crypto-neon-fp-armv8")))
+#endif
+
+bool AEShwSupported(void)
+{
+#if defined(__aarch64__)
+	return getauxval(AT_HWCAP) & (1 << 3); // HWCAP_AES
+#else
+	return getauxval(AT_HWCAP2) & (1 << 0); // HWCAP2_AES
+#endif
+}
+
+// SubWord() of the key schedule. With the word in all four columns ShiftRows is a no-op, so
+// AESE with a zero key leaves just SubBytes
+AES_HW_TARGET static inline uint32_t AEShwSubWord(const uint32_t w)
+{
+	const uint8x16_t x = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(w)), vdupq_n_u8(0));
+	return vgetq_lane_u32(vreinterpretq_u32_u8(x), 0);
+}
+
+AES_HW_TARGET void AEShwSetKey(const uint8_t *key)
+{
+	static const uint8_t rcon[AES_HW_ROUNDS] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36 };
+	uint32_t w[4 * (AES_HW_ROUNDS + 1)];
+	(void)memcpy((void *)w, (const void *)key, 16);
+	for (uint8_t i = 4; i < 4 * (AES_HW_ROUNDS + 1); i++) {
+		uint32_t t = w[i - 1];
+		if (!(i & 3)) {
+			// Words are little endian, so RotWord() is a right rotation
+			t = AEShwSubWord(t);
+			t = ((t >> 8) | (t << 24)) ^ rcon[i / 4 - 1];
+		}
+		w[i] = w[i - 4] ^ t;
+	}
+	(void)memcpy((void *)_aes_hw_enc_key, (const void *)w, sizeof(_aes_hw_enc_key));
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		const uint8x16_t rk = vld1q_u8(_aes_hw_enc_key[AES_HW_ROUNDS - i]);
+		vst1q_u8(_aes_hw_dec_key[i], (i == 0 || i == AES_HW_ROUNDS) ? rk : vaesimcq_u8(rk));
+	}
+	(void)memset((void *)w, 0, sizeof(w));
+}
+
+AES_HW_TARGET void AEShwCBCEncrypt(uint8_t *iv, uint8_t *buffer, size_t blocks)
+{
+	uint8x16_t rk[AES_HW_ROUNDS + 1];
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		rk[i] = vld1q_u8(_aes_hw_enc_key[i]);
+	}
+	uint8x16_t x = vld1q_u8(iv);
+	while (blocks--) {
+		x = veorq_u8(vld1q_u8(buffer), x);
+		for (uint8_t i = 0; i < AES_HW_ROUNDS - 1; i++) {
+			x = vaesmcq_u8(vaeseq_u8(x, rk[i]));
+		}
+		x = veorq_u8(vaeseq_u8(x, rk[AES_HW_ROUNDS - 1]), rk[AES_HW_ROUNDS]);
+		vst1q_u8(buffer, x);
+		buffer += 16;
+	}
+	vst1q_u8(iv, x);
+}
+
+AES_HW_TARGET void AEShwCBCDecrypt(uint8_t *iv, uint8_t *buffer, size_t blocks)
+{
+	uint8x16_t rk[AES_HW_ROUNDS + 1];
+	for (uint8_t i = 0; i <= AES_HW_ROUNDS; i++) {
+		rk[i] = vld1q_u8(_aes_hw_dec_key[i]);
+	}
+	uint8x16_t prev = vld1q_u8(iv);
+	while (blocks--) {
+		const uint8x16_t cipher = vld1q_u8(buffer);
+		uint8x16_t x = cipher;
+		for (uint8_t i = 0; i < AES_HW_ROUNDS - 1; i++) {
+			x = vaesimcq_u8(vaesdq_u8(x, rk[i]));
+		}
+		x = veorq_u8(vaesdq_u8(x, rk[AES_HW_ROUNDS - 1]), rk[AES_HW_ROUNDS]);
+		vst1q_u8(buffer, veorq_u8(x, prev));
+		prev = cipher;
+		buffer += 16;
+	}
+	vst1q_u8(iv, prev);
+}
+#endif
@@ -33,10 +33,12 @@ void SHA256HMACInit(const uint8_t *key, size_t keyLength)
 		(void)memcpy((void *)SHA256keyBuffer, (const void *)key, keyLength);
 	}
 	// Start inner hash
-	SHA256Init();
+	uint8_t pad[BLOCK_LENGTH];
 	for (uint8_t i = 0; i < BLOCK_LENGTH; i++) {
-		SHA256Add(SHA256keyBuffer[i] ^ HMAC_IPAD);
+		pad[i] = SHA256keyBuffer[i] ^ HMAC_IPAD;
 	}
+	SHA256Init();
+	SHA256Add(pad, BLOCK_LENGTH);
 }
 
 void SHA256HMACAdd(const uint8_t data)
@@ -55,10 +57,12 @@ void SHA256HMACResult(uint8_t *dest)
 	// Complete inner hash
 	SHA256Result(innerHash);
 	// Calculate outer hash
-	SHA256Init();
+	uint8_t pad[BLOCK_LENGTH];
 	for (uint8_t i = 0; i < BLOCK_LENGTH; i++) {
-		SHA256Add(SHA256keyBuffer[i] ^ HMAC_OPAD);
+		pad[i] = SHA256keyBuffer[i] ^ HMAC_OPAD;
 	}
+	SHA256Init();
+	SHA256Add(pad, BLOCK_LENGTH);
 	SHA256Add(innerHash, HASH_LENGTH);
 	SHA256Result(dest);
 }
\ No newline at end of file
@@ -20,6 +20,16 @@
 
 #include "sha256.h"
 
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HW_SHANI
+#elif defined(__linux__) && defined(MY_LINUX_CRYPTO_ARMV8) && (defined(__aarch64__) || (defined(__ARM_ARCH) && __ARM_ARCH >= 8))
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#define SHA256_HW_ARMV8
+#endif
+
 const uint32_t SHA256K[] PROGMEM = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
 	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
@@ -60,7 +70,7 @@ uint32_t SHA256ror32(const uint32_t number, const uint8_t bits)
 	return ((number << (32 - bits)) | (number >> bits));
 }
 
-void SHA256hashBlock(void)
+void SHA256hashBlockGeneric(void)
 {
 	uint32_t a, b, c, d, e, f, g, h, t1, t2;
 
@@ -108,6 +118,140 @@ void SHA256hashBlock(void)
 	SHA256state.w[7] += h;
 }
 
+#if defined(SHA256_HW_SHANI)
+// One block using the x86 SHA extensions. The message words in SHA256buffer are already in host
+// order, so they are loaded without the byte shuffle the usual SHA-NI code needs
+__attribute__((target("sha,sse4.1"))) void SHA256hashBlockShaNi(void)
+{
+	__m128i state0, state1, tmp, msg;
+	__m128i w[4];
+
+	// The instructions expect the state as ABEF and CDGH
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&SHA256state.w[0]), 0xB1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&SHA256state.w[4]), 0x1B);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+	const __m128i abef = state0;
+	const __m128i cdgh = state1;
+
+	for (uint8_t i = 0; i < 4; i++) {
+		w[i] = _mm_loadu_si128((const __m128i *)&SHA256buffer.w[i * 4]);
+	}
+	for (uint8_t i = 0; i < 16; i++) {
+		if (i >= 4) {
+			// W[i] = msg2(msg1(W[i-4], W[i-3]) + W[i-7], W[i-1]), four words at a time
+			tmp = _mm_alignr_epi8(w[(i - 1) & 3], w[(i - 2) & 3], 4);
+			w[i & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i - 3) & 3]),
+			                                tmp), w[(i - 1) & 3]);
+		}
+		msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128((const __m128i *)&SHA256K[i * 4]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+	}
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+
+	// Back to ABCD and EFGH
+	tmp = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+	_mm_storeu_si128((__m128i *)&SHA256state.w[0], _mm_blend_epi16(tmp, state1, 0xF0));
+	_mm_storeu_si128((__m128i *)&SHA256state.w[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+bool SHA256hwSupported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) {
+		return false;
+	}
+	return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA);
+}
+#define SHA256hashBlockHw SHA256hashBlockShaNi
+#elif defined(SHA256_HW_ARMV8)
+// One block using the ARMv8 cryptography extensions
+#if defined(__aarch64__)
+__attribute__((target("+crypto")))
+#else
+__attribute__((target("fpu=crypto-neon-fp-armv8")))
+#endif
+void SHA256hashBlockArmv8(void)
+{
+	uint32x4_t state0 = vld1q_u32(&SHA256state.w[0]);
+	uint32x4_t state1 = vld1q_u32(&SHA256state.w[4]);
+	const uint32x4_t abcd = state0;
+	const uint32x4_t efgh = state1;
+	uint32x4_t w[4];
+
+	for (uint8_t i = 0; i < 4; i++) {
+		w[i] = vld1q_u32(&SHA256buffer.w[i * 4]);
+	}
+	for (uint8_t i = 0; i < 16; i++) {
+		const uint32x4_t msg = vaddq_u32(w[i & 3], vld1q_u32(&SHA256K[i * 4]));
+		if (i < 12) {
+			// W[i+4] from W[i], W[i+1], W[i+2] and W[i+3], four words at a time
+			w[i & 3] = vsha256su1q_u32(vsha256su0q_u32(w[i & 3], w[(i + 1) & 3]), w[(i + 2) & 3],
+			                           w[(i + 3) & 3]);
+		}
+		const uint32x4_t tmp = state0;
+		state0 = vsha256hq_u32(state0, state1, msg);
+		state1 = vsha256h2q_u32(state1, tmp, msg);
+	}
+	vst1q_u32(&SHA256state.w[0], vaddq_u32(state0, abcd));
+	vst1q_u32(&SHA256state.w[4], vaddq_u32(state1, efgh));
+}
+
+bool SHA256hwSupported(void)
+{
+#if defined(__aarch64__)
+	return getauxval(AT_HWCAP) & (1 << 6); // HWCAP_SHA2
+#else
+	return getauxval(AT_HWCAP2) & (1 << 3); // HWCAP2_SHA2
+#endif
+}
+#define SHA256hashBlockHw SHA256hashBlockArmv8
+#endif
+
+#if defined(SHA256hashBlockHw)
+void SHA256hashBlockDetect(void);
+void (*SHA256hashBlockImpl)(void) = SHA256hashBlockDetect; //!< Selected on the first block
+
+// Known answer check of one block, SHA-256("abc") (FIPS 180-2 appendix B.1), before the
+// accelerated implementation is trusted
+static bool SHA256hwSelfTest(void)
+{
+	static const uint32_t digest[8] = { 0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223, 0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad };
+	const _SHA256state_t state = SHA256state;
+	const _SHA256buffer_t buffer = SHA256buffer;
+	(void)memcpy_P((void *)&SHA256state.b, (const void *)&SHA256InitState, 32);
+	(void)memset((void *)&SHA256buffer, 0, sizeof(SHA256buffer));
+	SHA256buffer.w[0] = 0x61626380;
+	SHA256buffer.w[15] = 24;
+	SHA256hashBlockHw();
+	const bool passed = !memcmp(SHA256state.w, digest, sizeof(digest));
+	SHA256state = state;
+	SHA256buffer = buffer;
+	return passed;
+}
+
+// Picks the accelerated implementation if the CPU has it and hashes the pending block
+void SHA256hashBlockDetect(void)
+{
+	SHA256hashBlockImpl = SHA256hwSupported() &&
+	                      SHA256hwSelfTest() ? SHA256hashBlockHw : SHA256hashBlockGeneric;
+	SHA256hashBlockImpl();
+}
+
+void SHA256hashBlock(void)
+{
+	SHA256hashBlockImpl();
+}
+#else
+void SHA256hashBlock(void)
+{
+	SHA256hashBlockGeneric();
+}
+#endif
+
 void SHA256addUncounted(const uint8_t data)
 {
 	SHA256buffer.b[SHA256bufferOffset ^ 3] = data;
@@ -127,6 +271,21 @@ void SHA256Add(const uint8_t data)
 
 void SHA256Add(const uint8_t *data, size_t dataLength)
 {
+	while (dataLength && SHA256bufferOffset) {
+		SHA256Add(*data++);
+		dataLength--;
+	}
+	// Whole blocks are loaded a word at a time instead of going through the byte buffer
+	while (dataLength >= BLOCK_LENGTH) {
+		for (uint8_t i = 0; i < BLOCK_LENGTH / 4; i++) {
+			SHA256buffer.w[i] = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+			                    ((uint32_t)data[2] << 8) | data[3];
+			data += 4;
+		}
+		SHA256hashBlock();
+		SHA256byteCount += BLOCK_LENGTH;
+		dataLength -= BLOCK_LENGTH;
+	}
 	while (dataLength--) {
 		SHA256Add(*data++);
 	}
@@ -0,0 +1,191 @@
+/*
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2020 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ * In-memory transport: another thread plays the radio network, it injects the frames the
+ * node receives and is handed the frames the node sends. No radio hardware is needed, the
+ * transport is meant for benchmarks and tests of the core.
+ */
+
+#include "hal/architecture/Linux/drivers/core/SPSCRingBuffer.h"
+
+/**
+ * @brief Handler for frames sent by the node, called from the main loop
+ * @param to Recipient
+ * @param data Frame
+ * @param len Frame length
+ * @return True if the frame was acknowledged
+ */
+typedef bool (*transportLoopbackSendHandler_t)(const uint8_t to, const void *data,
+        const uint8_t len);
+
+typedef struct {
+	uint8_t m_len;                      // Length of the data
+	uint8_t m_data[MAX_MESSAGE_SIZE];   // The raw data
+} transportLoopbackFrame;
+
+static transportLoopbackFrame _transportLoopbackStorage[MY_LOOPBACK_QUEUE_SIZE];
+// Filled by the simulating thread and drained by the main loop only, no locking needed
+static SPSCRingBuffer<transportLoopbackFrame> _transportLoopbackQueue(_transportLoopbackStorage,
+        MY_LOOPBACK_QUEUE_SIZE);
+static transportLoopbackSendHandler_t _transportLoopbackSendHandler = NULL;
+static uint8_t _transportLoopbackAddress = AUTO;
+
+/**
+ * @brief Queue a frame for the node and wake up its main loop. Must always be called from the
+ * same thread.
+ * @param data Frame, i.e. a raw MyMessage
+ * @param len Frame length
+ * @return False if the queue is full, the frame is lost
+ */
+bool transportLoopbackInject(const void *data, const uint8_t len)
+{
+	transportLoopbackFrame *frame = _transportLoopbackQueue.getFront();
+	if (!frame) {
+		return false;
+	}
+	frame->m_len = min(len, (uint8_t)MAX_MESSAGE_SIZE);
+	(void)memcpy((void *)frame->m_data, data, frame->m_len);
+	(void)_transportLoopbackQueue.pushFront(frame);
+	eventLoopNotify();
+	return true;
+}
+
+/**
+ * @brief Set the handler for frames sent by the node, without handler every frame is
+ * acknowledged and discarded
+ * @param handler Handler
+ */
+void transportLoopbackSetSendHandler(const transportLoopbackSendHandler_t handler)
+{
+	_transportLoopbackSendHandler = handler;
+}
+
+bool transportInit(void)
+{
+	return true;
+}
+
+void transportSetAddress(const uint8_t address)
+{
+	_transportLoopbackAddress = address;
+}
+
+uint8_t transportGetAddress(void)
+{
+	return _transportLoopbackAddress;
+}
+
+bool transportSend(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	(void)noACK;
+	if (!_transportLoopbackSendHandler) {
+		return true;
+	}
+	return _transportLoopbackSendHandler(to, data, len);
+}
+
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	// the handler is called once anyway
+	return transportSend(to, data, len, noACK);
+}
+
+bool transportDataAvailable(void)
+{
+	return !_transportLoopbackQueue.empty();
+}
+
+bool transportSanityCheck(void)
+{
+	return true;
+}
+
+uint8_t transportReceive(void *data)
+{
+	uint8_t len = 0;
+	transportLoopbackFrame *frame = _transportLoopbackQueue.getBack();
+	if (frame) {
+		len = frame->m_len;
+		(void)memcpy(data, frame->m_data, len);
+		(void)_transportLoopbackQueue.popBack();
+	}
+	return len;
+}
+
+void transportPowerDown(void)
+{
+	// Nothing to shut down here
+}
+
+void transportPowerUp(void)
+{
+	// not implemented
+}
+
+void transportSleep(void)
+{
+	// not implemented
+}
+
+void transportStandBy(void)
+{
+	// not implemented
+}
+
+int16_t transportGetSendingRSSI(void)
+{
+	// not implemented
+	return INVALID_RSSI;
+}
+
+int16_t transportGetReceivingRSSI(void)
+{
+	// not implemented
+	return INVALID_RSSI;
+}
+
+int16_t transportGetSendingSNR(void)
+{
+	// not implemented
+	return INVALID_SNR;
+}
+
+int16_t transportGetReceivingSNR(void)
+{
+	// not implemented
+	return INVALID_SNR;
+}
+
+int16_t transportGetTxPowerPercent(void)
+{
+	// not implemented
+	return static_cast<int16_t>(100);
+}
+
+int16_t transportGetTxPowerLevel(void)
+{
+	// not implemented
+	return static_cast<int16_t>(100);
+}
+
+bool transportSetTxPowerPercent(const uint8_t powerPercent)
+{
+	// not possible
+	(void)powerPercent;
+	return false;
+}
@@ -26,6 +26,216 @@
 #define TRANSPORT_HAL_DEBUG(x,...)	//!< debug NULL
 #endif
 
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+// With several radios the functions below are the backend Multi: it dispatches to the registered
+// backends, the HAL functions call it like a single driver
+#define MY_TRANSPORT_BACKEND Multi
+
+#if defined(MY_RADIO_RF24)
+static const transportBackend_t _transportHALRF24 = TRANSPORT_HAL_BACKEND(RF24);
+#endif
+#if defined(MY_RADIO_RFM69)
+static const transportBackend_t _transportHALRFM69 = TRANSPORT_HAL_BACKEND(RFM69);
+#endif
+#if defined(MY_RADIO_RFM95)
+static const transportBackend_t _transportHALRFM95 = TRANSPORT_HAL_BACKEND(RFM95);
+#endif
+#if defined(MY_RS485)
+static const transportBackend_t _transportHALRS485 = TRANSPORT_HAL_BACKEND(RS485);
+#endif
+#if defined(MY_RADIO_LOOPBACK)
+static const transportBackend_t _transportHALLoopback = TRANSPORT_HAL_BACKEND(Loopback);
+#endif
+
+static const transportBackend_t *_transportHALBackends[TRANSPORT_HAL_MAX_BACKENDS] = {
+#if defined(MY_RADIO_RF24)
+	&_transportHALRF24,
+#endif
+#if defined(MY_RADIO_RFM69)
+	&_transportHALRFM69,
+#endif
+#if defined(MY_RADIO_RFM95)
+	&_transportHALRFM95,
+#endif
+#if defined(MY_RS485)
+	&_transportHALRS485,
+#endif
+#if defined(MY_RADIO_LOOPBACK)
+	&_transportHALLoopback,
+#endif
+};
+static uint8_t _transportHALBackendCount = __RF24CNT + __RFM69CNT + __RFM95CNT + __RS485CNT +
+        __LOOPBACKCNT;
+static uint8_t _transportHALRxBackend = 0;	// Backend of the last received message
+static uint8_t _transportHALTxBackend = 0;	// Backend of the last sent message
+
+bool transportHALRegisterBackend(const transportBackend_t *backend)
+{
+	if (_transportHALBackendCount >= TRANSPORT_HAL_MAX_BACKENDS) {
+		return false;
+	}
+	_transportHALBackends[_transportHALBackendCount++] = backend;
+	return true;
+}
+
+uint8_t transportHALGetReceivingRadio(void)
+{
+	return _transportHALRxBackend;
+}
+
+bool transportInit(void)
+{
+	bool result = true;
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		if (!_transportHALBackends[i]->init()) {
+			TRANSPORT_HAL_DEBUG(PSTR("!THA:INIT:RADIO=%s\n"), _transportHALBackends[i]->name);
+			result = false;
+		}
+	}
+	return result;
+}
+
+void transportSetAddress(const uint8_t address)
+{
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		_transportHALBackends[i]->setAddress(address);
+	}
+}
+
+uint8_t transportGetAddress(void)
+{
+	return _transportHALBackends[0]->getAddress();
+}
+
+static bool transportSendBackend(const uint8_t to, const void *data, const uint8_t len,
+                                 const bool noACK, const bool once)
+{
+	const uint8_t radio = (to == BROADCAST_ADDRESS) ? TRANSPORT_HAL_ALL_BACKENDS : transportGetRadio(to);
+	if (radio < _transportHALBackendCount) {
+		_transportHALTxBackend = radio;
+		return once ? _transportHALBackends[radio]->sendOnce(to, data, len, noACK) :
+		       _transportHALBackends[radio]->send(to, data, len, noACK);
+	}
+	// broadcast or a node not heard from yet, try every radio
+	bool result = false;
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		const bool sent = once ? _transportHALBackends[i]->sendOnce(to, data, len, noACK) :
+		                  _transportHALBackends[i]->send(to, data, len, noACK);
+		TRANSPORT_HAL_DEBUG(PSTR("THA:SND:RADIO=%s,RES=%" PRIu8 "\n"), _transportHALBackends[i]->name,
+		                    sent);
+		if (sent) {
+			_transportHALTxBackend = i;
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool transportSend(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return transportSendBackend(to, data, len, noACK, false);
+}
+
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return transportSendBackend(to, data, len, noACK, true);
+}
+
+bool transportDataAvailable(void)
+{
+	// start after the backend served last, a busy radio cannot starve the others
+	for (uint8_t i = 1; i <= _transportHALBackendCount; i++) {
+		const uint8_t backend = (_transportHALRxBackend + i) % _transportHALBackendCount;
+		if (_transportHALBackends[backend]->dataAvailable()) {
+			_transportHALRxBackend = backend;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool transportSanityCheck(void)
+{
+	bool result = true;
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		result = _transportHALBackends[i]->sanityCheck() && result;
+	}
+	return result;
+}
+
+uint8_t transportReceive(void *data)
+{
+	return _transportHALBackends[_transportHALRxBackend]->receive(data);
+}
+
+void transportPowerDown(void)
+{
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		_transportHALBackends[i]->powerDown();
+	}
+}
+
+void transportPowerUp(void)
+{
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		_transportHALBackends[i]->powerUp();
+	}
+}
+
+void transportSleep(void)
+{
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		_transportHALBackends[i]->sleep();
+	}
+}
+
+void transportStandBy(void)
+{
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		_transportHALBackends[i]->standBy();
+	}
+}
+
+int16_t transportGetSendingRSSI(void)
+{
+	return _transportHALBackends[_transportHALTxBackend]->getSendingRSSI();
+}
+
+int16_t transportGetReceivingRSSI(void)
+{
+	return _transportHALBackends[_transportHALRxBackend]->getReceivingRSSI();
+}
+
+int16_t transportGetSendingSNR(void)
+{
+	return _transportHALBackends[_transportHALTxBackend]->getSendingSNR();
+}
+
+int16_t transportGetReceivingSNR(void)
+{
+	return _transportHALBackends[_transportHALRxBackend]->getReceivingSNR();
+}
+
+int16_t transportGetTxPowerPercent(void)
+{
+	return _transportHALBackends[_transportHALTxBackend]->getTxPowerPercent();
+}
+
+int16_t transportGetTxPowerLevel(void)
+{
+	return _transportHALBackends[_transportHALTxBackend]->getTxPowerLevel();
+}
+
+bool transportSetTxPowerPercent(const uint8_t powerPercent)
+{
+	bool result = true;
+	for (uint8_t i = 0; i < _transportHALBackendCount; i++) {
+		result = _transportHALBackends[i]->setTxPowerPercent(powerPercent) && result;
+	}
+	return result;
+}
+#endif
+
 bool transportHALInit(void)
 {
 	TRANSPORT_HAL_DEBUG(PSTR("THA:INIT\n"));
@@ -136,8 +346,8 @@ bool transportHALReceive(MyMessage *inMsg, uint8_t *msgLength)
 	return true;
 }
 
-bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
-                      const bool noACK)
+static bool transportHALSendMessage(const uint8_t nextRecipient, const MyMessage *outMsg,
+                                   const uint8_t len, const bool noACK, const bool once)
 {
 	if (outMsg == NULL) {
 
@@ -173,11 +383,24 @@ bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, cons
 	const uint8_t finalLength = len;
 #endif
 
-	bool result = transportSend(nextRecipient, (void *)tx_data, finalLength, noACK);
+	bool result = once ? transportSendOnce(nextRecipient, (void *)tx_data, finalLength, noACK) :
+	              transportSend(nextRecipient, (void *)tx_data, finalLength, noACK);
 	TRANSPORT_HAL_DEBUG(PSTR("THA:SND:MSG LEN=%" PRIu8 ",RES=%" PRIu8 "\n"), finalLength, result);
 	return result;
 }
 
+bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
+                      const bool noACK)
+{
+	return transportHALSendMessage(nextRecipient, outMsg, len, noACK, false);
+}
+
+bool transportHALSendOnce(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
+                          const bool noACK)
+{
+	return transportHALSendMessage(nextRecipient, outMsg, len, noACK, true);
+}
+
 void transportHALPowerDown(void)
 {
 	transportPowerDown();
@@ -239,3 +462,7 @@ int16_t transportHALGetTxPowerLevel(void)
 	int16_t result = transportGetTxPowerLevel();
 	return result;
 }
+
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+#undef MY_TRANSPORT_BACKEND
+#endif
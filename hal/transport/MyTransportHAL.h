@@ -36,6 +36,8 @@
  * | | THA | SND   | ENCRYPT										| Encrypt message to send (%AES)
  * | | THA | SND   | CIP=%%s										| Ciphertext of encypted message (CIP)
  * | | THA | SND   | MSG LEN=%%d,RES=%%d				| Sending message with length (LEN), result (RES)
+ * | | THA | SND   | RADIO=%%s,RES=%%d						| Message sent on radio (RADIO), result (RES)
+ * |!| THA | INIT  | RADIO=%%s									| Initialization of radio (RADIO) failed
  *
  *
  */
@@ -48,7 +50,25 @@
 #define INVALID_PERCENT     ((int16_t)-100)	//!< INVALID_PERCENT
 #define INVALID_LEVEL       ((int16_t)-256)	//!< INVALID_LEVEL
 
-#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#ifdef DOXYGEN
+/**
+ * @def MY_TRANSPORT_MULTI_RADIO
+ * @brief Automatically set on Linux if more than one transport is enabled
+ *
+ * Every enabled driver becomes a backend of the transport HAL, see @ref transportBackend_t. The
+ * radio each neighbour is reached on is learned from its messages, messages to unknown nodes and
+ * broadcasts are sent on all radios. SPI radios need different chip select pins.
+ */
+#define MY_TRANSPORT_MULTI_RADIO
+#elif defined(__linux__) && (defined(MY_RADIO_RF24) + defined(MY_RADIO_RFM69) + defined(MY_RADIO_RFM95) + defined(MY_RS485) + defined(MY_RADIO_LOOPBACK) > 1)
+#define MY_TRANSPORT_MULTI_RADIO
+#endif
+
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE) && defined(MY_TRANSPORT_MULTI_RADIO)
+#if !defined(MY_RADIO_RF24)
+#error Receive message buffering requires the RF24 radio!
+#endif
+#elif defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 #if defined(MY_RADIO_NRF5_ESB)
 #error Receive message buffering not supported for NRF5 radio! Please define MY_NRF5_RX_BUFFER_SIZE
 #endif
@@ -61,6 +81,9 @@
 #if defined(MY_RS485)
 #error Receive message buffering not supported for RS485!
 #endif
+#if defined(MY_RADIO_LOOPBACK)
+#error Receive message buffering not supported for the loopback transport!
+#endif
 #elif defined(MY_RX_MESSAGE_BUFFER_SIZE)
 #error Receive message buffering requires message buffering feature enabled!
 #endif
@@ -79,6 +102,93 @@ typedef enum {
 	SR_NOT_DEFINED         //!< SR_NOT_DEFINED
 } signalReport_t;
 
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+#define TRANSPORT_HAL_MAX_BACKENDS	(8u)		//!< Maximum number of registered backends
+#define TRANSPORT_HAL_ALL_BACKENDS	(0xFFu)		//!< Radio of a node not known, use all backends
+
+// Each driver is compiled with its transport* functions renamed to transport<MY_TRANSPORT_BACKEND>*
+#define _TRANSPORT_HAL_PASTE(prefix, backend, function) prefix##backend##function	//!< Paste name
+#define _TRANSPORT_HAL_NAME(backend, function) _TRANSPORT_HAL_PASTE(transport, backend, function)	//!< Name in backend
+#define transportInit _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, Init)	//!< transportInit
+#define transportSetAddress _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SetAddress)	//!< transportSetAddress
+#define transportGetAddress _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetAddress)	//!< transportGetAddress
+#define transportSend _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, Send)	//!< transportSend
+#define transportSendOnce _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SendOnce)	//!< transportSendOnce
+#define transportDataAvailable _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, DataAvailable)	//!< transportDataAvailable
+#define transportSanityCheck _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SanityCheck)	//!< transportSanityCheck
+#define transportReceive _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, Receive)	//!< transportReceive
+#define transportPowerDown _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, PowerDown)	//!< transportPowerDown
+#define transportPowerUp _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, PowerUp)	//!< transportPowerUp
+#define transportSleep _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, Sleep)	//!< transportSleep
+#define transportStandBy _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, StandBy)	//!< transportStandBy
+#define transportGetSendingRSSI _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetSendingRSSI)	//!< transportGetSendingRSSI
+#define transportGetReceivingRSSI _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetReceivingRSSI)	//!< transportGetReceivingRSSI
+#define transportGetSendingSNR _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetSendingSNR)	//!< transportGetSendingSNR
+#define transportGetReceivingSNR _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetReceivingSNR)	//!< transportGetReceivingSNR
+#define transportGetTxPowerPercent _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetTxPowerPercent)	//!< transportGetTxPowerPercent
+#define transportGetTxPowerLevel _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, GetTxPowerLevel)	//!< transportGetTxPowerLevel
+#define transportSetTxPowerPercent _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SetTxPowerPercent)	//!< transportSetTxPowerPercent
+#define transportSetTxPowerLevel _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SetTxPowerLevel)	//!< transportSetTxPowerLevel
+#define transportEncrypt _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, Encrypt)	//!< transportEncrypt
+#define transportSetTargetRSSI _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, SetTargetRSSI)	//!< transportSetTargetRSSI
+#define transportToggleATCmode _TRANSPORT_HAL_NAME(MY_TRANSPORT_BACKEND, ToggleATCmode)	//!< transportToggleATCmode
+
+/**
+* @brief Transport backend, the transport functions of one driver
+*/
+typedef struct {
+	const char *name;	//!< Name, for debug messages
+	bool (*init)(void);	//!< transportInit
+	void (*setAddress)(const uint8_t address);	//!< transportSetAddress
+	uint8_t (*getAddress)(void);	//!< transportGetAddress
+	bool (*send)(const uint8_t to, const void *data, const uint8_t len,
+	             const bool noACK);	//!< transportSend
+	bool (*sendOnce)(const uint8_t to, const void *data, const uint8_t len,
+	                 const bool noACK);	//!< transportSendOnce
+	bool (*dataAvailable)(void);	//!< transportDataAvailable
+	bool (*sanityCheck)(void);	//!< transportSanityCheck
+	uint8_t (*receive)(void *data);	//!< transportReceive
+	void (*powerDown)(void);	//!< transportPowerDown
+	void (*powerUp)(void);	//!< transportPowerUp
+	void (*sleep)(void);	//!< transportSleep
+	void (*standBy)(void);	//!< transportStandBy
+	int16_t (*getSendingRSSI)(void);	//!< transportGetSendingRSSI
+	int16_t (*getReceivingRSSI)(void);	//!< transportGetReceivingRSSI
+	int16_t (*getSendingSNR)(void);	//!< transportGetSendingSNR
+	int16_t (*getReceivingSNR)(void);	//!< transportGetReceivingSNR
+	int16_t (*getTxPowerPercent)(void);	//!< transportGetTxPowerPercent
+	int16_t (*getTxPowerLevel)(void);	//!< transportGetTxPowerLevel
+	bool (*setTxPowerPercent)(const uint8_t powerPercent);	//!< transportSetTxPowerPercent
+} transportBackend_t;
+
+/**
+* @brief Backend of a driver compiled with MY_TRANSPORT_BACKEND set to backend
+*/
+#define TRANSPORT_HAL_BACKEND(backend) { #backend, \
+		_TRANSPORT_HAL_NAME(backend, Init), _TRANSPORT_HAL_NAME(backend, SetAddress), \
+		_TRANSPORT_HAL_NAME(backend, GetAddress), _TRANSPORT_HAL_NAME(backend, Send), \
+		_TRANSPORT_HAL_NAME(backend, SendOnce), \
+		_TRANSPORT_HAL_NAME(backend, DataAvailable), _TRANSPORT_HAL_NAME(backend, SanityCheck), \
+		_TRANSPORT_HAL_NAME(backend, Receive), _TRANSPORT_HAL_NAME(backend, PowerDown), \
+		_TRANSPORT_HAL_NAME(backend, PowerUp), _TRANSPORT_HAL_NAME(backend, Sleep), \
+		_TRANSPORT_HAL_NAME(backend, StandBy), _TRANSPORT_HAL_NAME(backend, GetSendingRSSI), \
+		_TRANSPORT_HAL_NAME(backend, GetReceivingRSSI), _TRANSPORT_HAL_NAME(backend, GetSendingSNR), \
+		_TRANSPORT_HAL_NAME(backend, GetReceivingSNR), _TRANSPORT_HAL_NAME(backend, GetTxPowerPercent), \
+		_TRANSPORT_HAL_NAME(backend, GetTxPowerLevel), _TRANSPORT_HAL_NAME(backend, SetTxPowerPercent) }
+
+/**
+* @brief Register an additional backend, must be called before the transport is initialized.
+* The enabled drivers are registered already.
+* @param backend Backend, must stay valid
+* @return False if too many backends are registered
+*/
+bool transportHALRegisterBackend(const transportBackend_t *backend);
+/**
+* @brief Radio of the last received message
+* @return Index of the backend
+*/
+uint8_t transportHALGetReceivingRadio(void);
+#endif
 
 /**
 * @brief Initialize transport HW
@@ -104,6 +214,19 @@ uint8_t transportHALGetAddress(void);
 bool transportHALSend(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
                       const bool noACK);
 /**
+* @brief Send message with a single transmission, without the retries of the driver
+*
+* An unacknowledged message is not sent again, the caller retries later. Used by the TX queue,
+* see @ref MY_TRANSPORT_TX_QUEUE_FEATURE.
+* @param nextRecipient recipient
+* @param outMsg message to be sent
+* @param len length of message (header + payload)
+* @param noACK do not wait for ACK
+* @return true if message sent successfully
+*/
+bool transportHALSendOnce(const uint8_t nextRecipient, const MyMessage *outMsg, const uint8_t len,
+                          const bool noACK);
+/**
 * @brief Verify if RX FIFO has pending messages
 * @return true if message available in RX FIFO
 */
@@ -45,6 +45,11 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return NRF5_ESB_sendMessage(to, data, len, noACK);
 }
 
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return NRF5_ESB_sendMessage(to, data, len, noACK, true);
+}
+
 bool transportDataAvailable(void)
 {
 	return NRF5_ESB_isDataAvailable();
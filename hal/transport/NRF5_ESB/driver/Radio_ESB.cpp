@@ -413,7 +413,8 @@ void NRF5_ESB_endtx()
 #endif
 }
 
-static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len, const bool noACK)
+static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len, const bool noACK,
+                                 const bool single)
 {
 	NRF5_RADIO_DEBUG(PSTR("NRF5:SND:TO=%" PRIu8 ",LEN=%" PRIu8 ",PID=%" PRIu8 ",NOACK=%" PRIu8 "\n"),
 	                 recipient, len, tx_buffer.pid,
@@ -445,7 +446,7 @@ static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len
 	if (recipient == BROADCAST_ADDRESS) {
 		tx_retries = NRF5_ESB_BC_ARC;
 	} else {
-		tx_retries = ((noACK == false)?(NRF5_ESB_ARC_ACK):(NRF5_ESB_ARC_NOACK));
+		tx_retries = ((noACK == false)?(single ? 1 : NRF5_ESB_ARC_ACK):(NRF5_ESB_ARC_NOACK));
 	}
 	int8_t tx_retries_start = tx_retries;
 	ack_received = false;
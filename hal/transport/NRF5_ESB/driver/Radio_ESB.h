@@ -132,7 +132,8 @@ static void NRF5_ESB_startListening();
 static bool NRF5_ESB_isDataAvailable();
 static uint8_t NRF5_ESB_readMessage(void *data);
 
-static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len, const bool noACK);
+static bool NRF5_ESB_sendMessage(uint8_t recipient, const void *buf, uint8_t len, const bool noACK,
+                                 const bool single = false);
 
 static int16_t NRF5_ESB_getSendingRSSI();
 static int16_t NRF5_ESB_getReceivingRSSI();
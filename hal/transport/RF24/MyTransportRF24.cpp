@@ -20,7 +20,11 @@
 #include "hal/transport/RF24/driver/RF24.h"
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#if defined(__linux__)
+#include "hal/architecture/Linux/drivers/core/SPSCRingBuffer.h"
+#else
 #include "drivers/CircularBuffer/CircularBuffer.h"
+#endif
 
 typedef struct _transportQueuedMessage {
 	uint8_t m_len;                        // Length of the data
@@ -30,8 +34,14 @@ typedef struct _transportQueuedMessage {
 /** Buffer to store queued messages in. */
 static transportQueuedMessage transportRxQueueStorage[MY_RX_MESSAGE_BUFFER_SIZE];
 /** Circular buffer, which uses the transportRxQueueStorage and administers stored messages. */
+#if defined(__linux__)
+// Filled by the interrupt thread and drained by the main loop only, no locking needed
+static SPSCRingBuffer<transportQueuedMessage> transportRxQueue(transportRxQueueStorage,
+        MY_RX_MESSAGE_BUFFER_SIZE);
+#else
 static CircularBuffer<transportQueuedMessage> transportRxQueue(transportRxQueueStorage,
         MY_RX_MESSAGE_BUFFER_SIZE);
+#endif
 
 static volatile uint8_t transportLostMessageCount = 0;
 
@@ -78,6 +88,11 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return RF24_sendMessage(to, data, len, noACK);
 }
 
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return RF24_sendMessage(to, data, len, noACK, true);
+}
+
 bool transportDataAvailable(void)
 {
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
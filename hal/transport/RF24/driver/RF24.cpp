@@ -37,9 +37,11 @@ LOCAL RF24_receiveCallbackType RF24_receiveCallback = NULL;
 #endif
 
 #if defined(__linux__)
-uint8_t RF24_spi_rxbuff[32+1] ; //SPI receive buffer (payload max 32 bytes)
-uint8_t RF24_spi_txbuff[32+1]
-; //SPI transmit buffer (payload max 32 bytes + 1 byte for the command)
+// SPI buffer of the queued transfers, room for a payload (max 32 bytes + 1 byte for the command)
+// and the register writes around it. Transfers are in place, received bytes replace sent bytes
+uint8_t RF24_spi_buff[2 * (32 + 1)];
+LOCAL uint8_t RF24_spiBatchLength = 0;	// bytes queued in RF24_spi_buff
+LOCAL uint8_t RF24_spiBatchDepth = 0;	// nested batches
 #endif
 
 LOCAL void RF24_csn(const bool level)
@@ -53,9 +55,37 @@ LOCAL void RF24_csn(const bool level)
 
 LOCAL void RF24_ce(const bool level)
 {
+#if defined(__linux__)
+	// queued register writes go first
+	RF24_SPI.flush();
+#endif
 	hwDigitalWrite(MY_RF24_CE_PIN, level);
 }
 
+LOCAL void RF24_spiBatchBegin(void)
+{
+#if defined(__linux__)
+	// the transaction is held, no other radio or thread can use the bus until the batch is sent
+	RF24_SPI.beginTransaction(SPISettings(MY_RF24_SPI_SPEED, RF24_SPI_DATA_ORDER,
+	                                      RF24_SPI_DATA_MODE));
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	RF24_SPI.chipSelect(MY_RF24_CS_PIN);
+#endif
+	RF24_spiBatchDepth++;
+#endif
+}
+
+LOCAL void RF24_spiBatchEnd(void)
+{
+#if defined(__linux__)
+	if (!--RF24_spiBatchDepth) {
+		RF24_SPI.flush();
+		RF24_spiBatchLength = 0;
+	}
+	RF24_SPI.endTransaction();
+#endif
+}
+
 LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t len,
                                         const bool readMode)
 {
@@ -64,15 +94,24 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t
 #if !defined(MY_SOFTSPI) && defined(SPI_HAS_TRANSACTION)
 	RF24_SPI.beginTransaction(SPISettings(MY_RF24_SPI_SPEED, RF24_SPI_DATA_ORDER,
 	                                      RF24_SPI_DATA_MODE));
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	// the radios share the bus
+	RF24_SPI.chipSelect(MY_RF24_CS_PIN);
+#endif
 #endif
 
 	RF24_csn(LOW);
 	// timing
 	delayMicroseconds(10);
 #ifdef __linux__
-	uint8_t *prx = RF24_spi_rxbuff;
-	uint8_t *ptx = RF24_spi_txbuff;
 	uint8_t size = len + 1; // Add register value to transmit buffer
+	if (RF24_spiBatchLength + size > sizeof(RF24_spi_buff)) {
+		// no room left, send the queued transfers
+		RF24_SPI.flush();
+		RF24_spiBatchLength = 0;
+	}
+	uint8_t *prx = &RF24_spi_buff[RF24_spiBatchLength];
+	uint8_t *ptx = prx;
 
 	*ptx++ = cmd;
 	while ( len-- ) {
@@ -82,19 +121,27 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t
 			*ptx++ = *current++;
 		}
 	}
-	RF24_SPI.transfernb( (char *) RF24_spi_txbuff, (char *) RF24_spi_rxbuff, size);
-	if (readMode) {
-		if (size == 2) {
-			status = *++prx;   // result is 2nd byte of receive buffer
-		} else {
-			status = *prx++; // status is 1st byte of receive buffer
-			// decrement before to skip status byte
-			while (--size && (buf != NULL)) {
-				*buf++ = *prx++;
+	RF24_SPI.queue((char *)prx, (char *)prx, size);
+	if (RF24_spiBatchDepth && !readMode) {
+		// register write of a batch, sent later with the other transfers
+		RF24_spiBatchLength += size;
+		status = 0;
+	} else {
+		RF24_SPI.flush();
+		RF24_spiBatchLength = 0;
+		if (readMode) {
+			if (size == 2) {
+				status = *++prx;   // result is 2nd byte of receive buffer
+			} else {
+				status = *prx++; // status is 1st byte of receive buffer
+				// decrement before to skip status byte
+				while (--size && (buf != NULL)) {
+					*buf++ = *prx++;
+				}
 			}
+		} else {
+			status = *prx; // status is 1st byte of receive buffer
 		}
-	} else {
-		status = *prx; // status is 1st byte of receive buffer
 	}
 #else
 	status = RF24_SPI.transfer(cmd);
@@ -151,7 +198,8 @@ LOCAL void RF24_flushTX(void)
 
 LOCAL uint8_t RF24_getStatus(void)
 {
-	return RF24_spiByteTransfer(RF24_CMD_NOP);
+	// read mode, the status is needed right away also in a batch
+	return RF24_spiMultiByteTransfer(RF24_CMD_NOP, NULL, 0, true);
 }
 
 LOCAL uint8_t RF24_getFIFOStatus(void)
@@ -305,41 +353,58 @@ LOCAL void RF24_standBy(void)
 
 
 LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint8_t len,
-                            const bool noACK)
+                            const bool noACK, const bool single)
 {
 	RF24_stopListening();
+	// the register writes up to the payload are sent at once when CE goes high
+	RF24_spiBatchBegin();
 	RF24_openWritingPipe(recipient);
 	RF24_DEBUG(PSTR("RF24:TXM:TO=%" PRIu8 ",LEN=%" PRIu8 "\n"), recipient, len); // send message
 	// flush TX FIFO
 	RF24_flushTX();
-	if (noACK) {
+	if (noACK || single) {
 		// noACK messages are only sent once
 		RF24_setRetries(RF24_SET_ARD, 0);
 	}
 	// this command is affected in clones (e.g. Si24R1):  flipped NoACK bit when using W_TX_PAYLOAD_NO_ACK / W_TX_PAYLOAD
 	// AutoACK is disabled on the broadcasting pipe - NO_ACK prevents resending
 	(void)RF24_spiMultiByteTransfer(RF24_CMD_WRITE_TX_PAYLOAD, (uint8_t *)buf, len, false);
+	RF24_spiBatchEnd();
 	// go, TX starts after ~10us, CE high also enables PA+LNA on supported HW
 	RF24_ce(HIGH);
+#if defined(__linux__)
+	// every status poll is an ioctl: no need to poll before the frame and its ACK can be on air
+	delayMicroseconds(RF24_TX_TIME_US(len) + (noACK ? 0u : RF24_TX_TIME_US(0u)));
+	uint16_t timeout = RF24_TX_POLL_TIMEOUT;
+#else
 	// timeout counter to detect HW issues
 	uint16_t timeout = 0xFFFF;
-	while (!(RF24_getStatus() & (_BV(RF24_MAX_RT) | _BV(RF24_TX_DS))) && timeout--) {
+#endif
+	uint8_t RF24_status = RF24_getStatus();
+	while (!(RF24_status & (_BV(RF24_MAX_RT) | _BV(RF24_TX_DS))) && timeout--) {
+#if defined(__linux__)
+		delayMicroseconds(RF24_TX_POLL_INTERVAL_US);
+#endif
 		doYield();
+		RF24_status = RF24_getStatus();
 	}
 	// timeout value after successful TX on 16Mhz AVR ~ 65500, i.e. msg is transmitted after ~36 loop cycles
 	RF24_ce(LOW);
+	// the register writes up to listening again are sent at once when CE goes high
+	RF24_spiBatchBegin();
 	// reset interrupts
-	const uint8_t RF24_status = RF24_setStatus(_BV(RF24_RX_DR) | _BV(RF24_TX_DS) | _BV(RF24_MAX_RT));
+	(void)RF24_setStatus(_BV(RF24_RX_DR) | _BV(RF24_TX_DS) | _BV(RF24_MAX_RT));
 	// Max retries exceeded
 	if (RF24_status & _BV(RF24_MAX_RT)) {
 		// flush packet
 		RF24_DEBUG(PSTR("?RF24:TXM:MAX_RT\n"));	// max retries (normal messages) and noACK messages
 		RF24_flushTX();
 	}
-	if (noACK) {
+	if (noACK || single) {
 		RF24_setRetries(RF24_SET_ARD, RF24_SET_ARC);
 	}
 	RF24_startListening();
+	RF24_spiBatchEnd();
 	// true if message sent
 	return (RF24_status & _BV(RF24_TX_DS) || noACK);
 }
@@ -370,11 +435,21 @@ LOCAL bool RF24_isDataAvailable(void)
 
 LOCAL uint8_t RF24_readMessage(void *buf)
 {
+#if defined(__linux__)
+	RF24_spiBatchBegin();
+	// clear RX interrupt, sent with the payload size request. The payload stays in the RX FIFO and a
+	// packet received meanwhile raises the interrupt again
+	(void)RF24_setStatus(_BV(RF24_RX_DR));
+#endif
 	const uint8_t len = RF24_getDynamicPayloadSize();
 	RF24_DEBUG(PSTR("RF24:RXM:LEN=%" PRIu8 "\n"), len);	// read message
 	RF24_spiMultiByteTransfer(RF24_CMD_READ_RX_PAYLOAD, (uint8_t *)buf, len, true);
+#if defined(__linux__)
+	RF24_spiBatchEnd();
+#else
 	// clear RX interrupt
 	(void)RF24_setStatus(_BV(RF24_RX_DR));
+#endif
 	return len;
 }
 
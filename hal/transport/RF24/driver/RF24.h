@@ -130,6 +130,19 @@
 // powerup delay
 #define RF24_POWERUP_DELAY_MS	(100u)		//!< Power up delay, allow VCC to settle, transport to become fully operational
 
+// TX status polling on Linux, where every poll is an ioctl
+#if (MY_RF24_DATARATE == RF24_250KBPS)
+#define RF24_BIT_TIME_NS		(4000u)		//!< Duration of a bit on air
+#elif (MY_RF24_DATARATE == RF24_2MBPS)
+#define RF24_BIT_TIME_NS		(500u)		//!< Duration of a bit on air
+#else
+#define RF24_BIT_TIME_NS		(1000u)		//!< Duration of a bit on air
+#endif
+#define RF24_TX_SETTLING_US		(130u)		//!< PLL settling time before a transmission
+#define RF24_TX_TIME_US(__len)	(RF24_TX_SETTLING_US + (8u * (1u + MY_RF24_ADDR_WIDTH + (__len) + 2u) + 9u) * RF24_BIT_TIME_NS / 1000u)	//!< Shortest transmission: preamble, address, packet control field, payload and CRC
+#define RF24_TX_POLL_INTERVAL_US	(100u)		//!< Pause between two TX status polls
+#define RF24_TX_POLL_TIMEOUT	(1000u)		//!< TX status polls before giving up, longer than all retransmissions
+
 // pipes
 #define RF24_BROADCAST_PIPE		(1u)		//!< RF24_BROADCAST_PIPE
 #define RF24_NODE_PIPE			(0u)		//!< RF24_NODE_PIPE
@@ -146,12 +159,21 @@ LOCAL void RF24_csn(const bool level);
 */
 LOCAL void RF24_ce(const bool level);
 /**
+* @brief RF24_spiBatchBegin, from here to RF24_spiBatchEnd() register writes are queued and sent
+* with the next read, the next CE change or at the end, in a single ioctl (Linux only)
+*/
+LOCAL void RF24_spiBatchBegin(void);
+/**
+* @brief RF24_spiBatchEnd, send the queued register writes
+*/
+LOCAL void RF24_spiBatchEnd(void);
+/**
 * @brief RF24_spiMultiByteTransfer
 * @param cmd
 * @param buf
 * @param len
 * @param readMode
-* @return
+* @return status, 0 for a write queued in a batch
 */
 LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, const uint8_t len,
                                         const bool readMode);
@@ -233,10 +255,11 @@ LOCAL void RF24_powerUp(void);
 * @param buf
 * @param len
 * @param noACK set True if no ACK is required
+* @param single set True to send only once, without auto retransmissions
 * @return
 */
 LOCAL bool RF24_sendMessage(const uint8_t recipient, const void *buf, const uint8_t len,
-                            const bool noACK = false);
+                            const bool noACK = false, const bool single = false);
 /**
 * @brief RF24_getDynamicPayloadSize
 * @return
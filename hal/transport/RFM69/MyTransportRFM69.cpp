@@ -62,6 +62,11 @@ bool transportSend(const uint8_t to, const void *data, uint8_t len, const bool n
 	return RFM69_sendWithRetry(to, data, len, noACK);
 }
 
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return RFM69_sendWithRetry(to, data, len, noACK, true);
+}
+
 bool transportDataAvailable(void)
 {
 	RFM69_handler();
@@ -211,6 +216,14 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return _radio.sendWithRetry(to, data, len);
 }
 
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	if (noACK) {
+		return transportSend(to, data, len, noACK);
+	}
+	return _radio.sendWithRetry(to, data, len, 0);
+}
+
 bool transportDataAvailable(void)
 {
 	return _radio.receiveDone();
@@ -33,6 +33,11 @@
  */
 
 #include "RFM69_new.h"
+#if defined(__linux__)
+#include "hal/architecture/Linux/drivers/core/SPSCRingBuffer.h"
+#else
+#include "drivers/CircularBuffer/CircularBuffer.h"
+#endif
 
 // debug
 #if defined(MY_DEBUG_VERBOSE_RFM69)
@@ -44,10 +49,31 @@
 rfm69_internal_t RFM69;	//!< internal variables
 volatile uint8_t RFM69_irq; //!< rfm69 irq flag
 
+static rfm69_packet_t RFM69_rxQueueStorage[MY_RFM69_RX_BUFFER_SIZE];	//!< RX queue storage
+#if defined(__linux__)
+// Filled by the interrupt thread and drained by the main loop only, no locking needed
+static SPSCRingBuffer<rfm69_packet_t> RFM69_rxQueue(RFM69_rxQueueStorage,
+        MY_RFM69_RX_BUFFER_SIZE);	//!< Received packets, not yet read
+#else
+static CircularBuffer<rfm69_packet_t> RFM69_rxQueue(RFM69_rxQueueStorage,
+        MY_RFM69_RX_BUFFER_SIZE);	//!< Received packets, not yet read
+#endif
+
 #if defined(__linux__)
-// SPI RX and TX buffers (max packet len + 1 byte for the command)
-uint8_t RFM69_spi_rxbuff[RFM69_MAX_PACKET_LEN + 1];
-uint8_t RFM69_spi_txbuff[RFM69_MAX_PACKET_LEN + 1];
+// SPI buffer of the queued transfers, room for a packet (max packet len + 1 byte for the command)
+// and the register accesses around it. Transfers are in place, received bytes replace sent bytes
+uint8_t RFM69_spi_buff[2 * (RFM69_MAX_PACKET_LEN + 1)];
+static uint8_t RFM69_spiBatchLength = 0;	// bytes queued in RFM69_spi_buff
+static uint8_t RFM69_spiBatchDepth = 0;	// nested batches
+// The interrupt thread reads packets while the main loop sends, both switch the radio mode and
+// access the FIFO: they take turns on this lock, it may be taken recursively
+static pthread_mutex_t RFM69_mutex;
+static bool RFM69_mutexInitialised = false;
+#define RFM69_LOCK()	(void)pthread_mutex_lock(&RFM69_mutex)		//!< Take the driver lock
+#define RFM69_UNLOCK()	(void)pthread_mutex_unlock(&RFM69_mutex)	//!< Release the driver lock
+#else
+#define RFM69_LOCK()		//!< Packets are read in the main loop, no lock needed
+#define RFM69_UNLOCK()		//!< Packets are read in the main loop, no lock needed
 #endif
 
 LOCAL void RFM69_csn(const bool level)
@@ -64,6 +90,10 @@ LOCAL void RFM69_prepareSPITransaction(void)
 #if !defined(MY_SOFTSPI) && defined(SPI_HAS_TRANSACTION)
 	RFM69_SPI.beginTransaction(SPISettings(MY_RFM69_SPI_SPEED, RFM69_SPI_DATA_ORDER,
 	                                       RFM69_SPI_DATA_MODE));
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	// the radios share the bus
+	RFM69_SPI.chipSelect(MY_RFM69_CS_PIN);
+#endif
 #endif
 }
 
@@ -74,6 +104,28 @@ LOCAL void RFM69_concludeSPITransaction(void)
 #endif
 }
 
+// From here to RFM69_spiBatchEnd() register writes are queued and sent with the next read, or at
+// the end, in a single ioctl. Take the driver lock first, the interrupt thread takes it first too
+LOCAL void RFM69_spiBatchBegin(void)
+{
+#if defined(__linux__)
+	// the transaction is held, no other radio or thread can use the bus until the batch is sent
+	RFM69_prepareSPITransaction();
+	RFM69_spiBatchDepth++;
+#endif
+}
+
+LOCAL void RFM69_spiBatchEnd(void)
+{
+#if defined(__linux__)
+	if (!--RFM69_spiBatchDepth) {
+		RFM69_SPI.flush();
+		RFM69_spiBatchLength = 0;
+	}
+	RFM69_concludeSPITransaction();
+#endif
+}
+
 LOCAL uint8_t RFM69_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t len,
         const bool aReadMode)
 {
@@ -84,9 +136,14 @@ LOCAL uint8_t RFM69_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 	RFM69_csn(LOW);
 
 #if defined(__linux__)
-	uint8_t *prx = RFM69_spi_rxbuff;
-	uint8_t *ptx = RFM69_spi_txbuff;
 	uint8_t size = len + 1; // Add register value to transmit buffer
+	if (RFM69_spiBatchLength + size > sizeof(RFM69_spi_buff)) {
+		// no room left, send the queued transfers
+		RFM69_SPI.flush();
+		RFM69_spiBatchLength = 0;
+	}
+	uint8_t *prx = &RFM69_spi_buff[RFM69_spiBatchLength];
+	uint8_t *ptx = prx;
 
 	*ptx++ = cmd;
 	while (len--) {
@@ -96,19 +153,27 @@ LOCAL uint8_t RFM69_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 			*ptx++ = *current++;
 		}
 	}
-	RFM69_SPI.transfernb((char *)RFM69_spi_txbuff, (char *)RFM69_spi_rxbuff, size);
-	if (aReadMode) {
-		if (size == 2) {
-			status = *++prx;   // result is 2nd byte of receive buffer
-		} else {
-			status = *prx++; // status is 1st byte of receive buffer
-			// decrement before to skip status byte
-			while (--size && (buf != NULL)) {
-				*buf++ = *prx++;
+	RFM69_SPI.queue((char *)prx, (char *)prx, size);
+	if (RFM69_spiBatchDepth && !aReadMode) {
+		// register write of a batch, sent later with the other transfers
+		RFM69_spiBatchLength += size;
+		status = 0;
+	} else {
+		RFM69_SPI.flush();
+		RFM69_spiBatchLength = 0;
+		if (aReadMode) {
+			if (size == 2) {
+				status = *++prx;   // result is 2nd byte of receive buffer
+			} else {
+				status = *prx++; // status is 1st byte of receive buffer
+				// decrement before to skip status byte
+				while (--size && (buf != NULL)) {
+					*buf++ = *prx++;
+				}
 			}
+		} else {
+			status = *prx; // status is 1st byte of receive buffer
 		}
-	} else {
-		status = *prx; // status is 1st byte of receive buffer
 	}
 #else
 	status = RFM69_SPI.transfer(cmd);
@@ -198,8 +263,8 @@ LOCAL bool RFM69_initialise(const uint32_t frequencyHz)
 
 	// set variables
 	RFM69.address = RFM69_BROADCAST_ADDRESS;
-	RFM69.dataReceived = false;
 	RFM69.ackReceived = false;
+	RFM69.rxLost = 0;
 	RFM69.txSequenceNumber = 0;	// initialise TX sequence counter
 	RFM69.powerLevel = MY_RFM69_TX_POWER_DBM + 1;	// will be overwritten when set
 	RFM69.radioMode = RFM69_RADIO_MODE_SLEEP;
@@ -210,6 +275,16 @@ LOCAL bool RFM69_initialise(const uint32_t frequencyHz)
 #if !defined(__linux__)
 	hwDigitalWrite(MY_RFM69_CS_PIN, HIGH);
 	hwPinMode(MY_RFM69_CS_PIN, OUTPUT);
+#else
+	if (!RFM69_mutexInitialised) {
+		// once, the interrupt thread stays attached when the transport is initialised again
+		pthread_mutexattr_t attr;
+		(void)pthread_mutexattr_init(&attr);
+		(void)pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		(void)pthread_mutex_init(&RFM69_mutex, &attr);
+		(void)pthread_mutexattr_destroy(&attr);
+		RFM69_mutexInitialised = true;
+	}
 #endif
 	RFM69_SPI.begin();
 	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
@@ -244,49 +319,61 @@ LOCAL void RFM69_clearFIFO(void)
 // IRQ handler: PayloadReady (RX) & PacketSent (TX) mapped to DI0
 LOCAL void IRQ_HANDLER_ATTR RFM69_interruptHandler(void)
 {
+#if defined(__linux__)
+	// Interrupt thread: read the packet right away, the main loop may be busy sending
+	RFM69_LOCK();
+	RFM69_interruptHandling();
+	RFM69_UNLOCK();
+#else
 	// set flag
 	RFM69_irq = true;
+#endif
 }
 
 LOCAL void RFM69_interruptHandling(void)
 {
+	RFM69_spiBatchBegin();
 	const uint8_t regIrqFlags2 = RFM69_readReg(RFM69_REG_IRQFLAGS2);
 	if (RFM69.radioMode == RFM69_RADIO_MODE_RX && (regIrqFlags2 & RFM69_IRQFLAGS2_PAYLOADREADY)) {
 		(void)RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
 		// use the fifo level irq as indicator if header bytes received
 		if (regIrqFlags2 & RFM69_IRQFLAGS2_FIFOLEVEL) {
+			rfm69_packet_t packet;
+			bool valid = false;
 			RFM69_prepareSPITransaction();
 			RFM69_csn(LOW);
 #if defined(__linux__)
 			char data[RFM69_MAX_PACKET_LEN + 1];   // max packet len + 1 byte for the command
 			data[0] = RFM69_REG_FIFO & RFM69_READ_REGISTER;
-			RFM69_SPI.transfern(data, 3);
+			// sent with the queued register writes
+			RFM69_SPI.queue(data, data, 3);
+			RFM69_SPI.flush();
 
-			RFM69.currentPacket.header.packetLen = data[1];
-			RFM69.currentPacket.header.recipient = data[2];
+			packet.header.packetLen = data[1];
+			packet.header.recipient = data[2];
 
-			if (RFM69.currentPacket.header.packetLen > RFM69_MAX_PACKET_LEN) {
-				RFM69.currentPacket.header.packetLen = RFM69_MAX_PACKET_LEN;
+			// the length byte is not counted, a corrupt length must not overrun the packet
+			if (packet.header.packetLen > RFM69_MAX_PACKET_LEN - 1) {
+				packet.header.packetLen = RFM69_MAX_PACKET_LEN - 1;
 			}
 
-			data[0] = RFM69_REG_FIFO & RFM69_READ_REGISTER;
-			//SPI.transfern(data, RFM69.currentPacket.header.packetLen - 1); //TODO: Wrong packetLen?
-			RFM69_SPI.transfern(data, RFM69.currentPacket.header.packetLen);
-
-			//(void)memcpy((void *)&RFM69.currentPacket.data[2], (void *)&data[1], RFM69.currentPacket.header.packetLen - 2);   //TODO: Wrong packetLen?
-			(void)memcpy((void *)&RFM69.currentPacket.data[2], (void *)&data[1],
-			             RFM69.currentPacket.header.packetLen - 1);
-
-			if (RFM69.currentPacket.header.version >= RFM69_MIN_PACKET_HEADER_VERSION) {
-				RFM69.currentPacket.payloadLen = min(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1),
-				                                     RFM69_MAX_PACKET_LEN);
-				RFM69.ackReceived = RFM69_getACKReceived(RFM69.currentPacket.header.controlFlags);
-				RFM69.dataReceived = !RFM69.ackReceived;
+			if (packet.header.packetLen >= RFM69_HEADER_LEN - 1) {
+				data[0] = RFM69_REG_FIFO & RFM69_READ_REGISTER;
+				//SPI.transfern(data, packet.header.packetLen - 1); //TODO: Wrong packetLen?
+				RFM69_SPI.transfern(data, packet.header.packetLen);
+
+				//(void)memcpy((void *)&packet.data[2], (void *)&data[1], packet.header.packetLen - 2);   //TODO: Wrong packetLen?
+				(void)memcpy((void *)&packet.data[2], (void *)&data[1], packet.header.packetLen - 1);
+
+				if (packet.header.version >= RFM69_MIN_PACKET_HEADER_VERSION) {
+					packet.payloadLen = static_cast<uint8_t>(packet.header.packetLen - (RFM69_HEADER_LEN - 1));
+					valid = true;
+				}
 			}
 #else
 			(void)RFM69_SPI.transfer(RFM69_REG_FIFO & RFM69_READ_REGISTER);
 			// set reading pointer
-			uint8_t *current = (uint8_t *)&RFM69.currentPacket;
+			uint8_t *current = (uint8_t *)&packet;
 			bool headerRead = false;
 			// first read header
 			uint8_t readingLength = RFM69_HEADER_LEN;
@@ -295,67 +382,92 @@ LOCAL void RFM69_interruptHandling(void)
 				if (!readingLength && !headerRead) {
 					// header read
 					headerRead = true;
-					if (RFM69.currentPacket.header.version >= RFM69_MIN_PACKET_HEADER_VERSION) {
-						// read payload
-						readingLength = min(RFM69.currentPacket.header.packetLen - (RFM69_HEADER_LEN - 1),
-						                    RFM69_MAX_PACKET_LEN);
+					if (packet.header.version >= RFM69_MIN_PACKET_HEADER_VERSION &&
+					        packet.header.packetLen >= RFM69_HEADER_LEN - 1) {
+						// read payload, a corrupt length must not overrun the packet
+						readingLength = min(static_cast<uint8_t>(packet.header.packetLen - (RFM69_HEADER_LEN - 1)),
+						                    static_cast<uint8_t>(RFM69_MAX_PAYLOAD_LEN));
 						// save payload length
-						RFM69.currentPacket.payloadLen = readingLength;
-						RFM69.ackReceived = RFM69_getACKReceived(RFM69.currentPacket.header.controlFlags);
-						RFM69.dataReceived = !RFM69.ackReceived;
+						packet.payloadLen = readingLength;
+						valid = true;
 					}
 				}
 			}
 #endif
 			RFM69_csn(HIGH);
 			RFM69_concludeSPITransaction();
+			if (valid) {
+				packet.RSSI = RFM69_readRSSI();
+				if (RFM69_getACKReceived(packet.header.controlFlags)) {
+					RFM69.lastACK.sender = packet.header.sender;
+					RFM69.lastACK.controlFlags = packet.header.controlFlags;
+					RFM69.lastACK.ACK = packet.ACK;
+					RFM69.ackReceived = true;
+				} else if (!RFM69_rxQueue.pushFront(&packet)) {
+					// Queue is full, e.g. the node did not read while waiting for an ACK
+					if (RFM69.rxLost < UINT16_MAX) {
+						RFM69.rxLost++;
+					}
+					RFM69_DEBUG(PSTR("!RFM69:IRH:QUEUE FULL,LOST=%" PRIu16 "\n"), RFM69.rxLost);
+				}
+			}
 		}
-		RFM69.currentPacket.RSSI = RFM69_readRSSI();
-		// radio remains in stdby until packet read
-	} else {
-		// back to RX
-		(void)RFM69_setRadioMode(RFM69_RADIO_MODE_RX);
 	}
+	// packet is queued, back to RX
+	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_RX);
+	RFM69_spiBatchEnd();
 }
 
 LOCAL void RFM69_handler(void)
 {
 	if (RFM69_irq) {
-		// radio is in STDBY
 		// clear flag, 8bit - no need for critical section
 		RFM69_irq = false;
 		RFM69_interruptHandling();
 	}
 }
 
+LOCAL rfm69_radio_mode_t RFM69_getRadioMode(void)
+{
+	RFM69_handler();
+	RFM69_LOCK();
+	const rfm69_radio_mode_t radioMode = RFM69.radioMode;
+	RFM69_UNLOCK();
+	return radioMode;
+}
+
 LOCAL bool RFM69_available(void)
 {
-	if (RFM69.dataReceived) {
-		// data received - we are still in STDBY
+	if (!RFM69_rxQueue.empty()) {
 		return true;
-	} else if (RFM69.radioMode == RFM69_RADIO_MODE_TX) {
-		// still in TX
-		return false;
-	} else if (RFM69.radioMode != RFM69_RADIO_MODE_RX) { // adding this check speeds up loop() :)
+	}
+	RFM69_LOCK();
+	if (RFM69.radioMode != RFM69_RADIO_MODE_RX && RFM69.radioMode != RFM69_RADIO_MODE_TX) {
 		// no data received and not in RX
 		(void)RFM69_setRadioMode(RFM69_RADIO_MODE_RX);
 	}
+	RFM69_UNLOCK();
 	return false;
 }
 
 LOCAL uint8_t RFM69_receive(uint8_t *buf, const uint8_t maxBufSize)
 {
-	const uint8_t payloadLen = min(RFM69.currentPacket.payloadLen, maxBufSize);
-	const uint8_t sender = RFM69.currentPacket.header.sender;
-	const rfm69_sequenceNumber_t sequenceNumber = RFM69.currentPacket.header.sequenceNumber;
-	const uint8_t controlFlags = RFM69.currentPacket.header.controlFlags;
-	const rfm69_RSSI_t RSSI = RFM69.currentPacket.RSSI;
+	rfm69_packet_t *packet = RFM69_rxQueue.getBack();
+	if (packet == NULL) {
+		return 0;
+	}
+	const uint8_t payloadLen = min(packet->payloadLen, maxBufSize);
+	const uint8_t sender = packet->header.sender;
+	const rfm69_sequenceNumber_t sequenceNumber = packet->header.sequenceNumber;
+	const uint8_t controlFlags = packet->header.controlFlags;
+	const rfm69_RSSI_t RSSI = packet->RSSI;
 
 	if (buf != NULL) {
-		(void)memcpy((void *)buf, (void *)&RFM69.currentPacket.payload, payloadLen);
+		(void)memcpy((void *)buf, (void *)&packet->payload, payloadLen);
 	}
-	// clear data flag
-	RFM69.dataReceived = false;
+	// free the slot
+	(void)RFM69_rxQueue.popBack();
+	RFM69.RSSI = RSSI;
 	if (RFM69_getACKRequested(controlFlags) && !RFM69_getACKReceived(controlFlags)) {
 #if defined(MY_GATEWAY_FEATURE) && (F_CPU>16*1000000ul)
 		// delay for fast GW and slow nodes
@@ -377,8 +489,10 @@ LOCAL bool RFM69_channelFree(void)
 LOCAL bool RFM69_sendFrame(rfm69_packet_t *packet, const bool increaseSequenceCounter)
 {
 	// ensure we are in RX for correct RSSI sampling, dirty hack to enforce rx restart :)
+	RFM69_LOCK();
 	RFM69.radioMode = RFM69_RADIO_MODE_STDBY;
 	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_RX);
+	RFM69_UNLOCK();
 	delay(1); // timing for correct RSSI sampling
 	const uint32_t CSMA_START_MS = hwMillis();
 	while (!RFM69_channelFree() &&
@@ -386,6 +500,8 @@ LOCAL bool RFM69_sendFrame(rfm69_packet_t *packet, const bool increaseSequenceCo
 		doYield();
 	}
 	// set radio to standby to load fifo
+	RFM69_LOCK();
+	RFM69_spiBatchBegin();
 	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_STDBY);
 	if (increaseSequenceCounter) {
 		// increase sequence counter, overflow is ok
@@ -401,12 +517,15 @@ LOCAL bool RFM69_sendFrame(rfm69_packet_t *packet, const bool increaseSequenceCo
 	(void)RFM69_burstWriteReg(RFM69_REG_FIFO, packet->data, finalLen);
 
 	// send message
-	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_TX); // irq upon txsent
+	(void)RFM69_setRadioMode(RFM69_RADIO_MODE_TX); // irq upon txsent, radio returns to RX
+	RFM69_spiBatchEnd();
+	RFM69_UNLOCK();
 	const uint32_t txStartMS = hwMillis();
-	while (!RFM69_irq && (hwMillis() - txStartMS < MY_RFM69_TX_TIMEOUT_MS)) {
+	while (RFM69_getRadioMode() == RFM69_RADIO_MODE_TX &&
+	        (hwMillis() - txStartMS < MY_RFM69_TX_TIMEOUT_MS)) {
 		doYield();
 	};
-	return RFM69_irq;
+	return RFM69_getRadioMode() != RFM69_RADIO_MODE_TX;
 }
 
 LOCAL bool RFM69_send(const uint8_t recipient, uint8_t *data, const uint8_t len,
@@ -491,10 +610,13 @@ LOCAL uint8_t RFM69_getAddress(void)
 
 LOCAL bool RFM69_setRadioMode(const rfm69_radio_mode_t newRadioMode)
 {
+	RFM69_LOCK();
 	if (RFM69.radioMode == newRadioMode) {
 		// no change
+		RFM69_UNLOCK();
 		return false;
 	}
+	RFM69_spiBatchBegin();
 
 	uint8_t regMode;
 
@@ -503,8 +625,6 @@ LOCAL bool RFM69_setRadioMode(const rfm69_radio_mode_t newRadioMode)
 	} else if (newRadioMode == RFM69_RADIO_MODE_SLEEP) {
 		regMode = RFM69_OPMODE_SEQUENCER_OFF | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_SLEEP;
 	} else if (newRadioMode == RFM69_RADIO_MODE_RX) {
-		RFM69.dataReceived = false;
-		RFM69.ackReceived = false;
 		regMode = RFM69_OPMODE_SEQUENCER_ON | RFM69_OPMODE_LISTEN_OFF | RFM69_OPMODE_RECEIVER;
 		RFM69_writeReg(RFM69_REG_DIOMAPPING1, RFM69_DIOMAPPING1_DIO0_01); // Interrupt on PayloadReady, DIO0
 		// disable high power settings
@@ -528,10 +648,14 @@ LOCAL bool RFM69_setRadioMode(const rfm69_radio_mode_t newRadioMode)
 	if (RFM69.radioMode == RFM69_RADIO_MODE_SLEEP) {
 		// wait for ModeReady
 		if (!RFM69_isModeReady()) {
+			RFM69_spiBatchEnd();
+			RFM69_UNLOCK();
 			return false;
 		}
 	}
 	RFM69.radioMode = newRadioMode;
+	RFM69_spiBatchEnd();
+	RFM69_UNLOCK();
 	return true;
 }
 
@@ -609,32 +733,36 @@ LOCAL void RFM69_ATCmode(const bool onOff, const int16_t targetRSSI)
 
 
 LOCAL bool RFM69_sendWithRetry(const uint8_t recipient, const void *buffer,
-                               const uint8_t bufferSize, const bool noACK)
+                               const uint8_t bufferSize, const bool noACK, const bool single)
 {
-	for (uint8_t retry = 0; retry < RFM69_RETRIES; retry++) {
+	for (uint8_t retry = 0; retry < (single ? 1u : RFM69_RETRIES); retry++) {
 		RFM69_DEBUG(PSTR("RFM69:SWR:SEND,TO=%" PRIu8 ",SEQ=%" PRIu16 ",RETRY=%" PRIu8 "\n"), recipient,
 		            RFM69.txSequenceNumber,retry);
 		rfm69_controlFlags_t flags = 0u; // reset all flags
 		RFM69_setACKRequested(flags, !noACK);
 		RFM69_setACKRSSIReport(flags, RFM69.ATCenabled);
+		RFM69_LOCK();
+		RFM69.ackReceived = false;
+		RFM69_UNLOCK();
 		(void)RFM69_send(recipient, (uint8_t *)buffer, bufferSize, flags, !retry);
 		if (noACK) {
 			// no ACK requested
 			return true;
 		}
-		// radio is in RX
+		// radio is in RX, packets arriving meanwhile are queued
 		const uint32_t enterMS = hwMillis();
-		while (hwMillis() - enterMS < RFM69_RETRY_TIMEOUT_MS && !RFM69.dataReceived) {
+		while (hwMillis() - enterMS < RFM69_RETRY_TIMEOUT_MS) {
 			RFM69_handler();
-			if (RFM69.ackReceived) {
-				// radio is in stdby
-				const uint8_t ACKsender = RFM69.currentPacket.header.sender;
-				const rfm69_sequenceNumber_t ACKsequenceNumber = RFM69.currentPacket.ACK.sequenceNumber;
-				const rfm69_controlFlags_t ACKflags = RFM69.currentPacket.header.controlFlags;
-				const rfm69_RSSI_t ACKRSSI = RFM69.currentPacket.ACK.RSSI;
-				RFM69.ackReceived = false;
-				// packet read, back to RX
-				RFM69_setRadioMode(RFM69_RADIO_MODE_RX);
+			RFM69_LOCK();
+			const bool ackReceived = RFM69.ackReceived;
+			const rfm69_lastACK_t lastACK = RFM69.lastACK;
+			RFM69.ackReceived = false;
+			RFM69_UNLOCK();
+			if (ackReceived) {
+				const uint8_t ACKsender = lastACK.sender;
+				const rfm69_sequenceNumber_t ACKsequenceNumber = lastACK.ACK.sequenceNumber;
+				const rfm69_controlFlags_t ACKflags = lastACK.controlFlags;
+				const rfm69_RSSI_t ACKRSSI = lastACK.ACK.RSSI;
 				if (ACKsender == recipient && ACKsequenceNumber == RFM69.txSequenceNumber) {
 					RFM69_DEBUG(PSTR("RFM69:SWR:ACK,FROM=%" PRIu8 ",SEQ=%" PRIu8 ",RSSI=%" PRIi16 "\n"), ACKsender,
 					            ACKsequenceNumber,
@@ -656,8 +784,8 @@ LOCAL bool RFM69_sendWithRetry(const uint8_t recipient, const void *buffer,
 LOCAL int16_t RFM69_getSendingRSSI(void)
 {
 	// own RSSI, as measured by the recipient - ACK part
-	if (RFM69_getACKRSSIReport(RFM69.currentPacket.header.controlFlags)) {
-		return RFM69_internalToRSSI(RFM69.currentPacket.ACK.RSSI);
+	if (RFM69_getACKRSSIReport(RFM69.lastACK.controlFlags)) {
+		return RFM69_internalToRSSI(RFM69.lastACK.ACK.RSSI);
 	} else {
 		// not valid
 		return 127;
@@ -667,7 +795,7 @@ LOCAL int16_t RFM69_getSendingRSSI(void)
 LOCAL int16_t RFM69_getReceivingRSSI(void)
 {
 	// RSSI from sender
-	return RFM69_internalToRSSI(RFM69.currentPacket.RSSI);
+	return RFM69_internalToRSSI(RFM69.RSSI);
 }
 
 LOCAL bool RFM69_setTxPowerPercent(uint8_t newPowerPercent)
@@ -49,6 +49,7 @@
 * | | RFM69 | INIT | PIN,CS=%%d,IQP=%%d,IQN=%%d[,RST=%%d] | Pin configuration: chip select (CS), IRQ pin (IQP), IRQ number (IQN), Reset (RST)
 * | | RFM69 | INIT | HWV=%%d                              | HW version, see datasheet chapter 9
 * |!| RFM69 | INIT | SANCHK FAIL                          | Sanity check failed, check wiring or replace module
+* |!| RFM69 | IRH  | QUEUE FULL,LOST=%%d                  | RX queue full, packet dropped, packets dropped so far (LOST)
 * | | RFM69 | PTX  | NO ADJ                               | TX power level, no adjustment
 * | | RFM69 | PTX  | LEVEL=%%d dbM                        | TX power level, set to (LEVEL) dBm
 * | | RFM69 | SAC  | SEND ACK,TO=%%d,RSSI=%%d             | ACK sent to (TO), RSSI of incoming message (RSSI)
@@ -312,21 +313,31 @@ typedef struct {
 	rfm69_RSSI_t RSSI;									//!< RSSI of current packet, RSSI = value - 137
 } __attribute__((packed)) rfm69_packet_t;
 
+/**
+* @brief Last ACK received
+*/
+typedef struct {
+	uint8_t sender;                         //!< ACK sender
+	rfm69_controlFlags_t controlFlags;      //!< Control flags of the ACK
+	rfm69_ack_t ACK;                        //!< ACK as sent by the recipient
+} __attribute__((packed)) rfm69_lastACK_t;
+
 /**
 * @brief RFM69 internal variables
 */
 typedef struct {
 	uint8_t address;                           //!< Node address
-	rfm69_packet_t currentPacket;              //!< Buffer for current packet
+	rfm69_lastACK_t lastACK;                   //!< Last ACK received
+	rfm69_RSSI_t RSSI;                         //!< RSSI of the last packet read from the RX queue
+	uint16_t rxLost;                           //!< Packets dropped because the RX queue was full
 	rfm69_sequenceNumber_t txSequenceNumber;   //!< RFM69_txSequenceNumber
 	rfm69_powerlevel_t powerLevel;             //!< TX power level dBm
 	uint8_t ATCtargetRSSI;                     //!< ATC: target RSSI
 	// 8 bit
 	rfm69_radio_mode_t radioMode : 3;          //!< current transceiver state
-	bool dataReceived : 1;                     //!< data received
 	bool ackReceived : 1;                      //!< ACK received
 	bool ATCenabled : 1;                       //!< ATC enabled
-	uint8_t reserved : 2;                      //!< Reserved
+	uint8_t reserved : 3;                      //!< Reserved
 } rfm69_internal_t;
 
 #define LOCAL static		//!< static
@@ -336,6 +347,12 @@ typedef struct {
 */
 LOCAL void RFM69_handler(void);
 
+/**
+* @brief Radio mode, once pending interrupts are handled
+* @return Current radio mode
+*/
+LOCAL rfm69_radio_mode_t RFM69_getRadioMode(void);
+
 /**
 * @brief Clear flags and FIFO
 */
@@ -467,11 +484,12 @@ LOCAL void RFM69_sendACK(const uint8_t recipient, const rfm69_sequenceNumber_t s
 * @param buffer
 * @param bufferSize
 * @param noACK
+* @param single Send only once, do not retry if no ACK is received
 * @return True if packet successfully sent
 */
 LOCAL bool RFM69_sendWithRetry(const uint8_t recipient, const void *buffer,
                                const uint8_t bufferSize,
-                               const bool noACK);
+                               const bool noACK, const bool single = false);
 
 /**
 * @brief RFM69_setRadioMode
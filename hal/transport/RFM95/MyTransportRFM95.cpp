@@ -47,6 +47,11 @@ bool transportSend(const uint8_t to, const void *data, const uint8_t len, const
 	return RFM95_sendWithRetry(to, data, len, noACK);
 }
 
+bool transportSendOnce(const uint8_t to, const void *data, const uint8_t len, const bool noACK)
+{
+	return RFM95_sendWithRetry(to, data, len, noACK, true);
+}
+
 bool transportDataAvailable(void)
 {
 	RFM95_handler();
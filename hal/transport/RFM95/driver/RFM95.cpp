@@ -27,6 +27,11 @@
  */
 
 #include "RFM95.h"
+#if defined(__linux__)
+#include "hal/architecture/Linux/drivers/core/SPSCRingBuffer.h"
+#else
+#include "drivers/CircularBuffer/CircularBuffer.h"
+#endif
 
 // debug
 #if defined(MY_DEBUG_VERBOSE_RFM95)
@@ -38,10 +43,31 @@
 rfm95_internal_t RFM95;	//!< internal variables
 volatile uint8_t RFM95_irq; //<! rfm95 irq flag
 
+static rfm95_packet_t RFM95_rxQueueStorage[MY_RFM95_RX_BUFFER_SIZE];	//!< RX queue storage
+#if defined(__linux__)
+// Filled by the interrupt thread and drained by the main loop only, no locking needed
+static SPSCRingBuffer<rfm95_packet_t> RFM95_rxQueue(RFM95_rxQueueStorage,
+        MY_RFM95_RX_BUFFER_SIZE);	//!< Received packets, not yet read
+#else
+static CircularBuffer<rfm95_packet_t> RFM95_rxQueue(RFM95_rxQueueStorage,
+        MY_RFM95_RX_BUFFER_SIZE);	//!< Received packets, not yet read
+#endif
+
 #if defined(__linux__)
-// SPI RX and TX buffers (max packet len + 1 byte for the command)
-uint8_t RFM95_spi_rxbuff[RFM95_MAX_PACKET_LEN + 1];
-uint8_t RFM95_spi_txbuff[RFM95_MAX_PACKET_LEN + 1];
+// SPI buffer of the queued transfers, room for a packet (max packet len + 1 byte for the command)
+// and the register accesses around it. Transfers are in place, received bytes replace sent bytes
+uint8_t RFM95_spi_buff[2 * (RFM95_MAX_PACKET_LEN + 1)];
+static uint8_t RFM95_spiBatchLength = 0;	// bytes queued in RFM95_spi_buff
+static uint8_t RFM95_spiBatchDepth = 0;	// nested batches
+// The interrupt thread reads packets while the main loop sends, both switch the radio mode and
+// move the FIFO pointer: they take turns on this lock, it may be taken recursively
+static pthread_mutex_t RFM95_mutex;
+static bool RFM95_mutexInitialised = false;
+#define RFM95_LOCK()	(void)pthread_mutex_lock(&RFM95_mutex)		//!< Take the driver lock
+#define RFM95_UNLOCK()	(void)pthread_mutex_unlock(&RFM95_mutex)	//!< Release the driver lock
+#else
+#define RFM95_LOCK()		//!< Packets are read in the main loop, no lock needed
+#define RFM95_UNLOCK()		//!< Packets are read in the main loop, no lock needed
 #endif
 
 LOCAL void RFM95_csn(const bool level)
@@ -53,6 +79,32 @@ LOCAL void RFM95_csn(const bool level)
 #endif
 }
 
+// From here to RFM95_spiBatchEnd() register writes are queued and sent with the next read, or at
+// the end, in a single ioctl. Take the driver lock first, the interrupt thread takes it first too
+LOCAL void RFM95_spiBatchBegin(void)
+{
+#if defined(__linux__)
+	// the transaction is held, no other radio or thread can use the bus until the batch is sent
+	RFM95_SPI.beginTransaction(SPISettings(MY_RFM95_SPI_SPEED, RFM95_SPI_DATA_ORDER,
+	                                       RFM95_SPI_DATA_MODE));
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	RFM95_SPI.chipSelect(MY_RFM95_CS_PIN);
+#endif
+	RFM95_spiBatchDepth++;
+#endif
+}
+
+LOCAL void RFM95_spiBatchEnd(void)
+{
+#if defined(__linux__)
+	if (!--RFM95_spiBatchDepth) {
+		RFM95_SPI.flush();
+		RFM95_spiBatchLength = 0;
+	}
+	RFM95_SPI.endTransaction();
+#endif
+}
+
 LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_t len,
         const bool aReadMode)
 {
@@ -61,13 +113,22 @@ LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 #if !defined(MY_SOFTSPI) && defined(SPI_HAS_TRANSACTION)
 	RFM95_SPI.beginTransaction(SPISettings(MY_RFM95_SPI_SPEED, RFM95_SPI_DATA_ORDER,
 	                                       RFM95_SPI_DATA_MODE));
+#if defined(MY_TRANSPORT_MULTI_RADIO)
+	// the radios share the bus
+	RFM95_SPI.chipSelect(MY_RFM95_CS_PIN);
+#endif
 #endif
 
 	RFM95_csn(LOW);
 #if defined(__linux__)
-	uint8_t *prx = RFM95_spi_rxbuff;
-	uint8_t *ptx = RFM95_spi_txbuff;
 	uint8_t size = len + 1; // Add register value to transmit buffer
+	if (RFM95_spiBatchLength + size > sizeof(RFM95_spi_buff)) {
+		// no room left, send the queued transfers
+		RFM95_SPI.flush();
+		RFM95_spiBatchLength = 0;
+	}
+	uint8_t *prx = &RFM95_spi_buff[RFM95_spiBatchLength];
+	uint8_t *ptx = prx;
 
 	*ptx++ = cmd;
 	while (len--) {
@@ -77,19 +138,27 @@ LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t *buf, uint8_
 			*ptx++ = *current++;
 		}
 	}
-	RFM95_SPI.transfernb((char *)RFM95_spi_txbuff, (char *)RFM95_spi_rxbuff, size);
-	if (aReadMode) {
-		if (size == 2) {
-			status = *++prx;   // result is 2nd byte of receive buffer
-		} else {
-			status = *prx++; // status is 1st byte of receive buffer
-			// decrement before to skip status byte
-			while (--size && (buf != NULL)) {
-				*buf++ = *prx++;
+	RFM95_SPI.queue((char *)prx, (char *)prx, size);
+	if (RFM95_spiBatchDepth && !aReadMode) {
+		// register write of a batch, sent later with the other transfers
+		RFM95_spiBatchLength += size;
+		status = 0;
+	} else {
+		RFM95_SPI.flush();
+		RFM95_spiBatchLength = 0;
+		if (aReadMode) {
+			if (size == 2) {
+				status = *++prx;   // result is 2nd byte of receive buffer
+			} else {
+				status = *prx++; // status is 1st byte of receive buffer
+				// decrement before to skip status byte
+				while (--size && (buf != NULL)) {
+					*buf++ = *prx++;
+				}
 			}
+		} else {
+			status = *prx; // status is 1st byte of receive buffer
 		}
-	} else {
-		status = *prx; // status is 1st byte of receive buffer
 	}
 #else
 	status = RFM95_SPI.transfer(cmd);
@@ -184,7 +253,7 @@ LOCAL bool RFM95_initialise(const uint32_t frequencyHz)
 	// set variables
 	RFM95.address = RFM95_BROADCAST_ADDRESS;
 	RFM95.ackReceived = false;
-	RFM95.dataReceived = false;
+	RFM95.rxLost = 0;
 	RFM95.txSequenceNumber = 0;	// initialise TX sequence counter
 	RFM95.powerLevel = 0;
 	RFM95.ATCenabled = false;
@@ -194,6 +263,16 @@ LOCAL bool RFM95_initialise(const uint32_t frequencyHz)
 #if !defined(__linux__)
 	hwDigitalWrite(MY_RFM95_CS_PIN, HIGH);
 	hwPinMode(MY_RFM95_CS_PIN, OUTPUT);
+#else
+	if (!RFM95_mutexInitialised) {
+		// once, the interrupt thread stays attached when the transport is initialised again
+		pthread_mutexattr_t attr;
+		(void)pthread_mutexattr_init(&attr);
+		(void)pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		(void)pthread_mutex_init(&RFM95_mutex, &attr);
+		(void)pthread_mutexattr_destroy(&attr);
+		RFM95_mutexInitialised = true;
+	}
 #endif
 	RFM95_SPI.begin();
 
@@ -235,44 +314,67 @@ LOCAL bool RFM95_initialise(const uint32_t frequencyHz)
 
 LOCAL void IRQ_HANDLER_ATTR RFM95_interruptHandler(void)
 {
+#if defined(__linux__)
+	// Interrupt thread: read the packet right away, the main loop may be busy sending
+	RFM95_LOCK();
+	RFM95_interruptHandling();
+	RFM95_UNLOCK();
+#else
 	// set flag
 	RFM95_irq = true;
+#endif
 }
 
 // RxDone, TxDone, CADDone is mapped to DI0
 LOCAL void RFM95_interruptHandling(void)
 {
-	// read interrupt register
-	const uint8_t irqFlags = RFM95_readReg(RFM95_REG_12_IRQ_FLAGS);
+	RFM95_spiBatchBegin();
+	// read interrupt register, with FIFO address, length, SNR and RSSI of the latest packet received
+	uint8_t regs[RFM95_REG_1A_PKT_RSSI_VALUE - RFM95_REG_10_FIFO_RX_CURRENT_ADDR + 1];
+	(void)RFM95_burstReadReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR, regs, sizeof(regs));
+	const uint8_t irqFlags = regs[RFM95_REG_12_IRQ_FLAGS - RFM95_REG_10_FIFO_RX_CURRENT_ADDR];
 	if (RFM95.radioMode == RFM95_RADIO_MODE_RX && (irqFlags & RFM95_RX_DONE)) {
 		// RXSingle mode: Radio goes automatically to STDBY after packet received
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
 		// Check CRC flag
 		if (!(irqFlags & RFM95_PAYLOAD_CRC_ERROR)) {
-			const uint8_t bufLen = min(RFM95_readReg(RFM95_REG_13_RX_NB_BYTES), (uint8_t)RFM95_MAX_PACKET_LEN);
+			const uint8_t bufLen = min(regs[RFM95_REG_13_RX_NB_BYTES - RFM95_REG_10_FIFO_RX_CURRENT_ADDR],
+			                           (uint8_t)RFM95_MAX_PACKET_LEN);
 			if (bufLen >= RFM95_HEADER_LEN) {
+				rfm95_packet_t packet;
 				// Reset the fifo read ptr to the beginning of the packet
-				(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, RFM95_readReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR));
-				(void)RFM95_burstReadReg(RFM95_REG_00_FIFO, RFM95.currentPacket.data, bufLen);
-				RFM95.currentPacket.RSSI = static_cast<rfm95_RSSI_t>(RFM95_readReg(
-				                               RFM95_REG_1A_PKT_RSSI_VALUE)); // RSSI of latest packet received
-				RFM95.currentPacket.SNR = static_cast<rfm95_SNR_t>(RFM95_readReg(RFM95_REG_19_PKT_SNR_VALUE));
-				RFM95.currentPacket.payloadLen = bufLen - RFM95_HEADER_LEN;
-				if ((RFM95.currentPacket.header.version >= RFM95_MIN_PACKET_HEADER_VERSION) &&
-				        (RFM95_PROMISCUOUS || RFM95.currentPacket.header.recipient == RFM95.address ||
-				         RFM95.currentPacket.header.recipient == RFM95_BROADCAST_ADDRESS)) {
+				(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, regs[0]);
+				(void)RFM95_burstReadReg(RFM95_REG_00_FIFO, packet.data, bufLen);
+				packet.RSSI = static_cast<rfm95_RSSI_t>(regs[RFM95_REG_1A_PKT_RSSI_VALUE -
+				                                             RFM95_REG_10_FIFO_RX_CURRENT_ADDR]);
+				packet.SNR = static_cast<rfm95_SNR_t>(regs[RFM95_REG_19_PKT_SNR_VALUE -
+				                                           RFM95_REG_10_FIFO_RX_CURRENT_ADDR]);
+				packet.payloadLen = bufLen - RFM95_HEADER_LEN;
+				if ((packet.header.version >= RFM95_MIN_PACKET_HEADER_VERSION) &&
+				        (RFM95_PROMISCUOUS || packet.header.recipient == RFM95.address ||
+				         packet.header.recipient == RFM95_BROADCAST_ADDRESS)) {
 					// Message for us
-					RFM95.ackReceived = RFM95_getACKReceived(RFM95.currentPacket.header.controlFlags) &&
-					                    !RFM95_getACKRequested(RFM95.currentPacket.header.controlFlags);
-					RFM95.dataReceived = !RFM95.ackReceived;
+					if (RFM95_getACKReceived(packet.header.controlFlags) &&
+					        !RFM95_getACKRequested(packet.header.controlFlags)) {
+						RFM95.lastACK.sender = packet.header.sender;
+						RFM95.lastACK.controlFlags = packet.header.controlFlags;
+						RFM95.lastACK.ACK = packet.ACK;
+						RFM95.ackReceived = true;
+					} else if (!RFM95_rxQueue.pushFront(&packet)) {
+						// Queue is full, e.g. the node did not read while waiting for an ACK
+						if (RFM95.rxLost < UINT16_MAX) {
+							RFM95.rxLost++;
+						}
+						RFM95_DEBUG(PSTR("!RFM95:IRH:QUEUE FULL,LOST=%" PRIu16 "\n"), RFM95.rxLost);
+					}
 				}
 			}
 		} else {
 			// CRC error
 			RFM95_DEBUG(PSTR("!RFM95:IRH:CRC ERROR\n"));
-			// FIFO is cleared when switch from STDBY to RX or TX
-			(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 		}
+		// Packet is queued, listen again. FIFO is cleared when switch from STDBY to RX or TX
+		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 	} else if (RFM95.radioMode == RFM95_RADIO_MODE_TX && (irqFlags & RFM95_TX_DONE) ) {
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 	} else if (RFM95.radioMode == RFM95_RADIO_MODE_CAD && (irqFlags & RFM95_CAD_DONE) ) {
@@ -281,6 +383,7 @@ LOCAL void RFM95_interruptHandling(void)
 	}
 	// Clear IRQ flags
 	RFM95_writeReg(RFM95_REG_12_IRQ_FLAGS, RFM95_CLEAR_IRQ);
+	RFM95_spiBatchEnd();
 }
 
 LOCAL void RFM95_handler(void)
@@ -291,33 +394,48 @@ LOCAL void RFM95_handler(void)
 	}
 }
 
+LOCAL rfm95_radioMode_t RFM95_getRadioMode(void)
+{
+	RFM95_handler();
+	RFM95_LOCK();
+	const rfm95_radioMode_t radioMode = RFM95.radioMode;
+	RFM95_UNLOCK();
+	return radioMode;
+}
+
 LOCAL bool RFM95_available(void)
 {
-	if (RFM95.dataReceived) {
-		// data received - we are still in STDBY from IRQ handler
+	if (!RFM95_rxQueue.empty()) {
 		return true;
-	} else if (RFM95.radioMode == RFM95_RADIO_MODE_TX) {
-		return false;
-	} else if (RFM95.radioMode != RFM95_RADIO_MODE_RX) {
-		// we are not in RX, not CAD, and no data received
+	}
+	RFM95_LOCK();
+	if (RFM95.radioMode != RFM95_RADIO_MODE_RX && RFM95.radioMode != RFM95_RADIO_MODE_TX) {
+		// we are not in RX, not TX, and no data received
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 	}
+	RFM95_UNLOCK();
 	return false;
 }
 
 LOCAL uint8_t RFM95_receive(uint8_t *buf, const uint8_t maxBufSize)
 {
-	const uint8_t payloadLen = min(RFM95.currentPacket.payloadLen, maxBufSize);
-	const uint8_t sender = RFM95.currentPacket.header.sender;
-	const rfm95_sequenceNumber_t sequenceNumber = RFM95.currentPacket.header.sequenceNumber;
-	const rfm95_controlFlags_t controlFlags = RFM95.currentPacket.header.controlFlags;
-	const rfm95_RSSI_t RSSI = RFM95.currentPacket.RSSI;
-	const rfm95_SNR_t SNR = RFM95.currentPacket.SNR;
+	rfm95_packet_t *packet = RFM95_rxQueue.getBack();
+	if (packet == NULL) {
+		return 0;
+	}
+	const uint8_t payloadLen = min(packet->payloadLen, maxBufSize);
+	const uint8_t sender = packet->header.sender;
+	const rfm95_sequenceNumber_t sequenceNumber = packet->header.sequenceNumber;
+	const rfm95_controlFlags_t controlFlags = packet->header.controlFlags;
+	const rfm95_RSSI_t RSSI = packet->RSSI;
+	const rfm95_SNR_t SNR = packet->SNR;
 	if (buf != NULL) {
-		(void)memcpy((void *)buf, (void *)&RFM95.currentPacket.payload, payloadLen);
+		(void)memcpy((void *)buf, (void *)&packet->payload, payloadLen);
 	}
-	// clear data flag
-	RFM95.dataReceived = false;
+	// free the slot
+	(void)RFM95_rxQueue.popBack();
+	RFM95.RSSI = RSSI;
+	RFM95.SNR = SNR;
 	// ACK handling
 	if (RFM95_getACKRequested(controlFlags) && !RFM95_getACKReceived(controlFlags)) {
 #if defined(MY_GATEWAY_FEATURE) && (F_CPU>16*1000000ul)
@@ -341,6 +459,8 @@ LOCAL bool RFM95_sendFrame(rfm95_packet_t *packet, const bool increaseSequenceCo
 		RFM95.txSequenceNumber++;
 	}
 	packet->header.sequenceNumber = RFM95.txSequenceNumber;
+	RFM95_LOCK();
+	RFM95_spiBatchBegin();
 	// Position at the beginning of the TX FIFO
 	(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, RFM95_TX_FIFO_ADDR);
 	// write packet
@@ -348,15 +468,18 @@ LOCAL bool RFM95_sendFrame(rfm95_packet_t *packet, const bool increaseSequenceCo
 	(void)RFM95_burstWriteReg(RFM95_REG_00_FIFO, packet->data, finalLen);
 	// total payload length
 	(void)RFM95_writeReg(RFM95_REG_22_PAYLOAD_LENGTH, finalLen);
-	// send message, if sent, irq fires and radio returns to standby
+	// send message, if sent, irq fires and radio returns to RX
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_TX);
+	RFM95_spiBatchEnd();
+	RFM95_UNLOCK();
 	// wait until IRQ fires or timeout
 	const uint32_t startTX_MS = hwMillis();
 	// todo: make this payload length + bit rate dependend
-	while (!RFM95_irq && (hwMillis() - startTX_MS < MY_RFM95_TX_TIMEOUT_MS) ) {
+	while (RFM95_getRadioMode() == RFM95_RADIO_MODE_TX &&
+	        (hwMillis() - startTX_MS < MY_RFM95_TX_TIMEOUT_MS) ) {
 		doYield();
 	}
-	return RFM95_irq;
+	return RFM95_getRadioMode() != RFM95_RADIO_MODE_TX;
 }
 
 LOCAL bool RFM95_send(const uint8_t recipient, uint8_t *data, const uint8_t len,
@@ -440,9 +563,12 @@ LOCAL uint8_t RFM95_getAddress(void)
 
 LOCAL bool RFM95_setRadioMode(const rfm95_radioMode_t newRadioMode)
 {
+	RFM95_LOCK();
 	if (RFM95.radioMode == newRadioMode) {
+		RFM95_UNLOCK();
 		return false;
 	}
+	RFM95_spiBatchBegin();
 	uint8_t regMode;
 
 	if (newRadioMode == RFM95_RADIO_MODE_STDBY) {
@@ -453,8 +579,6 @@ LOCAL bool RFM95_setRadioMode(const rfm95_radioMode_t newRadioMode)
 		regMode = RFM95_MODE_CAD;
 		(void)RFM95_writeReg(RFM95_REG_40_DIO_MAPPING1, 0x80); // Interrupt on CadDone, DIO0
 	} else if (newRadioMode == RFM95_RADIO_MODE_RX) {
-		RFM95.dataReceived = false;
-		RFM95.ackReceived = false;
 		regMode = RFM95_MODE_RXCONTINUOUS;
 		(void)RFM95_writeReg(RFM95_REG_40_DIO_MAPPING1, 0x00); // Interrupt on RxDone, DIO0
 		(void)RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR,
@@ -463,11 +587,15 @@ LOCAL bool RFM95_setRadioMode(const rfm95_radioMode_t newRadioMode)
 		regMode = RFM95_MODE_TX;
 		(void)RFM95_writeReg(RFM95_REG_40_DIO_MAPPING1, 0x40); // Interrupt on TxDone, DIO0
 	} else {
+		RFM95_spiBatchEnd();
+		RFM95_UNLOCK();
 		return false;
 	}
 	(void)RFM95_writeReg(RFM95_REG_01_OP_MODE, regMode);
 
 	RFM95.radioMode = newRadioMode;
+	RFM95_spiBatchEnd();
+	RFM95_UNLOCK();
 	return true;
 }
 
@@ -539,14 +667,17 @@ LOCAL bool RFM95_executeATC(const rfm95_RSSI_t currentRSSI, const rfm95_RSSI_t t
 }
 
 LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
-                               const uint8_t bufferSize, const bool noACK)
+                               const uint8_t bufferSize, const bool noACK, const bool single)
 {
-	for (uint8_t retry = 0; retry < RFM95_RETRIES; retry++) {
+	for (uint8_t retry = 0; retry < (single ? 1u : RFM95_RETRIES); retry++) {
 		RFM95_DEBUG(PSTR("RFM95:SWR:SEND,TO=%" PRIu8 ",SEQ=%" PRIu16 ",RETRY=%" PRIu8 "\n"), recipient,
 		            RFM95.txSequenceNumber,
 		            retry);
 		rfm95_controlFlags_t flags = 0u;
 		RFM95_setACKRequested(flags, !noACK);
+		RFM95_LOCK();
+		RFM95.ackReceived = false;
+		RFM95_UNLOCK();
 		// send packet
 		if (!RFM95_send(recipient, (uint8_t *)buffer, bufferSize, flags, !retry)) {
 			return false;
@@ -556,17 +687,20 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 			return true;
 		}
 		const uint32_t enterMS = hwMillis();
-		while (hwMillis() - enterMS < RFM95_RETRY_TIMEOUT_MS && !RFM95.dataReceived) {
+		// packets arriving meanwhile are queued, keep waiting for the ACK
+		while (hwMillis() - enterMS < RFM95_RETRY_TIMEOUT_MS) {
 			RFM95_handler();
-			if (RFM95.ackReceived) {
-				const uint8_t sender = RFM95.currentPacket.header.sender;
-				const rfm95_sequenceNumber_t ACKsequenceNumber = RFM95.currentPacket.ACK.sequenceNumber;
-				const rfm95_controlFlags_t flag = RFM95.currentPacket.header.controlFlags;
-				const rfm95_RSSI_t RSSI = RFM95.currentPacket.ACK.RSSI;
-				//const rfm95_SNR_t SNR = RFM95.currentPacket.ACK.SNR;
-				RFM95.ackReceived = false;
-				// packet read, back to RX
-				RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
+			RFM95_LOCK();
+			const bool ackReceived = RFM95.ackReceived;
+			const rfm95_lastACK_t lastACK = RFM95.lastACK;
+			RFM95.ackReceived = false;
+			RFM95_UNLOCK();
+			if (ackReceived) {
+				const uint8_t sender = lastACK.sender;
+				const rfm95_sequenceNumber_t ACKsequenceNumber = lastACK.ACK.sequenceNumber;
+				const rfm95_controlFlags_t flag = lastACK.controlFlags;
+				const rfm95_RSSI_t RSSI = lastACK.ACK.RSSI;
+				//const rfm95_SNR_t SNR = lastACK.ACK.SNR;
 				if (sender == recipient &&
 				        (ACKsequenceNumber == RFM95.txSequenceNumber)) {
 					RFM95_DEBUG(PSTR("RFM95:SWR:ACK FROM=%" PRIu8 ",SEQ=%" PRIu16 ",RSSI=%" PRIi16 "\n"),sender,
@@ -583,6 +717,9 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 			doYield();
 		}
 		RFM95_DEBUG(PSTR("!RFM95:SWR:NACK\n"));
+		if (single) {
+			break;
+		}
 		const uint32_t enterCSMAMS = hwMillis();
 		const uint16_t randDelayCSMA = enterMS % 100;
 		while (hwMillis() - enterCSMAMS < randDelayCSMA) {
@@ -600,12 +737,14 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
 LOCAL bool RFM95_waitCAD(void)
 {
 	// receiver needs to be in STDBY before entering CAD mode
+	RFM95_LOCK();
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_CAD);
+	RFM95_UNLOCK();
 	const uint32_t enterMS = hwMillis();
-	while (RFM95.radioMode == RFM95_RADIO_MODE_CAD && (hwMillis() - enterMS < RFM95_CAD_TIMEOUT_MS) ) {
+	while (RFM95_getRadioMode() == RFM95_RADIO_MODE_CAD &&
+	        (hwMillis() - enterMS < RFM95_CAD_TIMEOUT_MS) ) {
 		doYield();
-		RFM95_handler();
 	}
 	return !RFM95.channelActive;
 }
@@ -629,8 +768,8 @@ LOCAL bool RFM95_sanityCheck(void)
 LOCAL int16_t RFM95_getSendingRSSI(void)
 {
 	// own RSSI, as measured by the recipient - ACK part
-	if (RFM95_getACKRSSIReport(RFM95.currentPacket.header.controlFlags)) {
-		return RFM95_internalToRSSI(RFM95.currentPacket.ACK.RSSI);
+	if (RFM95_getACKRSSIReport(RFM95.lastACK.controlFlags)) {
+		return RFM95_internalToRSSI(RFM95.lastACK.ACK.RSSI);
 	} else {
 		// not possible
 		return INVALID_RSSI;
@@ -640,8 +779,8 @@ LOCAL int16_t RFM95_getSendingRSSI(void)
 LOCAL int16_t RFM95_getSendingSNR(void)
 {
 	// own SNR, as measured by the recipient - ACK part
-	if (RFM95_getACKRSSIReport(RFM95.currentPacket.header.controlFlags)) {
-		return static_cast<int16_t>(RFM95_internalToSNR(RFM95.currentPacket.ACK.SNR));
+	if (RFM95_getACKRSSIReport(RFM95.lastACK.controlFlags)) {
+		return static_cast<int16_t>(RFM95_internalToSNR(RFM95.lastACK.ACK.SNR));
 	} else {
 		// not possible
 		return INVALID_SNR;
@@ -651,13 +790,13 @@ LOCAL int16_t RFM95_getSendingSNR(void)
 LOCAL int16_t RFM95_getReceivingRSSI(void)
 {
 	// RSSI from last received packet
-	return static_cast<int16_t>(RFM95_internalToRSSI(RFM95.currentPacket.RSSI));
+	return static_cast<int16_t>(RFM95_internalToRSSI(RFM95.RSSI));
 }
 
 LOCAL int16_t RFM95_getReceivingSNR(void)
 {
 	// SNR from last received packet
-	return static_cast<int16_t>(RFM95_internalToSNR(RFM95.currentPacket.SNR));
+	return static_cast<int16_t>(RFM95_internalToSNR(RFM95.SNR));
 }
 
 LOCAL uint8_t RFM95_getTxPowerLevel(void)
@@ -46,6 +46,7 @@
 * | | RFM95 | INIT | PIN,CS=%%d,IQP=%%d,IQN=%%d[,RST=%%d]   | Pin configuration: chip select (CS), IRQ pin (IQP), IRQ number (IQN), Reset (RST)
 * |!| RFM95 | INIT | SANCHK FAIL                            | Sanity check failed, check wiring or replace module
 * |!| RFM95 | IRH  | CRC FAIL                               | Incoming packet has CRC error, skip
+* |!| RFM95 | IRH  | QUEUE FULL,LOST=%%d                    | RX queue full, packet dropped, packets dropped so far (LOST)
 * | | RFM95 | RCV  | SEND ACK                               | ACK request received, sending ACK back
 * | | RFM95 | PTC  | LEVEL=%%d                              | Set TX power level
 * | | RFM95 | SAC  | SEND ACK,TO=%%d,RSSI=%%d,SNR=%%d       | Send ACK to node (TO), RSSI of received message (RSSI), SNR of message (SNR)
@@ -264,12 +265,24 @@ typedef struct {
 } __attribute__((packed)) rfm95_packet_t;
 
 
+/**
+* @brief Last ACK received
+*/
+typedef struct {
+	uint8_t sender;										//!< ACK sender
+	rfm95_controlFlags_t controlFlags;					//!< Control flags of the ACK
+	rfm95_ack_t ACK;									//!< ACK as sent by the recipient
+} __attribute__((packed)) rfm95_lastACK_t;
+
 /**
 * @brief RFM95 internal variables
 */
 typedef struct {
 	uint8_t address;                          //!< Node address
-	rfm95_packet_t currentPacket;             //!< Buffer for current packet
+	rfm95_lastACK_t lastACK;                  //!< Last ACK received
+	rfm95_RSSI_t RSSI;                        //!< RSSI of the last packet read from the RX queue
+	rfm95_SNR_t SNR;                          //!< SNR of the last packet read from the RX queue
+	uint16_t rxLost;                          //!< Packets dropped because the RX queue was full
 	rfm95_sequenceNumber_t txSequenceNumber;  //!< RFM95_txSequenceNumber
 	rfm95_powerLevel_t powerLevel;            //!< TX power level dBm
 	rfm95_RSSI_t ATCtargetRSSI;               //!< ATC: target RSSI
@@ -278,7 +291,6 @@ typedef struct {
 	bool channelActive : 1;                   //!< RFM95_cad
 	bool ATCenabled : 1;                      //!< ATC enabled
 	bool ackReceived : 1;                     //!< ACK received
-	bool dataReceived : 1;                    //!< Data received
 	bool reserved : 1;                        //!< unused
 } rfm95_internal_t;
 
@@ -403,10 +415,11 @@ LOCAL void RFM95_sendACK(const uint8_t recipient, const rfm95_sequenceNumber_t s
 * @param buffer
 * @param bufferSize
 * @param noACK
+* @param single Send only once, do not retry if no ACK is received
 * @return True if packet successfully sent
 */
 LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void *buffer,
-                               const uint8_t bufferSize, const bool noACK);
+                               const uint8_t bufferSize, const bool noACK, const bool single = false);
 /**
 * @brief Wait until no channel activity detected
 * @return True if no channel activity detected, False if timeout occured
@@ -434,6 +447,11 @@ LOCAL void RFM95_interruptHandling(void);
 */
 LOCAL void RFM95_handler(void);
 /**
+* @brief Radio mode, once pending interrupts are handled
+* @return Current radio mode
+*/
+LOCAL rfm95_radioMode_t RFM95_getRadioMode(void);
+/**
 * @brief RFM95_getSendingRSSI
 * @return RSSI Signal strength of last packet received
 */
@@ -62,18 +62,22 @@
 #define deassertDE() hwDigitalWrite(MY_RS485_DE_PIN, LOW)
 #else
 #define assertDE() hwDigitalWrite(MY_RS485_DE_PIN, LOW); delayMicroseconds(5)
-#define deassertDE() hwDigitalWrite(MY_RS485_DE_PIN, HIG)
+#define deassertDE() hwDigitalWrite(MY_RS485_DE_PIN, HIGH)
 #endif
 #else
 #define assertDE()
 #define deassertDE()
 #endif
 
-// We only use SYS_PACK in this application
+// Frame commands, a message without ACK is a SYS_PACK
 #define	ICSC_SYS_PACK	0x58
+#define RS485_CMD_PACK_ACK	0x60	// Message to acknowledge, the low nibble is a sequence number
+#define RS485_CMD_ACK	0x70		// ACK, the low nibble is the sequence number of the message
+#define RS485_CMD_BEACON	0x42	// Start of a TDMA cycle, sent by the gateway
 
-// Receiving header information
-char _header[6];
+// Receiving header information, the last bytes received in a ring indexed by _headerPos
+char _header[8];
+unsigned char _headerPos;
 
 // Reception state machine control and storage variables
 unsigned char _recPhase;
@@ -88,6 +92,11 @@ unsigned char _recCalcCS;
 
 #if defined(__linux__)
 SerialPort _dev = SerialPort(MY_RS485_HWSERIAL);
+
+// Bytes read from the port in one go and not decoded yet
+uint8_t _rxBuffer[256];
+uint16_t _rxHead;
+uint16_t _rxTail;
 #elif defined(MY_RS485_HWSERIAL)
 HardwareSerial& _dev = MY_RS485_HWSERIAL;
 #else
@@ -96,9 +105,22 @@ AltSoftSerial _dev;
 
 unsigned char _nodeId;
 char _data[MY_RS485_MAX_MESSAGE_LENGTH];
-uint8_t _packet_len;
-unsigned char _packet_from;
-bool _packet_received;
+
+// Received messages not picked up by transportReceive() yet
+#if defined(__linux__)
+#define RS485_RX_QUEUE_SIZE (16u)
+#else
+#define RS485_RX_QUEUE_SIZE (2u)
+#endif
+
+typedef struct {
+	uint8_t len;
+	char data[MY_RS485_MAX_MESSAGE_LENGTH];
+} rs485Packet;
+
+rs485Packet _packets[RS485_RX_QUEUE_SIZE];
+uint8_t _packetHead;
+uint8_t _packetCount;
 
 // Packet wrapping characters, defined in standard ASCII table
 #define SOH 1
@@ -106,6 +128,66 @@ bool _packet_received;
 #define ETX 3
 #define EOT 4
 
+// Frame: SOHs, destination, source, command, length, STX, data, ETX, checksum, EOT
+#define RS485_FRAME_BYTES(len) (MY_RS485_SOH_COUNT + 8 + (len))
+#define RS485_FRAME_SIZE RS485_FRAME_BYTES(MAX_MESSAGE_SIZE)
+
+// Transmission time of a number of bytes in microseconds, 10 bits per byte
+#define RS485_BYTES_US(bytes) ((uint32_t)(bytes) * 10000000ul / MY_RS485_BAUD_RATE)
+// The bus is idle after this many byte times without traffic
+#define RS485_IDLE_BYTES (4u)
+// Backoff steps of one byte time after the bus went idle, see _busWait()
+#define RS485_BACKOFF_SLOTS (16u)
+// Give up sending if the bus does not become idle in this time
+#define RS485_BUS_TIMEOUT_MS (250u)
+
+// Bus state: time of the last traffic, how long the bus stays busy after it (our own frame
+// still going out) and whether we sent last
+uint32_t _busActivity;
+uint32_t _busHold;
+bool _busYield;
+
+#if defined(MY_RS485_ACK)
+// Sequence numbers count per destination, two per byte, so the next frame to a node never
+// carries the number of the last one it got from us
+uint8_t _txSeq[128];
+uint8_t _ackFrom;
+uint8_t _ackSeq;
+bool _ackReceived;
+// Last sequence number received per sender, a retransmitted frame whose ACK got lost has the
+// same one and is acknowledged but not delivered again
+#if defined(__linux__)
+uint8_t _rxSeq[256];
+#else
+#define RS485_DUPLICATE_CACHE_SIZE (4u)
+uint8_t _dupSender[RS485_DUPLICATE_CACHE_SIZE];
+uint8_t _dupSeq[RS485_DUPLICATE_CACHE_SIZE];
+uint8_t _dupPos;
+#endif
+#if defined(__linux__)
+// Frames per destination that were not acknowledged despite all retries, since the last ACK
+uint8_t _txFailures[256];
+#endif
+#endif
+
+#if defined(MY_RS485_TDMA_SLOTS)
+#if MY_RS485_TDMA_SLOTS < 2
+#error MY_RS485_TDMA_SLOTS must be at least 2
+#endif
+#if MY_RS485_TDMA_GATEWAY_SLOTS < 1 || MY_RS485_TDMA_GATEWAY_SLOTS >= MY_RS485_TDMA_SLOTS
+#error MY_RS485_TDMA_GATEWAY_SLOTS must be at least 1 and less than MY_RS485_TDMA_SLOTS
+#endif
+#define RS485_TDMA_CYCLE_US ((uint32_t)(MY_RS485_TDMA_SLOTS) * (MY_RS485_TDMA_SLOT_US))
+// The gateway slots are spread over the cycle, every RS485_TDMA_GATEWAY_STRIDE slots one
+#define RS485_TDMA_GATEWAY_STRIDE ((MY_RS485_TDMA_SLOTS) / (MY_RS485_TDMA_GATEWAY_SLOTS))
+// A node falls back to waiting for an idle bus after this many cycles without beacon
+#define RS485_TDMA_SYNC_CYCLES (3u)
+
+// Start of the current cycle: beacon sent by the gateway, beacon received by a node
+uint32_t _tdmaCycleStart;
+bool _tdmaSynced;
+#endif
+
 
 
 //Reset the state machine and release the data pointer
@@ -119,183 +201,50 @@ void _serialReset()
 	_recCalcCS = 0;
 }
 
-// This is the main reception state machine.  Progress through the states
-// is keyed on either special control characters, or counted number of bytes
-// received.  If all the data is in the right format, and the calculated
-// checksum matches the received checksum, AND the destination station is
-// our station ID, then look for a registered command that matches the
-// command code.  If all the above is true, execute the command's
-// function.
-bool _serialProcess()
+// Note traffic on the bus
+void _busSeen(void)
 {
-	unsigned char i;
-	if (!_dev.available()) {
-		return false;
-	}
-
-	while(_dev.available()) {
-		char inch;
-		inch = _dev.read();
-
-		switch(_recPhase) {
-
-		// Case 0 looks for the header.  Bytes arrive in the serial interface and get
-		// shifted through a header buffer.  When the start and end characters in
-		// the buffer match the SOH/STX pair, and the destination station ID matches
-		// our ID, save the header information and progress to the next state.
-		case 0:
-			memcpy(&_header[0],&_header[1],5);
-			_header[5] = inch;
-			if ((_header[0] == SOH) && (_header[5] == STX) && (_header[1] != _header[2])) {
-				_recCalcCS = 0;
-				_recStation = _header[1];
-				_recSender = _header[2];
-				_recCommand = _header[3];
-				_recLen = _header[4];
-
-				for (i=1; i<=4; i++) {
-					_recCalcCS += _header[i];
-				}
-				_recPhase = 1;
-				_recPos = 0;
-
-				//Avoid _data[] overflow
-				if (_recLen >= MY_RS485_MAX_MESSAGE_LENGTH) {
-					_serialReset();
-					break;
-				}
-
-				//Check if we should process this message
-				//We reject the message if we are the sender
-				//We reject if we are not the receiver and message is not a broadcast
-				if ((_recSender == _nodeId) ||
-				        (_recStation != _nodeId &&
-				         _recStation != BROADCAST_ADDRESS)) {
-					_serialReset();
-					break;
-				}
-
-				if (_recLen == 0) {
-					_recPhase = 2;
-				}
-
-			}
-			break;
-
-		// Case 1 receives the data portion of the packet.  Read in "_recLen" number
-		// of bytes and store them in the _data array.
-		case 1:
-			_data[_recPos++] = inch;
-			_recCalcCS += inch;
-			if (_recPos == _recLen) {
-				_recPhase = 2;
-			}
-			break;
-
-		// After the data comes a single ETX character.  Do we have it?  If not,
-		// reset the state machine to default and start looking for a new header.
-		case 2:
-			// Packet properly terminated?
-			if (inch == ETX) {
-				_recPhase = 3;
-			} else {
-				_serialReset();
-			}
-			break;
-
-		// Next comes the checksum.  We have already calculated it from the incoming
-		// data, so just store the incoming checksum byte for later.
-		case 3:
-			_recCS = inch;
-			_recPhase = 4;
-			break;
-
-		// The final state - check the last character is EOT and that the checksum matches.
-		// If that test passes, then look for a valid command callback to execute.
-		// Execute it if found.
-		case 4:
-			if (inch == EOT) {
-				if (_recCS == _recCalcCS) {
-					// First, check for system level commands.  It is possible
-					// to register your own callback as well for system level
-					// commands which will be called after the system default
-					// hook.
-
-					switch (_recCommand) {
-					case ICSC_SYS_PACK:
-						_packet_from = _recSender;
-						_packet_len = _recLen;
-						_packet_received = true;
-						break;
-					}
-				}
-			}
-			//Clear the data
-			_serialReset();
-			//Return true, we have processed one command
-			return true;
-			break;
-		}
-	}
-	return true;
+	_busActivity = micros();
+	_busHold = 0;
 }
 
-bool transportSend(const uint8_t to, const void* data, const uint8_t len, const bool noACK)
+// Send a frame, the caller has checked that the bus is ours
+void _serialWrite(const uint8_t to, const uint8_t command, const void* data, const uint8_t len)
 {
-	(void)noACK;	// not implemented
-	const char *datap = static_cast<char const *>(data);
+	const uint8_t *datap = static_cast<const uint8_t *>(data);
 	unsigned char i;
 	unsigned char cs = 0;
 
-	// This is how many times to try and transmit before failing.
-	unsigned char timeout = 10;
-
-	// Let's start out by looking for a collision.  If there has been anything seen in
-	// the last millisecond, then wait for a random time and check again.
-
-	while (_serialProcess()) {
-		unsigned char del;
-		del = rand() % 20;
-		for (i = 0; i < del; i++) {
-			delay(1);
-			_serialProcess();
-		}
-		timeout--;
-		if (timeout == 0) {
-			// Failed to transmit!!!
-			return false;
-		}
-	}
-
-#if defined(MY_RS485_DE_PIN)
-#if !defined(MY_RS485_DE_INVERSE)
-	hwDigitalWrite(MY_RS485_DE_PIN, HIGH);
-#else
-	hwDigitalWrite(MY_RS485_DE_PIN, LOW);
-#endif
-	delayMicroseconds(5);
-#endif
-
+	// Build the whole frame first, it then goes out in a single write while DE is asserted
+	uint8_t frame[RS485_FRAME_SIZE];
+	uint8_t pos = 0;
 	// Start of header by writing multiple SOH
 	for(byte w=0; w<MY_RS485_SOH_COUNT; w++) {
-		_dev.write(SOH);
+		frame[pos++] = SOH;
 	}
-	_dev.write(to);  // Destination address
+	frame[pos++] = to;  // Destination address
 	cs += to;
-	_dev.write(_nodeId); // Source address
+	frame[pos++] = _nodeId; // Source address
 	cs += _nodeId;
-	_dev.write(ICSC_SYS_PACK);  // Command code
-	cs += ICSC_SYS_PACK;
-	_dev.write(len);      // Length of text
+	frame[pos++] = command;  // Command code
+	cs += command;
+	frame[pos++] = len;      // Length of text
 	cs += len;
-	_dev.write(STX);      // Start of text
+	frame[pos++] = STX;      // Start of text
 	for(i=0; i<len; i++) {
-		_dev.write(datap[i]);      // Text bytes
+		frame[pos++] = datap[i];      // Text bytes
 		cs += datap[i];
 	}
-	_dev.write(ETX);      // End of text
-	_dev.write(cs);
-	_dev.write(EOT);
+	frame[pos++] = ETX;      // End of text
+	frame[pos++] = cs;
+	frame[pos++] = EOT;
+
+	assertDE();
+	(void)_dev.write(frame, pos);
+	// Without DE the frame may still be going out
+	_busActivity = micros();
+	_busHold = RS485_BYTES_US(pos);
+	_busYield = true;
 
 #if defined(MY_RS485_DE_PIN)
 #ifdef __PIC32MX__
@@ -318,15 +267,394 @@ bool transportSend(const uint8_t to, const void* data, const uint8_t len, const
 	_dev.flush();
 #endif
 #endif
-#if !defined(MY_RS485_DE_INVERSE)
-	hwDigitalWrite(MY_RS485_DE_PIN, LOW);
+#endif
+	deassertDE();
+}
+
+// Store the message just received for transportReceive()
+bool _serialQueue(void)
+{
+	if (_packetCount == RS485_RX_QUEUE_SIZE) {
+		return false;
+	}
+	rs485Packet *packet = &_packets[(_packetHead + _packetCount) % RS485_RX_QUEUE_SIZE];
+	packet->len = _recLen;
+	(void)memcpy(packet->data, _data, _recLen);
+	_packetCount++;
+	return true;
+}
+
+#if defined(MY_RS485_ACK)
+// Last sequence number received from a sender, 0xFF if none
+uint8_t *_serialLastSeq(const uint8_t sender)
+{
+#if defined(__linux__)
+	return &_rxSeq[sender];
 #else
-	hwDigitalWrite(MY_RS485_DE_PIN, HIGH);
+	for (uint8_t i = 0; i < RS485_DUPLICATE_CACHE_SIZE; i++) {
+		if (_dupSender[i] == sender) {
+			return &_dupSeq[i];
+		}
+	}
+	// Replace the sender added first
+	uint8_t *seq = &_dupSeq[_dupPos];
+	_dupSender[_dupPos] = sender;
+	*seq = 0xFF;
+	_dupPos = (_dupPos + 1) % RS485_DUPLICATE_CACHE_SIZE;
+	return seq;
+#endif
+}
+#endif
+
+// Handle a complete frame with a valid checksum
+void _serialFrame(void)
+{
+	if (_recCommand == ICSC_SYS_PACK) {
+		(void)_serialQueue();
+		return;
+	}
+#if defined(MY_RS485_ACK)
+	const uint8_t seq = _recCommand & 0x0F;
+	if ((_recCommand & 0xF0) == RS485_CMD_PACK_ACK) {
+		uint8_t *lastSeq = _serialLastSeq(_recSender);
+		if (*lastSeq != seq) {
+			// Without room the frame is not acknowledged, the sender tries again
+			if (!_serialQueue()) {
+				return;
+			}
+			*lastSeq = seq;
+		}
+		if (_recStation == _nodeId) {
+			// The sender keeps the bus for the ACK
+			_serialWrite(_recSender, RS485_CMD_ACK | seq, NULL, 0);
+		}
+		return;
+	}
+	if ((_recCommand & 0xF0) == RS485_CMD_ACK) {
+		if (_recSender == _ackFrom && seq == _ackSeq) {
+			_ackReceived = true;
+		}
+		return;
+	}
+#endif
+#if defined(MY_RS485_TDMA_SLOTS)
+	if (_recCommand == RS485_CMD_BEACON && _recSender == GATEWAY_ADDRESS) {
+		// Cycles start when the gateway starts sending the beacon
+		_tdmaCycleStart = micros() - RS485_BYTES_US(RS485_FRAME_BYTES(0));
+		_tdmaSynced = true;
+	}
+#endif
+}
+
+// This is the main reception state machine.  Progress through the states
+// is keyed on either special control characters, or counted number of bytes
+// received.  If all the data is in the right format, and the calculated
+// checksum matches the received checksum, AND the destination station is
+// our station ID, then look for a registered command that matches the
+// command code.  If all the above is true, execute the command's
+// function.
+void _serialDecode(const char inch)
+{
+	switch(_recPhase) {
+
+	// Case 0 looks for the header.  Bytes arrive in the serial interface and get
+	// stored in a ring of header bytes.  When an STX arrives 5 bytes after an SOH,
+	// and the destination station ID matches our ID, save the header information
+	// and progress to the next state.
+	case 0:
+		_header[_headerPos++ & 7] = inch;
+		if ((inch == STX) && (_header[(_headerPos - 6) & 7] == SOH)) {
+			_recStation = _header[(_headerPos - 5) & 7];
+			_recSender = _header[(_headerPos - 4) & 7];
+			_recCommand = _header[(_headerPos - 3) & 7];
+			_recLen = _header[(_headerPos - 2) & 7];
+			if (_recStation == _recSender) {
+				break;
+			}
+			// Another node got the bus, we no longer need to let it go first
+			if (_recSender != _nodeId && (_recCommand & 0xF0) != RS485_CMD_ACK) {
+				_busYield = false;
+			}
+			_recCalcCS = _recStation + _recSender + _recCommand + _recLen;
+			_recPhase = 1;
+			_recPos = 0;
+
+			//Avoid _data[] overflow
+			if (_recLen >= MY_RS485_MAX_MESSAGE_LENGTH) {
+				_serialReset();
+				break;
+			}
+
+			//Check if we should process this message
+			//We reject the message if we are the sender
+			//We reject if we are not the receiver and message is not a broadcast
+			if ((_recSender == _nodeId) ||
+			        (_recStation != _nodeId &&
+			         _recStation != BROADCAST_ADDRESS)) {
+				_serialReset();
+				break;
+			}
+
+			if (_recLen == 0) {
+				_recPhase = 2;
+			}
+
+		}
+		break;
+
+	// Case 1 receives the data portion of the packet.  Read in "_recLen" number
+	// of bytes and store them in the _data array.
+	case 1:
+		_data[_recPos++] = inch;
+		_recCalcCS += inch;
+		if (_recPos == _recLen) {
+			_recPhase = 2;
+		}
+		break;
+
+	// After the data comes a single ETX character.  Do we have it?  If not,
+	// reset the state machine to default and start looking for a new header.
+	case 2:
+		// Packet properly terminated?
+		if (inch == ETX) {
+			_recPhase = 3;
+		} else {
+			_serialReset();
+		}
+		break;
+
+	// Next comes the checksum.  We have already calculated it from the incoming
+	// data, so just store the incoming checksum byte for later.
+	case 3:
+		_recCS = inch;
+		_recPhase = 4;
+		break;
+
+	// The final state - check the last character is EOT and that the checksum matches.
+	// If that test passes, then look for a valid command callback to execute.
+	// Execute it if found.
+	case 4:
+		if (inch == EOT && _recCS == _recCalcCS) {
+			_serialFrame();
+		}
+		//Clear the data
+		_serialReset();
+		break;
+	}
+}
+
+// Decode what was received. Decoding stops when the queue is full, the rest waits in the
+// serial buffer, unless everything is wanted to see ACKs and bus traffic while sending.
+void _serialProcess(const bool all = false)
+{
+#if defined(__linux__)
+	for (;;) {
+		if (_rxHead == _rxTail) {
+			// One read() per chunk instead of one per byte
+			const int len = _dev.read(_rxBuffer, sizeof(_rxBuffer));
+			if (len <= 0) {
+				return;
+			}
+			_busSeen();
+			_rxHead = 0;
+			_rxTail = len;
+		}
+		while (_rxHead != _rxTail) {
+			if (!all && _packetCount == RS485_RX_QUEUE_SIZE) {
+				return;
+			}
+			_serialDecode(_rxBuffer[_rxHead++]);
+		}
+	}
+#else
+	while (_dev.available() && (all || _packetCount < RS485_RX_QUEUE_SIZE)) {
+		_busSeen();
+		_serialDecode(_dev.read());
+	}
+#endif
+}
+
+// Wait for the bus to be idle. Then every node waits a random number of byte times, drawn anew
+// for each frame, before it sends, and a node that sent last waits until all others had their
+// turn. Two nodes only collide if they draw the same backoff, and not again on the next frame.
+bool _busWait(void)
+{
+	const uint32_t start = millis();
+	const uint8_t backoff = random(RS485_BACKOFF_SLOTS);
+	for (;;) {
+		_serialProcess(true);
+		const uint32_t gap = _busHold + RS485_BYTES_US(RS485_IDLE_BYTES + backoff +
+		                     (_busYield ? RS485_BACKOFF_SLOTS : 0u));
+		if ((uint32_t)(micros() - _busActivity) >= gap) {
+			return true;
+		}
+		if (millis() - start > RS485_BUS_TIMEOUT_MS) {
+			return false;
+		}
+		delayMicroseconds(RS485_BYTES_US(1));
+	}
+}
+
+#if defined(MY_RS485_TDMA_SLOTS)
+// The gateway sends a beacon when a cycle is over, a node notices that the beacons stopped
+void _tdmaPoll(void)
+{
+	uint32_t elapsed = (uint32_t)(micros() - _tdmaCycleStart);
+	if (_nodeId == GATEWAY_ADDRESS) {
+		if (elapsed >= RS485_TDMA_CYCLE_US) {
+			// The last slot is over, nobody else may send now
+			_tdmaCycleStart = micros();
+			_serialWrite(BROADCAST_ADDRESS, RS485_CMD_BEACON, NULL, 0);
+			elapsed = 0;
+		}
+		_tdmaSynced = true;
+#if defined(__linux__)
+		eventLoopWakeupIn((RS485_TDMA_CYCLE_US - elapsed) / 1000u);
+#endif
+	} else if (elapsed > RS485_TDMA_SYNC_CYCLES * RS485_TDMA_CYCLE_US) {
+		_tdmaSynced = false;
+	}
+}
+
+// Whether a slot of the cycle is ours
+bool _tdmaOwnSlot(const uint8_t slot)
+{
+	const bool gatewaySlot = slot % RS485_TDMA_GATEWAY_STRIDE == 0 &&
+	                         slot / RS485_TDMA_GATEWAY_STRIDE < (MY_RS485_TDMA_GATEWAY_SLOTS);
+	if (_nodeId == GATEWAY_ADDRESS || gatewaySlot) {
+		return _nodeId == GATEWAY_ADDRESS && gatewaySlot;
+	}
+	// Number the node slots, skipping those of the gateway
+	const uint8_t gatewaySlots = (slot < RS485_TDMA_GATEWAY_STRIDE * (MY_RS485_TDMA_GATEWAY_SLOTS)) ?
+	                             slot / RS485_TDMA_GATEWAY_STRIDE + 1u : (MY_RS485_TDMA_GATEWAY_SLOTS);
+	return (uint8_t)(slot - gatewaySlots) == (_nodeId - 1u) % (MY_RS485_TDMA_SLOTS -
+	        (MY_RS485_TDMA_GATEWAY_SLOTS));
+}
+
+// Wait until a frame that takes the bus for the given time fits into one of our slots
+bool _tdmaWait(const uint32_t busTime)
+{
+	const uint32_t start = millis();
+	for (;;) {
+		_serialProcess(true);
+		_tdmaPoll();
+		if (!_tdmaSynced) {
+			return _busWait();
+		}
+		const uint32_t position = (uint32_t)(micros() - _tdmaCycleStart) % RS485_TDMA_CYCLE_US;
+		if (_tdmaOwnSlot(position / (MY_RS485_TDMA_SLOT_US)) &&
+		        position % (MY_RS485_TDMA_SLOT_US) + busTime <= (MY_RS485_TDMA_SLOT_US)) {
+			return true;
+		}
+		if (millis() - start > 2u * RS485_TDMA_CYCLE_US / 1000u) {
+			return false;
+		}
+		delayMicroseconds(RS485_BYTES_US(1));
+	}
+}
+#endif
+
+// Wait until we may take the bus for the given time
+bool _busAcquire(const uint32_t busTime)
+{
+#if defined(MY_RS485_TDMA_SLOTS)
+	// Without ID the slot is not ours yet
+	if (_tdmaSynced && _nodeId != AUTO) {
+		return _tdmaWait(busTime);
+	}
+#endif
+	(void)busTime;
+	return _busWait();
+}
+
+#if defined(MY_RS485_ACK)
+bool _serialWaitAck(void)
+{
+	const uint32_t start = micros();
+	const uint32_t timeout = _busHold + MY_RS485_ACK_TIMEOUT_US;
+	while (!_ackReceived && (uint32_t)(micros() - start) < timeout) {
+		delayMicroseconds(RS485_BYTES_US(1));
+		_serialProcess(true);
+	}
+	_ackSeq = 0xFF;
+	return _ackReceived;
+}
+
+// Next sequence number for a destination
+uint8_t _serialNextSeq(const uint8_t to)
+{
+	const uint8_t shift = (to & 1u) ? 4u : 0u;
+	uint8_t *seqs = &_txSeq[to >> 1];
+	const uint8_t seq = (*seqs >> shift) & 0x0F;
+	*seqs = (*seqs & ~(0x0F << shift)) | (((seq + 1u) & 0x0F) << shift);
+	return seq;
+}
+
+bool _serialSendAck(const uint8_t to, const void* data, const uint8_t len, const bool single)
+{
+	const uint8_t seq = _serialNextSeq(to);
+#if defined(__linux__)
+	// A destination that missed all ACKs of an earlier frame only gets one try, until it answers
+	uint8_t attempts = (single || _txFailures[to]) ? 1u : 1u + MY_RS485_ACK_RETRIES;
+#else
+	uint8_t attempts = single ? 1u : 1u + MY_RS485_ACK_RETRIES;
+#endif
+	while (attempts--) {
+		if (!_busAcquire(RS485_BYTES_US(RS485_FRAME_BYTES(len)) + MY_RS485_ACK_TIMEOUT_US)) {
+			break;
+		}
+		_ackFrom = to;
+		_ackSeq = seq;
+		_ackReceived = false;
+		_serialWrite(to, RS485_CMD_PACK_ACK | seq, data, len);
+		if (_serialWaitAck()) {
+#if defined(__linux__)
+			_txFailures[to] = 0;
 #endif
+			return true;
+		}
+	}
+#if defined(__linux__)
+	if (_txFailures[to] < 255) {
+		_txFailures[to]++;
+	}
 #endif
+	return false;
+}
+#endif
+
+bool _serialSend(const uint8_t to, const void* data, const uint8_t len, const bool noACK,
+                 const bool single)
+{
+	if (len > MAX_MESSAGE_SIZE) {
+		return false;
+	}
+#if defined(MY_RS485_ACK)
+	if (!noACK && to != BROADCAST_ADDRESS) {
+		return _serialSendAck(to, data, len, single);
+	}
+#else
+	(void)noACK;	// frames are not acknowledged
+	(void)single;
+#endif
+	if (!_busAcquire(RS485_BYTES_US(RS485_FRAME_BYTES(len)))) {
+		// Failed to transmit!!!
+		return false;
+	}
+	_serialWrite(to, ICSC_SYS_PACK, data, len);
 	return true;
 }
 
+bool transportSend(const uint8_t to, const void* data, const uint8_t len, const bool noACK)
+{
+	return _serialSend(to, data, len, noACK, false);
+}
+
+bool transportSendOnce(const uint8_t to, const void* data, const uint8_t len, const bool noACK)
+{
+	return _serialSend(to, data, len, noACK, true);
+}
+
 
 
 bool transportInit(void)
@@ -334,6 +662,27 @@ bool transportInit(void)
 	// Reset the state machine
 	_dev.begin(MY_RS485_BAUD_RATE);
 	_serialReset();
+	_packetHead = 0;
+	_packetCount = 0;
+#if defined(__linux__)
+	_rxHead = _rxTail = 0;
+#endif
+	_busSeen();
+#if defined(MY_RS485_ACK)
+	// Start with other sequence numbers than before a reset
+	(void)memset(_txSeq, (uint8_t)micros(), sizeof(_txSeq));
+	_ackSeq = 0xFF;
+#if defined(__linux__)
+	(void)memset(_rxSeq, 0xFF, sizeof(_rxSeq));
+#else
+	(void)memset(_dupSeq, 0xFF, sizeof(_dupSeq));
+#endif
+#endif
+#if defined(MY_RS485_TDMA_SLOTS)
+	// The gateway sends the first beacon right away
+	_tdmaCycleStart = micros() - RS485_TDMA_CYCLE_US;
+	_tdmaSynced = false;
+#endif
 #if defined(MY_RS485_DE_PIN)
 	hwPinMode(MY_RS485_DE_PIN, OUTPUT);
 #if !defined(MY_RS485_DE_INVERSE)
@@ -359,7 +708,10 @@ uint8_t transportGetAddress(void)
 bool transportDataAvailable(void)
 {
 	_serialProcess();
-	return _packet_received;
+#if defined(MY_RS485_TDMA_SLOTS)
+	_tdmaPoll();
+#endif
+	return _packetCount > 0;
 }
 
 bool transportSanityCheck(void)
@@ -370,13 +722,15 @@ bool transportSanityCheck(void)
 
 uint8_t transportReceive(void* data)
 {
-	if (_packet_received) {
-		memcpy(data,_data,_packet_len);
-		_packet_received = false;
-		return _packet_len;
-	} else {
+	if (!_packetCount) {
 		return (0);
 	}
+	const rs485Packet *packet = &_packets[_packetHead];
+	const uint8_t len = packet->len;
+	memcpy(data, packet->data, len);
+	_packetHead = (_packetHead + 1) % RS485_RX_QUEUE_SIZE;
+	_packetCount--;
+	return len;
 }
 
 void transportPowerDown(void)